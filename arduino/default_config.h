@@ -20,6 +20,9 @@
 #define DEBUG_ATEM        0
 #define DEBUG_DNS         DEBUG
 
+// Milliseconds without any packet before reconnecting, set to 5000 to match official clients
+// #define ATEM_LIVENESS_TIMEOUT_MS 1500
+
 // Pins to use for PGM tally, PVW tally and/or ATEM connection indicator LEDs
 #ifdef ESP8266
 #define PIN_PGM           D5
@@ -1,9 +1,10 @@
 #include <stdint.h> // uint8_t, uint16_t, uint32_t
 #include <stdbool.h> // bool, false
 #include <stddef.h> // NULL
-#include <assert.h> // assert
+#include <assert.h> // assert, _Static_assert
+#include <string.h> // memcpy
 
-#include "./atem_protocol.h" // ATEM_LEN_SYN, ATEM_INDEX_FLAGS, ATEM_INDEX_LEN_HIGH, ATEM_INDEX_LEN_LOW, ATEM_INDEX_SESSIONID_HIGH, ATEM_INDEX_SESSIONID_LOW, ATEM_FLAG_SYN, ATEM_INDEX_OPCODE, ATEM_OPCODE_OPEN, ATEM_FLAG_ACK, ATEM_FLAG_RETX, ATEM_OPCODE_CLOSING, ATEM_OPCODE_CLOSED, ATEM_FLAG_ACKREQ, ATEM_INDEX_REMOTEID_HIGH, ATEM_INDEX_REMOTEID_LOW, ATEM_LIMIT_REMOTEID, ATEM_INDEX_ACKID_HIGH, ATEM_INDEX_ACKID_LOW, ATEM_MASK_LEN_HIGH, ATEM_LEN_HEADER, ATEM_OPCODE_ACCEPT, ATEM_OPCODE_REJECT, ATEM_LEN_CMDHEADER, ATEM_OFFSET_CMDNAME
+#include "./atem_protocol.h" // ATEM_RESEND_TIME, ATEM_INDEX_UNKNOWNID_HIGH, ATEM_INDEX_UNKNOWNID_LOW, ATEM_LEN_SYN, ATEM_INDEX_FLAGS, ATEM_INDEX_LEN_HIGH, ATEM_INDEX_LEN_LOW, ATEM_INDEX_SESSIONID_HIGH, ATEM_INDEX_SESSIONID_LOW, ATEM_FLAG_SYN, ATEM_INDEX_OPCODE, ATEM_OPCODE_OPEN, ATEM_FLAG_ACK, ATEM_FLAG_RETX, ATEM_OPCODE_CLOSING, ATEM_OPCODE_CLOSED, ATEM_FLAG_ACKREQ, ATEM_INDEX_REMOTEID_HIGH, ATEM_INDEX_REMOTEID_LOW, ATEM_LIMIT_REMOTEID, ATEM_INDEX_ACKID_HIGH, ATEM_INDEX_ACKID_LOW, ATEM_MASK_LEN_HIGH, ATEM_LEN_HEADER, ATEM_OPCODE_ACCEPT, ATEM_OPCODE_REJECT, ATEM_LEN_CMDHEADER, ATEM_OFFSET_CMDNAME, ATEM_INDEX_CC_DEST, ATEM_INDEX_CC_CATEGORY, ATEM_INDEX_CC_PARAMETER, ATEM_INDEX_CC_TYPE, ATEM_INDEX_CC_OPERATION, ATEM_INDEX_CC_COUNT8, ATEM_INDEX_CC_COUNT16, ATEM_INDEX_CC_COUNT32, ATEM_OFFSET_CC_DATA, ATEM_CC_OPERATION_ASSIGN
 #include "./atem.h" // struct atem, enum atem_status, ATEM_STATUS_CLOSED, ATEM_STATUS_WRITE_ONLY, ATEM_STATUS_WRITE, ATEM_STATUS_NONE, ATEM_STATUS_ACCEPTED, ATEM_STATUS_CLOSING, ATEM_STATUS_REJECTED, ATEM_STATUS_ERROR
 
 
@@ -19,14 +20,21 @@
 // Offset for when using tally index as command index
 #define TALLY_OFFSET 1
 
-// Atem and camera control protocol lengths and offsets
+// Masks and multiplier for packing tally flags of 4 inputs in a 32 bit word into 4 bits
+#define TALLY_SWAR_MASK 0x01010101u
+#define TALLY_SWAR_PACK 0x01020408u
+#define TALLY_SWAR_SHIFT 24
+
+// Mask for detecting bytes in a 32 bit word that are zero without carrying into neighbouring bytes
+#define TALLY_SWAR_LOW7 0x7f7f7f7fu
+
+// Blackmagic SDI camera control protocol lengths and offset from ATEM camera control payload
 #define CC_HEADER_LEN 4
 #define CC_CMD_HEADER_LEN 4
 #define CC_HEADER_OFFSET -3
-#define CC_ATEM_DATA_OFFSET 16
 
 // Makes static buffers thread safe if ATEM_THREAD_SAFE is set using thread_local or ATEM_THREAD_LOCAL if defined
-#if !ATEM_THREAD_SAFE
+#if !ATEM_THREAD_SAFE || ATEM_WRITE_BUF_CONTEXT
 #define thread_local
 #elif defined(ATEM_THREAD_LOCAL)
 #define thread_local ATEM_THREAD_LOCAL
@@ -36,55 +44,176 @@
 
 
 
+// Uses response buffers owned by the context if ATEM_WRITE_BUF_CONTEXT is set, otherwise shared static buffers
+#if ATEM_WRITE_BUF_CONTEXT
+_Static_assert(sizeof(((struct atem*)NULL)->write_bufs.open) == ATEM_LEN_SYN, "Open buffer has to fit SYN packet");
+_Static_assert(sizeof(((struct atem*)NULL)->write_bufs.close) == ATEM_LEN_SYN, "Close buffer has to fit SYN packet");
+_Static_assert(sizeof(((struct atem*)NULL)->write_bufs.ack) == ATEM_LEN_HEADER, "ACK buffer has to fit header");
+_Static_assert(sizeof(((struct atem*)NULL)->write_bufs.retxreq) == ATEM_LEN_HEADER, "RETX request buffer has to fit header");
+#define buf_open (atem->write_bufs.open)
+#define buf_ack (atem->write_bufs.ack)
+#define buf_close (atem->write_bufs.close)
+#define buf_retxreq (atem->write_bufs.retxreq)
+#else // ATEM_WRITE_BUF_CONTEXT
+
 // Buffer to send to ATEM when establishing connection
-static thread_local uint8_t buf_open[ATEM_LEN_SYN] = {
-	[ATEM_INDEX_LEN_LOW] = ATEM_LEN_SYN,
-	[ATEM_INDEX_SESSIONID_HIGH] = 0x13,
-	[ATEM_INDEX_SESSIONID_LOW] = 0x37,
-	[ATEM_INDEX_OPCODE] = ATEM_OPCODE_OPEN
-};
+static thread_local uint8_t buf_open[ATEM_LEN_SYN];
 
 // Buffer to modify and send to ATEM when acknowledging a received packet
-static thread_local uint8_t buf_ack[ATEM_LEN_HEADER] = {
-	[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACK,
-	[ATEM_INDEX_LEN_LOW] = ATEM_LEN_HEADER
-};
+static thread_local uint8_t buf_ack[ATEM_LEN_HEADER];
 
 // Buffer to modify and send to ATEM to close the connection or respond to closing request
-static thread_local uint8_t buf_close[ATEM_LEN_SYN] = {
-	[ATEM_INDEX_LEN_LOW] = ATEM_LEN_SYN
-};
+static thread_local uint8_t buf_close[ATEM_LEN_SYN];
 
 // Buffer to request a packet to be retransmitted
-static thread_local uint8_t buf_retxreq[ATEM_LEN_HEADER] = {
-	[ATEM_INDEX_FLAGS] = ATEM_FLAG_RETXREQ,
-	[ATEM_INDEX_LEN_LOW] = ATEM_LEN_HEADER
-};
+static thread_local uint8_t buf_retxreq[ATEM_LEN_HEADER];
+
+#endif // ATEM_WRITE_BUF_CONTEXT
+
+// Reorder window slots are indexed by remote id so window has to evenly divide remote id range
+#if ATEM_REORDER_WINDOW
+_Static_assert((ATEM_REORDER_WINDOW & (ATEM_REORDER_WINDOW - 1)) == 0, "ATEM_REORDER_WINDOW has to be a power of two");
+_Static_assert(ATEM_REORDER_WINDOW < (ATEM_LIMIT_REMOTEID / 2), "ATEM_REORDER_WINDOW has to be smaller than half the remote id range");
+_Static_assert(ATEM_REORDER_PACKET_LEN >= ATEM_LEN_HEADER && ATEM_REORDER_PACKET_LEN <= ATEM_PACKET_LEN_MAX, "Invalid ATEM_REORDER_PACKET_LEN");
+#endif // ATEM_REORDER_WINDOW
+
+// Outbound packets have to fit header and at least one command
+#if ATEM_SEND_WINDOW
+_Static_assert(ATEM_SEND_PACKET_LEN > (ATEM_LEN_HEADER + ATEM_LEN_CMDHEADER) && ATEM_SEND_PACKET_LEN <= ATEM_PACKET_LEN_MAX, "Invalid ATEM_SEND_PACKET_LEN");
+#endif // ATEM_SEND_WINDOW
+
+// Session ids assigned by the ATEM switcher after opening handshake has this bit set
+#define SESSIONID_SERVER_FLAG 0x8000
+
+
+
+// Drops all packets held by reorder window
+static inline void atem_reorder_clear(struct atem* atem) {
+#if ATEM_REORDER_WINDOW
+	for (uint16_t i = 0; i < ATEM_REORDER_WINDOW; i++) {
+		atem->reorder.len[i] = 0;
+	}
+#else // ATEM_REORDER_WINDOW
+	(void)atem;
+#endif // ATEM_REORDER_WINDOW
+}
 
+// Drops all queued outbound packets and restarts local ids
+static inline void atem_send_clear(struct atem* atem) {
+#if ATEM_SEND_WINDOW
+	atem->send.head = 0;
+	atem->send.count = 0;
+	atem->send.sent = 0;
+	atem->send.local_id_last = 0;
+#else // ATEM_SEND_WINDOW
+	(void)atem;
+#endif // ATEM_SEND_WINDOW
+}
+
+#if ATEM_SEND_WINDOW
+// Releases sent packets up to and including acknowledged id
+static void atem_send_acknowledge(struct atem* atem, uint16_t ack_id) {
+	while (atem->send.sent > 0) {
+		const uint8_t* const packet = atem->send.buf[atem->send.head];
+		const uint16_t local_id = (packet[ATEM_INDEX_REMOTEID_HIGH] << 8 | packet[ATEM_INDEX_REMOTEID_LOW]) & ATEM_LIMIT_REMOTEID;
+		if (((ack_id - local_id) & ATEM_LIMIT_REMOTEID) >= (ATEM_LIMIT_REMOTEID / 2)) break;
+		atem->send.head = (uint16_t)((atem->send.head + 1) % ATEM_SEND_WINDOW);
+		atem->send.count--;
+		atem->send.sent--;
+	}
+}
 
+// Only sends queued packets when connected since session id is assigned by the ATEM switcher
+static inline bool atem_send_connected(struct atem* atem) {
+	return (atem->session_id & SESSIONID_SERVER_FLAG) && atem->write_buf != buf_close;
+}
+#endif // ATEM_SEND_WINDOW
 
 // Sets write buffer to be an opening handshake SYN packet to start a new connection
-void atem_connection_open(struct atem* atem) {
+void atem_connection_open(struct atem* atem, uint32_t random) {
 	assert(atem != NULL);
-	buf_open[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN | ((atem->write_buf == buf_open) ? ATEM_FLAG_RETX : 0);
+
+	// Proposes a new random session id in range 1 to 0x7fff unless retransmitting an opening handshake already in progress
+	const bool retransmit = atem->write_buf == buf_open;
+	if (!retransmit) {
+		const uint16_t session_id = (uint16_t)((random ^ (random >> 16)) & ~(uint32_t)SESSIONID_SERVER_FLAG);
+		atem->session_id_open = (session_id != 0) ? session_id : 1;
+	}
+	atem->session_id = atem->session_id_open;
+
+	buf_open[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN | (retransmit ? ATEM_FLAG_RETX : 0);
+	buf_open[ATEM_INDEX_LEN_LOW] = ATEM_LEN_SYN;
+	buf_open[ATEM_INDEX_SESSIONID_HIGH] = (uint8_t)(atem->session_id_open >> 8);
+	buf_open[ATEM_INDEX_SESSIONID_LOW] = (uint8_t)(atem->session_id_open & 0xff);
+	buf_open[ATEM_INDEX_OPCODE] = ATEM_OPCODE_OPEN;
 	atem->write_buf = buf_open;
 	atem->write_len = ATEM_LEN_SYN;
+	atem_reorder_clear(atem);
+	atem_send_clear(atem);
+	atem->ack_deferred = false;
+}
+
+// Gets exponential backoff with jitter for next opening handshake retry
+uint32_t atem_reconnect_delay(struct atem* atem, uint32_t random) {
+	assert(atem != NULL);
+
+	// Doubles delay for every retry until reaching timeout
+	uint32_t delay = ATEM_RECONNECT_DELAY_MS;
+	for (uint8_t i = 0; i < atem->reconnect_attempts && delay < ATEM_TIMEOUT_MS; i++) {
+		delay *= 2;
+	}
+	if (delay >= ATEM_TIMEOUT_MS) {
+		delay = ATEM_TIMEOUT_MS;
+	}
+	else {
+		atem->reconnect_attempts++;
+	}
+
+	// Jitters delay to somewhere between half and full delay
+	return delay - random % (delay / 2 + 1);
 }
 
 // Sends a close packet to close the session
 void atem_connection_close(struct atem* atem) {
 	assert(atem != NULL);
 	buf_close[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN;
-	buf_close[ATEM_INDEX_SESSIONID_HIGH] = atem->read_buf[ATEM_INDEX_SESSIONID_HIGH];
-	buf_close[ATEM_INDEX_SESSIONID_LOW] = atem->read_buf[ATEM_INDEX_SESSIONID_LOW];
+	buf_close[ATEM_INDEX_LEN_LOW] = ATEM_LEN_SYN;
+	buf_close[ATEM_INDEX_SESSIONID_HIGH] = (uint8_t)(atem->session_id >> 8);
+	buf_close[ATEM_INDEX_SESSIONID_LOW] = (uint8_t)(atem->session_id & 0xff);
 	buf_close[ATEM_INDEX_OPCODE] = ATEM_OPCODE_CLOSING;
 	atem->write_buf = buf_close;
 	atem->write_len = ATEM_LEN_SYN;
+	atem_send_clear(atem);
 }
 
-// Parses a received ATEM UDP packet
+#if ATEM_READ_BUF
+// Parses a received ATEM UDP packet from the contexts read buffer
 enum atem_status atem_parse(struct atem* atem) {
 	assert(atem != NULL);
+	return atem_parse_buf(atem, atem->read_buf, sizeof(atem->read_buf));
+}
+#endif // ATEM_READ_BUF
+
+// Parses a received ATEM UDP packet in place from a caller-owned buffer
+enum atem_status atem_parse_buf(struct atem* atem, uint8_t* buf, uint16_t len) {
+	assert(atem != NULL);
+	assert(buf != NULL);
+
+	// Rejects packets that are truncated compared to the length in their header
+	if (len < ATEM_LEN_HEADER || ((buf[ATEM_INDEX_LEN_HIGH] << 8 | buf[ATEM_INDEX_LEN_LOW]) & ATEM_PACKET_LEN_MAX) > len) {
+		return ATEM_STATUS_ERROR;
+	}
+
+	// Sets buffer to use for command iteration and session id to use for closing requests
+	atem->parse_buf = buf;
+	atem->session_id = (uint16_t)(buf[ATEM_INDEX_SESSIONID_HIGH] << 8 | buf[ATEM_INDEX_SESSIONID_LOW]);
+
+#if ATEM_SEND_WINDOW
+	// Releases queued packets acknowledged by the ATEM switcher
+	if ((buf[ATEM_INDEX_FLAGS] & (ATEM_FLAG_ACK | ATEM_FLAG_SYN)) == ATEM_FLAG_ACK) {
+		atem_send_acknowledge(atem, (uint16_t)(buf[ATEM_INDEX_ACKID_HIGH] << 8 | buf[ATEM_INDEX_ACKID_LOW]));
+	}
+#endif // ATEM_SEND_WINDOW
 
 	// Resends close packet without processing potential payload
 	if (atem->write_buf == buf_close) {
@@ -95,52 +224,62 @@ enum atem_status atem_parse(struct atem* atem) {
 		buf_close[ATEM_INDEX_OPCODE] = ATEM_OPCODE_CLOSING;
 
 		// Processes closing or closed packet
-		if (atem->read_buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_SYN) {
+		if (buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_SYN) {
 			// Returns closed status for response to close request
-			if (atem->read_buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_CLOSED) {
+			if (buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_CLOSED) {
 				return ATEM_STATUS_CLOSED;
 			}
 
 			// Sets close packet to be closed response to closing request
-			if (atem->read_buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_CLOSING) {
+			if (buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_CLOSING) {
 				buf_close[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN;
 				buf_close[ATEM_INDEX_OPCODE] = ATEM_OPCODE_CLOSED;
 			}
 		}
 
 		// Copies over session id from incoming packet to close packet
-		buf_close[ATEM_INDEX_SESSIONID_HIGH] = atem->read_buf[ATEM_INDEX_SESSIONID_HIGH];
-		buf_close[ATEM_INDEX_SESSIONID_LOW] = atem->read_buf[ATEM_INDEX_SESSIONID_LOW];
+		buf_close[ATEM_INDEX_SESSIONID_HIGH] = buf[ATEM_INDEX_SESSIONID_HIGH];
+		buf_close[ATEM_INDEX_SESSIONID_LOW] = buf[ATEM_INDEX_SESSIONID_LOW];
 
 		return ATEM_STATUS_WRITE_ONLY;
 	}
 
 	// Responds with ACK packet to packet requesting it
-	if (atem->read_buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_ACKREQ) {
+	if (buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_ACKREQ) {
 		// Gets remote id in this packet and next remote id in sequence
 		const uint16_t remote_id_next = (atem->remote_id_last + 1) & ATEM_LIMIT_REMOTEID;
-		const uint16_t remote_id_recved = ((atem->read_buf[ATEM_INDEX_REMOTEID_HIGH] << 8) |
-			atem->read_buf[ATEM_INDEX_REMOTEID_LOW]) & ATEM_LIMIT_REMOTEID;
+		const uint16_t remote_id_recved = ((buf[ATEM_INDEX_REMOTEID_HIGH] << 8) |
+			buf[ATEM_INDEX_REMOTEID_LOW]) & ATEM_LIMIT_REMOTEID;
 
 		// Acknowledges this packet if it is next in line
 		if (remote_id_recved == remote_id_next) {
 			// Updates last acknowledged remote id
 			atem->remote_id_last = remote_id_recved;
 
+#if ATEM_REORDER_WINDOW
+			// Drops held copy of this packet if it was held before being retransmitted in sequence
+			if (buf != atem->reorder.buf[remote_id_recved % ATEM_REORDER_WINDOW]) {
+				atem->reorder.len[remote_id_recved % ATEM_REORDER_WINDOW] = 0;
+			}
+#endif // ATEM_REORDER_WINDOW
+
 			// Sets ACK response to be sent as response
 			atem->write_buf = buf_ack;
+			atem->write_len = ATEM_LEN_HEADER;
+			buf_ack[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACK;
+			buf_ack[ATEM_INDEX_LEN_LOW] = ATEM_LEN_HEADER;
 
 			// Copies over session id from incoming packet to ACK response
-			buf_ack[ATEM_INDEX_SESSIONID_HIGH] = atem->read_buf[ATEM_INDEX_SESSIONID_HIGH];
-			buf_ack[ATEM_INDEX_SESSIONID_LOW] = atem->read_buf[ATEM_INDEX_SESSIONID_LOW];
+			buf_ack[ATEM_INDEX_SESSIONID_HIGH] = buf[ATEM_INDEX_SESSIONID_HIGH];
+			buf_ack[ATEM_INDEX_SESSIONID_LOW] = buf[ATEM_INDEX_SESSIONID_LOW];
 
 			// Copies over remote id from incoming packets to ACK responses ack id
-			buf_ack[ATEM_INDEX_ACKID_HIGH] = atem->read_buf[ATEM_INDEX_REMOTEID_HIGH];
-			buf_ack[ATEM_INDEX_ACKID_LOW] = atem->read_buf[ATEM_INDEX_REMOTEID_LOW];
+			buf_ack[ATEM_INDEX_ACKID_HIGH] = buf[ATEM_INDEX_REMOTEID_HIGH];
+			buf_ack[ATEM_INDEX_ACKID_LOW] = buf[ATEM_INDEX_REMOTEID_LOW];
 
 			// Sets length of read buffer
-			atem->read_len = (atem->read_buf[ATEM_INDEX_LEN_HIGH] << 8 |
-				atem->read_buf[ATEM_INDEX_LEN_LOW]) & ATEM_PACKET_LEN_MAX;
+			atem->read_len = (buf[ATEM_INDEX_LEN_HIGH] << 8 |
+				buf[ATEM_INDEX_LEN_LOW]) & ATEM_PACKET_LEN_MAX;
 
 			// Sets up for parsing ATEM commands in payload
 			atem->cmd_index_next = ATEM_LEN_HEADER;
@@ -150,12 +289,32 @@ enum atem_status atem_parse(struct atem* atem) {
 		}
 		// Sends retransmit request if received remote id is closer to being ahead than behind
 		else if (((remote_id_recved - remote_id_next) & ATEM_LIMIT_REMOTEID) < (ATEM_LIMIT_REMOTEID / 2)) {
+#if ATEM_REORDER_WINDOW
+			// Holds packet within reorder window, only requesting retransmit for first packet after gap
+			const uint16_t len_packet = (uint16_t)((buf[ATEM_INDEX_LEN_HIGH] << 8 | buf[ATEM_INDEX_LEN_LOW]) & ATEM_PACKET_LEN_MAX);
+			if (((remote_id_recved - remote_id_next) & ATEM_LIMIT_REMOTEID) < ATEM_REORDER_WINDOW && len_packet <= ATEM_REORDER_PACKET_LEN) {
+				bool holding = false;
+				for (uint16_t i = 0; i < ATEM_REORDER_WINDOW; i++) {
+					holding |= atem->reorder.len[i] > 0;
+				}
+				const uint16_t slot = (uint16_t)(remote_id_recved % ATEM_REORDER_WINDOW);
+				memcpy(atem->reorder.buf[slot], buf, len_packet);
+				atem->reorder.len[slot] = len_packet;
+				if (holding) {
+					return ATEM_STATUS_NONE;
+				}
+			}
+#endif // ATEM_REORDER_WINDOW
+
 			// Sets RETX response to be sent as response
 			atem->write_buf = buf_retxreq;
+			atem->write_len = ATEM_LEN_HEADER;
+			buf_retxreq[ATEM_INDEX_FLAGS] = ATEM_FLAG_RETXREQ;
+			buf_retxreq[ATEM_INDEX_LEN_LOW] = ATEM_LEN_HEADER;
 
 			// Copies over session id from incoming packet to RETX response
-			buf_retxreq[ATEM_INDEX_SESSIONID_HIGH] = atem->read_buf[ATEM_INDEX_SESSIONID_HIGH];
-			buf_retxreq[ATEM_INDEX_SESSIONID_LOW] = atem->read_buf[ATEM_INDEX_SESSIONID_LOW];
+			buf_retxreq[ATEM_INDEX_SESSIONID_HIGH] = buf[ATEM_INDEX_SESSIONID_HIGH];
+			buf_retxreq[ATEM_INDEX_SESSIONID_LOW] = buf[ATEM_INDEX_SESSIONID_LOW];
 
 			// Sets RETX responses local id to next remote id in sequence
 			buf_retxreq[ATEM_INDEX_LOCALID_HIGH] = remote_id_next >> 8;
@@ -165,10 +324,13 @@ enum atem_status atem_parse(struct atem* atem) {
 		else {
 			// Sets ACK response to be sent as response
 			atem->write_buf = buf_ack;
+			atem->write_len = ATEM_LEN_HEADER;
+			buf_ack[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACK;
+			buf_ack[ATEM_INDEX_LEN_LOW] = ATEM_LEN_HEADER;
 
 			// Copies over session id from incoming packet to ACK response
-			buf_ack[ATEM_INDEX_SESSIONID_HIGH] = atem->read_buf[ATEM_INDEX_SESSIONID_HIGH];
-			buf_ack[ATEM_INDEX_SESSIONID_LOW] = atem->read_buf[ATEM_INDEX_SESSIONID_LOW];
+			buf_ack[ATEM_INDEX_SESSIONID_HIGH] = buf[ATEM_INDEX_SESSIONID_HIGH];
+			buf_ack[ATEM_INDEX_SESSIONID_LOW] = buf[ATEM_INDEX_SESSIONID_LOW];
 
 			// Sets ACK responses ack id to last remote id acknowledged
 			buf_ack[ATEM_INDEX_ACKID_HIGH] = atem->remote_id_last >> 8;
@@ -179,14 +341,16 @@ enum atem_status atem_parse(struct atem* atem) {
 		return ATEM_STATUS_WRITE_ONLY;
 	}
 	// Ignores packets that are not ACK or SYN
-	else if (!(atem->read_buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_SYN)) {
+	else if (!(buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_SYN)) {
 		return ATEM_STATUS_NONE;
 	}
 	// Responds to accept SYN/ACK packet to complete opening handshake
-	else if (atem->read_buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_ACCEPT) {
+	else if (buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_ACCEPT) {
 		// Copies over session id from incoming packet to ACK response and clears ack id
-		buf_ack[ATEM_INDEX_SESSIONID_HIGH] = atem->read_buf[ATEM_INDEX_SESSIONID_HIGH];
-		buf_ack[ATEM_INDEX_SESSIONID_LOW] = atem->read_buf[ATEM_INDEX_SESSIONID_LOW];
+		buf_ack[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACK;
+		buf_ack[ATEM_INDEX_LEN_LOW] = ATEM_LEN_HEADER;
+		buf_ack[ATEM_INDEX_SESSIONID_HIGH] = buf[ATEM_INDEX_SESSIONID_HIGH];
+		buf_ack[ATEM_INDEX_SESSIONID_LOW] = buf[ATEM_INDEX_SESSIONID_LOW];
 		buf_ack[ATEM_INDEX_ACKID_HIGH] = 0x00;
 		buf_ack[ATEM_INDEX_ACKID_LOW] = 0x00;
 
@@ -197,20 +361,23 @@ enum atem_status atem_parse(struct atem* atem) {
 		atem->write_buf = buf_ack;
 		atem->write_len = ATEM_LEN_HEADER;
 		atem->remote_id_last = 0;
+		atem->reconnect_attempts = 0;
+		atem_reorder_clear(atem);
 		return ATEM_STATUS_ACCEPTED;
 	}
 	// Responds to closing request with closed response
-	else if (atem->read_buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_CLOSING) {
+	else if (buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_CLOSING) {
 		buf_close[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN;
-		buf_close[ATEM_INDEX_SESSIONID_HIGH] = atem->read_buf[ATEM_INDEX_SESSIONID_HIGH];
-		buf_close[ATEM_INDEX_SESSIONID_LOW] = atem->read_buf[ATEM_INDEX_SESSIONID_LOW];
+		buf_close[ATEM_INDEX_LEN_LOW] = ATEM_LEN_SYN;
+		buf_close[ATEM_INDEX_SESSIONID_HIGH] = buf[ATEM_INDEX_SESSIONID_HIGH];
+		buf_close[ATEM_INDEX_SESSIONID_LOW] = buf[ATEM_INDEX_SESSIONID_LOW];
 		buf_close[ATEM_INDEX_OPCODE] = ATEM_OPCODE_CLOSED;
 		atem->write_buf = buf_close;
 		atem->write_len = ATEM_LEN_SYN;
 		return ATEM_STATUS_CLOSING;
 	}
 	// Returns reject status
-	else if (atem->read_buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_REJECT) {
+	else if (buf[ATEM_INDEX_OPCODE] == ATEM_OPCODE_REJECT) {
 		atem->write_buf = NULL;
 		return ATEM_STATUS_REJECTED;
 	}
@@ -219,28 +386,279 @@ enum atem_status atem_parse(struct atem* atem) {
 	return ATEM_STATUS_ERROR;
 }
 
+// Parses batch of packets one at a time, deferring acknowledgements to a single cumulative acknowledgement after the last packet
+enum atem_status atem_parse_batch(struct atem* atem, uint8_t* const bufs[], const uint16_t lens[], uint16_t count, uint16_t* index) {
+	assert(atem != NULL);
+	assert(bufs != NULL || count == 0);
+	assert(lens != NULL || count == 0);
+	assert(index != NULL);
+	assert(*index <= count);
+
+	while (true) {
+		// Releases packets held by reorder window before parsing next packet in batch
+		enum atem_status status = atem_parse_reordered(atem);
+		if (status == ATEM_STATUS_NONE) {
+			if (*index >= count) break;
+			status = atem_parse_buf(atem, bufs[*index], lens[*index]);
+			*index += 1;
+		}
+
+		// Defers acknowledgement of packets in sequence or behind, processing payload if available
+		if ((status == ATEM_STATUS_WRITE || status == ATEM_STATUS_WRITE_ONLY) && atem->write_buf == buf_ack) {
+			atem->ack_deferred = true;
+			if (status == ATEM_STATUS_WRITE) {
+				return ATEM_STATUS_WRITE;
+			}
+		}
+		// Returns status of packets that can not be deferred
+		else if (status != ATEM_STATUS_NONE) {
+			return status;
+		}
+	}
+
+	// Ends batch without acknowledgement if nothing was deferred or session is closing
+	if (!atem->ack_deferred) {
+		return ATEM_STATUS_NONE;
+	}
+	atem->ack_deferred = false;
+	if (atem->write_buf == NULL || atem->write_buf == buf_close) {
+		return ATEM_STATUS_NONE;
+	}
+
+	// Acknowledges all packets received in sequence with a single acknowledgement, rebuilt since response buffers can be shared
+	atem->write_buf = buf_ack;
+	atem->write_len = ATEM_LEN_HEADER;
+	buf_ack[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACK;
+	buf_ack[ATEM_INDEX_LEN_LOW] = ATEM_LEN_HEADER;
+	buf_ack[ATEM_INDEX_SESSIONID_HIGH] = (uint8_t)(atem->session_id >> 8);
+	buf_ack[ATEM_INDEX_SESSIONID_LOW] = (uint8_t)(atem->session_id & 0xff);
+	buf_ack[ATEM_INDEX_ACKID_HIGH] = (uint8_t)(atem->remote_id_last >> 8);
+	buf_ack[ATEM_INDEX_ACKID_LOW] = (uint8_t)(atem->remote_id_last & 0xff);
+	return ATEM_STATUS_WRITE_ONLY;
+}
+
+#if ATEM_REORDER_WINDOW
+// Parses held packet if it is next in sequence
+enum atem_status atem_parse_reordered(struct atem* atem) {
+	assert(atem != NULL);
+
+	// Only releases packet held for next remote id
+	const uint16_t remote_id_next = (uint16_t)((atem->remote_id_last + 1) & ATEM_LIMIT_REMOTEID);
+	const uint16_t slot = (uint16_t)(remote_id_next % ATEM_REORDER_WINDOW);
+	const uint16_t len = atem->reorder.len[slot];
+	if (len == 0) {
+		return ATEM_STATUS_NONE;
+	}
+	atem->reorder.len[slot] = 0;
+
+	// Drops stale packet held for another remote id sharing the same slot
+	uint8_t* const buf = atem->reorder.buf[slot];
+	if ((((buf[ATEM_INDEX_REMOTEID_HIGH] << 8) | buf[ATEM_INDEX_REMOTEID_LOW]) & ATEM_LIMIT_REMOTEID) != remote_id_next) {
+		return ATEM_STATUS_NONE;
+	}
+
+	// Parses held packet as if it was just received
+	return atem_parse_buf(atem, buf, len);
+}
+#endif // ATEM_REORDER_WINDOW
+
+#if ATEM_SEND_WINDOW
+// Appends command to last unsent packet in queue or to a new packet if it does not fit
+uint8_t* atem_cmd_enqueue(struct atem* atem, uint32_t name, uint16_t len) {
+	assert(atem != NULL);
+	assert(atem->send.count <= ATEM_SEND_WINDOW);
+	assert(atem->send.sent <= atem->send.count);
+
+	// Rejects commands that can never fit in a packet
+	if (len > (ATEM_SEND_PACKET_LEN - ATEM_LEN_HEADER - ATEM_LEN_CMDHEADER)) {
+		return NULL;
+	}
+	const uint16_t cmd_len = (uint16_t)(len + ATEM_LEN_CMDHEADER);
+
+	// Starts a new packet if there is no unsent packet or command does not fit in it
+	uint16_t slot = (uint16_t)((atem->send.head + atem->send.count + ATEM_SEND_WINDOW - 1) % ATEM_SEND_WINDOW);
+	if (atem->send.sent == atem->send.count || (atem->send.len[slot] + cmd_len) > ATEM_SEND_PACKET_LEN) {
+		if (atem->send.count == ATEM_SEND_WINDOW) {
+			return NULL;
+		}
+		slot = (uint16_t)((atem->send.head + atem->send.count) % ATEM_SEND_WINDOW);
+		atem->send.len[slot] = ATEM_LEN_HEADER;
+		atem->send.count++;
+	}
+
+	// Appends command header to packet
+	uint8_t* const cmd_buf = &atem->send.buf[slot][atem->send.len[slot]];
+	atem->send.len[slot] += cmd_len;
+	cmd_buf[0] = (uint8_t)(cmd_len >> 8);
+	cmd_buf[1] = (uint8_t)(cmd_len & 0xff);
+	cmd_buf[2] = 0x00;
+	cmd_buf[3] = 0x00;
+	cmd_buf[ATEM_OFFSET_CMDNAME + 0] = (uint8_t)((name >> 24) & 0xff);
+	cmd_buf[ATEM_OFFSET_CMDNAME + 1] = (uint8_t)((name >> 16) & 0xff);
+	cmd_buf[ATEM_OFFSET_CMDNAME + 2] = (uint8_t)((name >> 8) & 0xff);
+	cmd_buf[ATEM_OFFSET_CMDNAME + 3] = (uint8_t)(name & 0xff);
+
+	// Returns pointer to payload for caller to fill in
+	return &cmd_buf[ATEM_LEN_CMDHEADER];
+}
+
+// Sets send buffer to next queued packet to retransmit or send for the first time
+enum atem_status atem_send_poll(struct atem* atem, uint32_t now) {
+	assert(atem != NULL);
+
+	// Only sends packets when connected and not closing
+	if (!atem_send_connected(atem)) {
+		return ATEM_STATUS_NONE;
+	}
+
+	// Retransmits unacknowledged packets not acknowledged in time
+	for (uint16_t i = 0; i < atem->send.sent; i++) {
+		const uint16_t slot = (uint16_t)((atem->send.head + i) % ATEM_SEND_WINDOW);
+		if ((uint32_t)(now - atem->send.sent_at[slot]) < ATEM_RESEND_TIME) continue;
+		atem->send.buf[slot][ATEM_INDEX_FLAGS] |= ATEM_FLAG_RETX;
+		atem->send.sent_at[slot] = now;
+		atem->send_buf = atem->send.buf[slot];
+		atem->send_len = atem->send.len[slot];
+		return ATEM_STATUS_WRITE_ONLY;
+	}
+
+	// Returns when there are no more packets to send
+	if (atem->send.sent == atem->send.count) {
+		return ATEM_STATUS_NONE;
+	}
+
+	// Sets header for next packet to send with the next local id in sequence
+	const uint16_t slot = (uint16_t)((atem->send.head + atem->send.sent) % ATEM_SEND_WINDOW);
+	uint8_t* const packet = atem->send.buf[slot];
+	const uint16_t len = atem->send.len[slot];
+	atem->send.local_id_last = (atem->send.local_id_last + 1) & ATEM_LIMIT_REMOTEID;
+	packet[ATEM_INDEX_FLAGS] = (uint8_t)(ATEM_FLAG_ACKREQ | (len >> 8));
+	packet[ATEM_INDEX_LEN_LOW] = (uint8_t)(len & 0xff);
+	packet[ATEM_INDEX_SESSIONID_HIGH] = (uint8_t)(atem->session_id >> 8);
+	packet[ATEM_INDEX_SESSIONID_LOW] = (uint8_t)(atem->session_id & 0xff);
+	packet[ATEM_INDEX_ACKID_HIGH] = 0x00;
+	packet[ATEM_INDEX_ACKID_LOW] = 0x00;
+	packet[ATEM_INDEX_LOCALID_HIGH] = 0x00;
+	packet[ATEM_INDEX_LOCALID_LOW] = 0x00;
+	packet[ATEM_INDEX_UNKNOWNID_HIGH] = 0x00;
+	packet[ATEM_INDEX_UNKNOWNID_LOW] = 0x00;
+	packet[ATEM_INDEX_REMOTEID_HIGH] = (uint8_t)(atem->send.local_id_last >> 8);
+	packet[ATEM_INDEX_REMOTEID_LOW] = (uint8_t)(atem->send.local_id_last & 0xff);
+
+	// Sends packet and tracks it until acknowledged
+	atem->send.sent_at[slot] = now;
+	atem->send.sent++;
+	atem->send_buf = packet;
+	atem->send_len = len;
+	return ATEM_STATUS_WRITE_ONLY;
+}
+
+// Gets time until next queued packet has to be sent or retransmitted
+uint32_t atem_send_wait(struct atem* atem, uint32_t now) {
+	assert(atem != NULL);
+
+	// Nothing can be sent before connected or while closing
+	if (atem->send.count == 0 || !atem_send_connected(atem)) {
+		return UINT32_MAX;
+	}
+
+	// Packets not yet sent can be sent right away
+	if (atem->send.sent < atem->send.count) {
+		return 0;
+	}
+
+	// Gets time until earliest retransmit
+	uint32_t wait = UINT32_MAX;
+	for (uint16_t i = 0; i < atem->send.sent; i++) {
+		const uint16_t slot = (uint16_t)((atem->send.head + i) % ATEM_SEND_WINDOW);
+		const uint32_t elapsed = now - atem->send.sent_at[slot];
+		if (elapsed >= ATEM_RESEND_TIME) return 0;
+		if ((ATEM_RESEND_TIME - elapsed) < wait) {
+			wait = ATEM_RESEND_TIME - elapsed;
+		}
+	}
+	return wait;
+}
+#endif // ATEM_SEND_WINDOW
+
 // Gets next command name and sets command buffer to a pointer to its data
 uint32_t atem_cmd_next(struct atem* atem) {
 	assert(atem != NULL);
-	assert(atem->read_buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_ACKREQ);
+	assert(atem->parse_buf != NULL);
+	assert(atem->parse_buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_ACKREQ);
 	assert(atem->read_len >= atem->cmd_index_next);
 	assert(atem->read_len <= ATEM_PACKET_LEN_MAX);
 	assert(atem->cmd_index_next >= ATEM_LEN_HEADER);
 	assert(atem->cmd_index_next <= ATEM_PACKET_LEN_MAX);
 
-	// Gets pointer to command in read buffer
-	uint8_t* const buf = &atem->read_buf[atem->cmd_index_next];
+	while (true) {
+		// Gets pointer to command in read buffer
+		uint8_t* const buf = &atem->parse_buf[atem->cmd_index_next];
+
+		// Ends iteration if command header does not fit or is malformed since zero length would never advance
+		const uint16_t cmd_len_max = (uint16_t)(atem->read_len - atem->cmd_index_next);
+		const uint16_t cmd_len = (cmd_len_max >= ATEM_LEN_CMDHEADER) ? (uint16_t)(buf[0] << 8 | buf[1]) : 0;
+		if (cmd_len < ATEM_LEN_CMDHEADER || cmd_len > cmd_len_max) {
+			atem->cmd_index_next = atem->read_len;
+			atem->cmd_payload_len = 0;
+			atem->cmd_payload_buf = buf;
+			return 0;
+		}
 
-	// Sets index of next command
-	uint16_t cmd_len = (uint16_t)(buf[0] << 8 | buf[1]);
-	atem->cmd_index_next += cmd_len;
+		// Sets index of next command
+		atem->cmd_index_next += cmd_len;
 
-	// Sets command buffer and length
-	atem->cmd_payload_len = cmd_len - ATEM_LEN_CMDHEADER;
-	atem->cmd_payload_buf = buf + ATEM_LEN_CMDHEADER;
+		// Converts command name to a 32 bit integer for easy comparison
+		const uint32_t name = (uint32_t)(buf[4] << 24 | buf[5] << 16 | buf[6] << 8 | buf[7]);
 
-	// Converts command name to a 32 bit integer for easy comparison
-	return (uint32_t)(buf[4] << 24 | buf[5] << 16 | buf[6] << 8 | buf[7]);
+		// Skips commands not matching filter without touching their payload, ending iteration after last command
+		if (atem->cmd_filter != 0 && !(atem->cmd_filter & ATEM_CMD_FILTER_BIT(name))) {
+			if (atem->cmd_index_next < atem->read_len) continue;
+			atem->cmd_payload_len = 0;
+			atem->cmd_payload_buf = &atem->parse_buf[atem->read_len];
+			return 0;
+		}
+
+		// Sets command buffer and length
+		atem->cmd_payload_len = cmd_len - ATEM_LEN_CMDHEADER;
+		atem->cmd_payload_buf = buf + ATEM_LEN_CMDHEADER;
+
+		return name;
+	}
+}
+
+// Validates all command headers and indexes their names and payloads
+int atem_cmd_index(struct atem* atem, struct atem_cmd_entry* entries, uint16_t entries_len) {
+	assert(atem != NULL);
+	assert(atem->parse_buf != NULL);
+	assert(atem->parse_buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_ACKREQ);
+	assert(atem->read_len >= ATEM_LEN_HEADER);
+	assert(atem->read_len <= ATEM_PACKET_LEN_MAX);
+	assert(entries != NULL || entries_len == 0);
+
+	// Walks all command headers without modifying iteration state for atem_cmd_next
+	int count = 0;
+	uint16_t index = ATEM_LEN_HEADER;
+	while (index < atem->read_len) {
+		const uint8_t* const buf = &atem->parse_buf[index];
+
+		// Rejects entire packet if command header does not fit or its length is invalid
+		if ((atem->read_len - index) < ATEM_LEN_CMDHEADER) return -1;
+		const uint16_t cmd_len = (uint16_t)(buf[0] << 8 | buf[1]);
+		if (cmd_len < ATEM_LEN_CMDHEADER || cmd_len > (atem->read_len - index)) return -1;
+
+		// Indexes command if there is room left
+		if (count < entries_len) {
+			entries[count].name = (uint32_t)buf[4] << 24 | (uint32_t)buf[5] << 16 | (uint32_t)buf[6] << 8 | buf[7];
+			entries[count].offset = index + ATEM_LEN_CMDHEADER;
+			entries[count].len = cmd_len - ATEM_LEN_CMDHEADER;
+		}
+		count++;
+		index += cmd_len;
+	}
+
+	// Returns number of commands in packet
+	return count;
 }
 
 
@@ -248,8 +666,8 @@ uint32_t atem_cmd_next(struct atem* atem) {
 // Gets update status for camera index and updates its tally state
 bool atem_tally_updated(struct atem* atem) {
 	assert(atem != NULL);
-	assert(atem->cmd_payload_buf >= &atem->read_buf[ATEM_LEN_HEADER]);
-	assert(atem->cmd_payload_buf < &atem->read_buf[ATEM_PACKET_LEN_MAX]);
+	assert(atem->cmd_payload_buf >= &atem->parse_buf[ATEM_LEN_HEADER]);
+	assert(atem->cmd_payload_buf < &atem->parse_buf[atem->read_len]);
 
 	// Ensures destination is within range of tally data length
 	if (atem->cmd_payload_buf[TALLY_INDEX_LEN_HIGH] != 0 || atem->cmd_payload_buf[TALLY_INDEX_LEN_LOW] < atem->dest) {
@@ -268,44 +686,200 @@ bool atem_tally_updated(struct atem* atem) {
 	return (tally_pgm_old != atem->tally_pgm) || (tally_pvw_old != atem->tally_pvw);
 }
 
-// Translates camera control data from ATEMs protocol to Blackmagics SDI camera control protocol
-void atem_cc_translate(struct atem* atem) {
+// Gets tally states for all inputs packed into bitsets with a mask of changed inputs
+bool atem_tally_all_updated(struct atem* atem, struct atem_tally* tally) {
 	assert(atem != NULL);
-	assert(atem->cmd_payload_buf >= &atem->read_buf[ATEM_LEN_HEADER]);
-	assert(atem->cmd_payload_buf < &atem->read_buf[ATEM_PACKET_LEN_MAX]);
+	assert(tally != NULL);
+	assert(atem->cmd_payload_buf >= &atem->parse_buf[ATEM_LEN_HEADER]);
+	assert(atem->cmd_payload_buf < &atem->parse_buf[atem->read_len]);
+
+	// Gets number of inputs limited by payload length and number of inputs tracked
+	const uint8_t* const tally_buf = &atem->cmd_payload_buf[TALLY_OFFSET + 1];
+	uint16_t len = (uint16_t)(atem->cmd_payload_buf[TALLY_INDEX_LEN_HIGH] << 8 | atem->cmd_payload_buf[TALLY_INDEX_LEN_LOW]);
+	if (atem->cmd_payload_len < (TALLY_OFFSET + 1)) {
+		len = 0;
+	}
+	else if (len > atem->cmd_payload_len - (TALLY_OFFSET + 1)) {
+		len = atem->cmd_payload_len - (TALLY_OFFSET + 1);
+	}
+	if (len > ATEM_TALLY_INPUTS_MAX) {
+		len = ATEM_TALLY_INPUTS_MAX;
+	}
+
+	// Packs tally flags for 4 inputs at a time into PGM and PVW bitsets
+	uint32_t updated = 0;
+	for (uint32_t word = 0; word < ATEM_TALLY_WORDS; word++) {
+		uint32_t pgm = 0;
+		uint32_t pvw = 0;
+		for (uint32_t offset = 0; offset < 32; offset += 4) {
+			const uint32_t index = word * 32 + offset;
+			if (index >= len) break;
+
+			// Loads flags for next 4 inputs with input count not divisible by 4 padded with no tally
+			uint32_t flags = 0;
+			const uint32_t count = ((len - index) < 4) ? (len - index) : 4;
+			for (uint32_t i = 0; i < count; i++) {
+				flags |= (uint32_t)tally_buf[index + i] << (i * 8);
+			}
+
+			// Gets bytes only containing the PVW flag, matching atem_tally_updated even with unknown flags set
+			const uint32_t pvw_diff = flags ^ (TALLY_SWAR_MASK * TALLY_FLAG_PVW);
+			const uint32_t pvw_nonzero = ((pvw_diff & TALLY_SWAR_LOW7) + TALLY_SWAR_LOW7) | pvw_diff;
+			const uint32_t pvw_flags = (~pvw_nonzero >> 7) & TALLY_SWAR_MASK;
 
+			// Packs lowest bit of each byte into 4 consecutive bits
+			pgm |= (((flags & TALLY_SWAR_MASK) * TALLY_SWAR_PACK) >> TALLY_SWAR_SHIFT) << offset;
+			pvw |= ((pvw_flags * TALLY_SWAR_PACK) >> TALLY_SWAR_SHIFT) << offset;
+		}
+
+		// Updates bitsets and marks inputs that changed since last update
+		tally->changed[word] = (tally->pgm[word] ^ pgm) | (tally->pvw[word] ^ pvw);
+		tally->pgm[word] = pgm;
+		tally->pvw[word] = pvw;
+		updated |= tally->changed[word];
+	}
+	tally->len = len;
+
+	// Returns boolean indicating if tally was updated for any input
+	return updated != 0;
+}
+
+// Gets length of camera control data translated to Blackmagics SDI camera control protocol, padded to 32 bit boundary
+static uint16_t cc_translate_len(const uint8_t* cc_buf) {
+	const uint8_t len = (uint8_t)(cc_buf[ATEM_INDEX_CC_COUNT8] + cc_buf[ATEM_INDEX_CC_COUNT16] * 2 + cc_buf[ATEM_INDEX_CC_COUNT32] * 4);
+	return (uint16_t)(CC_HEADER_LEN + CC_CMD_HEADER_LEN + ((len + 3) & ~3));
+}
+
+// Translates camera control data to SDI buffer that is either separate or located right before ATEM data, overwriting it
+static uint16_t cc_translate(const uint8_t* cc_buf, uint8_t* sdi_buf) {
 	// Gets length of payload and size of each value
-	const uint8_t count8 = atem->cmd_payload_buf[5];
-	const uint8_t count16 = atem->cmd_payload_buf[7];
-	const uint8_t count32 = atem->cmd_payload_buf[9];
+	const uint8_t count8 = cc_buf[ATEM_INDEX_CC_COUNT8];
+	const uint8_t count16 = cc_buf[ATEM_INDEX_CC_COUNT16];
+	const uint8_t count32 = cc_buf[ATEM_INDEX_CC_COUNT32];
 	const uint8_t width = (count8 > 0) + (count16 > 0) * 2 + (count32 > 0) * 4;
 	const uint8_t len = count8 + count16 * 2 + count32 * 4;
+	const uint16_t sdi_len = cc_translate_len(cc_buf);
 
 	// Sets SDI header
-	uint8_t* const sdi_buf = &atem->cmd_payload_buf[CC_HEADER_OFFSET];
-	sdi_buf[0] = atem->cmd_payload_buf[0]; // Destination
+	const uint8_t dest = cc_buf[ATEM_INDEX_CC_DEST];
+	sdi_buf[0] = dest; // Destination
 	sdi_buf[1] = CC_CMD_HEADER_LEN + len; // Length
 	sdi_buf[2] = 0x00; // Command
 	sdi_buf[3] = 0x00; // Reserved
 
-	// Sets SDI command header
-	// Retains byte 1 - 4 to indicate: category, parameter, data type and operation
+	// Sets SDI command header with category, parameter, data type and operation, retained when translating in place
+	for (uint8_t i = 0; i < CC_CMD_HEADER_LEN; i++) {
+		sdi_buf[CC_HEADER_LEN + i] = cc_buf[ATEM_INDEX_CC_CATEGORY + i];
+	}
 
 	// Updates byte order from big endian from ATEM to little endian for Blackmagic SDI Camera Control protocol
 	for (uint8_t index = 0; index < len; index += width) {
-		const uint8_t* atem_cc_data_buf = &atem->cmd_payload_buf[CC_ATEM_DATA_OFFSET + index];
+		const uint8_t* atem_cc_data_buf = &cc_buf[ATEM_OFFSET_CC_DATA + index];
 		uint8_t* sdi_data_buf = &sdi_buf[CC_HEADER_LEN + CC_CMD_HEADER_LEN + index];
 		for (uint8_t offset = 0; offset < width; offset++) {
 			sdi_data_buf[offset] = atem_cc_data_buf[width - offset - 1];
 		}
 	}
 
-	// Updates translated pointer and length padded to 32 bit boundary
-	atem->cmd_payload_len = CC_HEADER_LEN + CC_CMD_HEADER_LEN + ((len + 3) & ~3);
+	// Clears padding bytes
+	for (uint16_t i = CC_HEADER_LEN + CC_CMD_HEADER_LEN + len; i < sdi_len; i++) {
+		sdi_buf[i] = 0x00;
+	}
+
+	return sdi_len;
+}
+
+// Translates camera control data from ATEMs protocol to Blackmagics SDI camera control protocol
+void atem_cc_translate(struct atem* atem) {
+	assert(atem != NULL);
+	assert(atem->cmd_payload_buf >= &atem->parse_buf[ATEM_LEN_HEADER]);
+	assert(atem->cmd_payload_buf < &atem->parse_buf[atem->read_len]);
+
+	// Translates in place and updates translated pointer and length
+	uint8_t* const sdi_buf = &atem->cmd_payload_buf[CC_HEADER_OFFSET];
+	atem->cmd_payload_len = cc_translate(atem->cmd_payload_buf, sdi_buf);
 	atem->cmd_payload_buf = sdi_buf;
+}
 
-	// Clears padding bytes
-	for (uint16_t i = CC_HEADER_LEN + CC_CMD_HEADER_LEN + len; i < atem->cmd_payload_len; i++) {
-		atem->cmd_payload_buf[i] = 0x00;
+// Translates camera control data from ATEMs protocol into a separate buffer to batch multiple commands
+uint16_t atem_cc_translate_buf(struct atem* atem, uint8_t* buf, uint16_t size) {
+	assert(atem != NULL);
+	assert(buf != NULL);
+	assert(atem->cmd_payload_buf >= &atem->parse_buf[ATEM_LEN_HEADER]);
+	assert(atem->cmd_payload_buf < &atem->parse_buf[atem->read_len]);
+
+	// Ignores command with camera control data not fitting in its payload
+	if (atem->cmd_payload_len < ATEM_OFFSET_CC_DATA) return 0;
+	const uint8_t* const cc_buf = atem->cmd_payload_buf;
+	if ((ATEM_OFFSET_CC_DATA + cc_buf[ATEM_INDEX_CC_COUNT8] + cc_buf[ATEM_INDEX_CC_COUNT16] * 2 + cc_buf[ATEM_INDEX_CC_COUNT32] * 4) > atem->cmd_payload_len) return 0;
+
+	// Translates only if it fits in remaining space of buffer
+	if (cc_translate_len(cc_buf) > size) return 0;
+	return cc_translate(cc_buf, buf);
+}
+
+// Checks if camera control data assigns a different value than last assigned to the same parameter
+bool atem_cc_cache_changed(struct atem* atem, struct atem_cc_cache* cache) {
+	assert(atem != NULL);
+	assert(cache != NULL);
+	assert(atem->cmd_payload_buf >= &atem->parse_buf[ATEM_LEN_HEADER]);
+	assert(atem->cmd_payload_buf < &atem->parse_buf[atem->read_len]);
+
+	// Leaves malformed camera control data for translation to reject
+	const uint8_t* const cc_buf = atem->cmd_payload_buf;
+	if (atem->cmd_payload_len < ATEM_OFFSET_CC_DATA) {
+		cache->forwarded++;
+		return true;
+	}
+	const uint16_t len = (uint16_t)(cc_buf[ATEM_INDEX_CC_COUNT8] + cc_buf[ATEM_INDEX_CC_COUNT16] * 2 + cc_buf[ATEM_INDEX_CC_COUNT32] * 4);
+	if ((ATEM_OFFSET_CC_DATA + len) > atem->cmd_payload_len) {
+		cache->forwarded++;
+		return true;
+	}
+
+	// Gets cache slot for category and parameter
+	const uint8_t category = cc_buf[ATEM_INDEX_CC_CATEGORY];
+	const uint8_t parameter = cc_buf[ATEM_INDEX_CC_PARAMETER];
+	const uint8_t type = cc_buf[ATEM_INDEX_CC_TYPE];
+	const uint8_t* const value = &cc_buf[ATEM_OFFSET_CC_DATA];
+	const uint32_t slot = atem_cc_cache_slot(category, parameter);
+	const bool cached = atem_cc_cache_get(cache, category, parameter) != NULL;
+
+	// Always forwards triggers without data, relative offsets and values too long to cache
+	if (cc_buf[ATEM_INDEX_CC_OPERATION] != ATEM_CC_OPERATION_ASSIGN || len == 0 || len > ATEM_CC_CACHE_VALUE_LEN) {
+		if (cached) {
+			cache->entries[slot].len = 0;
+		}
+		cache->forwarded++;
+		return true;
+	}
+
+	// Suppresses assignment of same value as last assigned
+	if (cached && cache->entries[slot].type == type && cache->entries[slot].len == len) {
+		uint16_t i = 0;
+		while (i < len && cache->entries[slot].value[i] == value[i]) i++;
+		if (i == len) {
+			cache->suppressed++;
+			return false;
+		}
+	}
+
+	// Remembers assigned value, replacing any other parameter in the same slot
+	cache->entries[slot].category = category;
+	cache->entries[slot].parameter = parameter;
+	cache->entries[slot].type = type;
+	cache->entries[slot].len = (uint8_t)len;
+	for (uint16_t i = 0; i < len; i++) {
+		cache->entries[slot].value[i] = value[i];
+	}
+	cache->forwarded++;
+	return true;
+}
+
+// Forgets all cached camera control values
+void atem_cc_cache_reset(struct atem_cc_cache* cache) {
+	assert(cache != NULL);
+	for (uint32_t i = 0; i < ATEM_CC_CACHE_LEN; i++) {
+		cache->entries[i].len = 0;
 	}
 }
@@ -28,6 +28,69 @@
 #define ATEM_THREAD_SAFE (0)
 #endif // ATEM_THREAD_SAFE
 
+/**
+ * Defines if the buffers pointed to by @ref atem.write_buf are owned by each context or shared between contexts.
+ * Shared static buffers are used by default but each context can own its buffers by defining this macro to a truthy value.
+ * When enabled, @ref atem.write_buf is only invalidated by calls using the same context,
+ * allowing a single thread to drive multiple connections, and makes @ref ATEM_THREAD_SAFE redundant.
+ * @attention Has to be defined to the same value in all translation units since it changes the layout of @ref atem.
+ * @attention Contexts can not be moved or copied while enabled since @ref atem.write_buf points into the context.
+ */
+#ifndef ATEM_WRITE_BUF_CONTEXT
+#define ATEM_WRITE_BUF_CONTEXT (0)
+#endif // ATEM_WRITE_BUF_CONTEXT
+
+/**
+ * Defines if @ref atem.read_buf is embedded in the ATEM context or not.
+ * The read buffer is included by default but can be excluded by defining this macro to a falsy value.
+ * Without the read buffer, packets can only be parsed from caller-owned buffers using atem_parse_buf(),
+ * reducing the size of each context by @ref ATEM_PACKET_LEN_MAX bytes.
+ * @attention Has to be defined to the same value in all translation units since it changes the layout of @ref atem.
+ */
+#ifndef ATEM_READ_BUF
+#define ATEM_READ_BUF (1)
+#endif // ATEM_READ_BUF
+
+/**
+ * Defines number of ahead-of-sequence packets held in the ATEM context until packets missing before them are received.
+ * Reordering is disabled by default but can be enabled by defining this macro to a power of two.
+ * When enabled, only the first packet ahead of a gap in the sequence requests a retransmit,
+ * and held packets are released in order with atem_parse_reordered() once the gap is filled.
+ * Each held packet uses @ref ATEM_REORDER_PACKET_LEN bytes of the context.
+ * @attention Has to be defined to the same value in all translation units since it changes the layout of @ref atem.
+ */
+#ifndef ATEM_REORDER_WINDOW
+#define ATEM_REORDER_WINDOW (0)
+#endif // ATEM_REORDER_WINDOW
+
+/**
+ * Maximum length of a packet held by @ref ATEM_REORDER_WINDOW, longer packets are requested to be retransmitted.
+ * @attention Has to be defined to the same value in all translation units since it changes the layout of @ref atem.
+ */
+#ifndef ATEM_REORDER_PACKET_LEN
+#define ATEM_REORDER_PACKET_LEN ATEM_PACKET_LEN_MAX_SOFT
+#endif // ATEM_REORDER_PACKET_LEN
+
+/**
+ * Defines number of outbound packets the ATEM context can queue, including packets sent but not yet acknowledged.
+ * Sending commands is disabled by default but can be enabled by defining this macro to a truthy value.
+ * Commands enqueued with atem_cmd_enqueue() are batched into packets and transmitted with atem_send_poll().
+ * Each queued packet uses @ref ATEM_SEND_PACKET_LEN bytes of the context.
+ * Queued commands are dropped when a new connection is opened.
+ * @attention Has to be defined to the same value in all translation units since it changes the layout of @ref atem.
+ */
+#ifndef ATEM_SEND_WINDOW
+#define ATEM_SEND_WINDOW (0)
+#endif // ATEM_SEND_WINDOW
+
+/**
+ * Maximum length of a packet queued by @ref ATEM_SEND_WINDOW.
+ * @attention Has to be defined to the same value in all translation units since it changes the layout of @ref atem.
+ */
+#ifndef ATEM_SEND_PACKET_LEN
+#define ATEM_SEND_PACKET_LEN ATEM_PACKET_LEN_MAX_SOFT
+#endif // ATEM_SEND_PACKET_LEN
+
 /**
  * Default port for ATEM
  */
@@ -45,6 +108,24 @@
  */
 #define ATEM_TIMEOUT_MS (ATEM_TIMEOUT * 1000)
 
+/**
+ * Number of milliseconds without receiving any packet before a connection is
+ * considered dropped. The ATEM switcher pings every 500 ms, so the default
+ * detects a dead connection after three missed pings instead of waiting for
+ * the full @ref ATEM_TIMEOUT_MS.
+ */
+#ifndef ATEM_LIVENESS_TIMEOUT_MS
+#define ATEM_LIVENESS_TIMEOUT_MS 1500
+#endif // ATEM_LIVENESS_TIMEOUT_MS
+
+/**
+ * Number of milliseconds to wait for a response to the first opening handshake
+ * before retrying, doubled for every retry up to @ref ATEM_TIMEOUT_MS.
+ */
+#ifndef ATEM_RECONNECT_DELAY_MS
+#define ATEM_RECONNECT_DELAY_MS 500
+#endif // ATEM_RECONNECT_DELAY_MS
+
 /**
  * Maximum size of an ATEM packet, used by @ref atem.read_buf.
  */
@@ -55,11 +136,45 @@
  */
 #define ATEM_PACKET_LEN_MAX_SOFT (1422)
 
+/**
+ * Maximum number of inputs tracked by @ref atem_tally, covers every camera identifier in @ref atem.dest.
+ */
+#define ATEM_TALLY_INPUTS_MAX 256
+
+/**
+ * Number of 32 bit words in each bitset of @ref atem_tally.
+ */
+#define ATEM_TALLY_WORDS (ATEM_TALLY_INPUTS_MAX / 32)
+
+/**
+ * Maximum number of commands that fits in a single ATEM packet, used for sizing @ref atem_cmd_entry arrays.
+ */
+#define ATEM_CMD_INDEX_MAX ((ATEM_PACKET_LEN_MAX - 12) / 8)
+
+/**
+ * Number of camera control parameters remembered by @ref atem_cc_cache.
+ * Parameters hashing to the same slot replace each other, only reducing the number of suppressed updates.
+ */
+#ifndef ATEM_CC_CACHE_LEN
+#define ATEM_CC_CACHE_LEN (32)
+#endif // ATEM_CC_CACHE_LEN
+
+/**
+ * Maximum length of camera control values remembered by @ref atem_cc_cache, longer values are never suppressed.
+ */
+#define ATEM_CC_CACHE_VALUE_LEN 8
+
 /**
  * Converts a command name from 4 characters to a 32bit integer
  */
 #define ATEM_CMDNAME(a, b, c, d) ((a << 24) | (b << 16) | (c << 8) | (d))
 
+/**
+ * Gets the bit for a command name in @ref atem.cmd_filter.
+ * Command names are hashed into 32 bits, so unrelated commands can share a bit with a filtered command.
+ */
+#define ATEM_CMD_FILTER_BIT(name) ((uint32_t)1 << ((uint32_t)(((uint32_t)(name) ^ ((uint32_t)(name) >> 16)) * 0x9e3779b1u) >> 27))
+
 /**
  * ATEM packet commands returned from atem_cmd_next(). Consists of 4
  * ascii characters but are here represented as a single 32bit
@@ -80,9 +195,17 @@ enum atem_commands {
 	/**
 	 * Contains camera control data. Can be transformed from ATEM protocol
 	 * structure to Blackmagic SDI Camera Control Protocol structure with
-	 * atem_cc_translate().
+	 * atem_cc_translate() or atem_cc_translate_buf().
+	 */
+	ATEM_CMDNAME_CAMERACONTROL = ATEM_CMDNAME('C', 'C', 'd', 'P'),
+	/**
+	 * Contains the source in program for a mix effect bus.
+	 */
+	ATEM_CMDNAME_PROGRAM = ATEM_CMDNAME('P', 'r', 'g', 'I'),
+	/**
+	 * Contains the source in preview for a mix effect bus.
 	 */
-	ATEM_CMDNAME_CAMERACONTROL = ATEM_CMDNAME('C', 'C', 'd', 'P')
+	ATEM_CMDNAME_PREVIEW = ATEM_CMDNAME('P', 'r', 'v', 'I')
 };
 
 /**
@@ -142,14 +265,27 @@ typedef struct atem {
 	/**
 	 * Outgoing ATEM packet to transmit if result from @ref atem_parse indicates to do so.
 	 * @attention Only valid after calling @ref atem_connection_open, @ref atem_connection_close or @ref atem_parse.
-	 * Calling these functions also invalidates the @ref atem.write_buf for every other context in the same thread.
+	 * Calling these functions also invalidates the @ref atem.write_buf for every other context in the same thread,
+	 * unless @ref ATEM_WRITE_BUF_CONTEXT is enabled.
 	 */
 	uint8_t* write_buf;
 	/**
-	 * Pointer to command payload located in @ref atem.read_buf
+	 * Pointer to the ATEM packet being parsed, either @ref atem.read_buf or a caller-owned buffer
+	 * @attention Only valid after calling @ref atem_parse or @ref atem_parse_buf and as long as the parsed buffer is
+	 */
+	uint8_t* parse_buf;
+	/**
+	 * Pointer to command payload located in @ref atem.parse_buf
 	 * @attention Only valid after call to @ref atem_cmd_next
 	 */
 	uint8_t* cmd_payload_buf;
+	/**
+	 * Bits from @ref ATEM_CMD_FILTER_BIT for commands returned by @ref atem_cmd_next, 0 to return all commands.
+	 * Commands without their bit set are skipped without being returned, making it cheap to ignore
+	 * most of the state dump sent when connecting. Since bits can be shared between commands, returned
+	 * commands still have to be checked by name.
+	 */
+	uint32_t cmd_filter;
 	/**
 	 * Length of parsed ATEM packet
 	 * @attention Only valid when @ref atem_parse returns @ref ATEM_STATUS_WRITE
@@ -176,16 +312,38 @@ typedef struct atem {
 	 * Last acknowledged remote id
 	 */
 	uint16_t remote_id_last;
+	/**
+	 * @private
+	 * Session id of last parsed packet, used when closing the session
+	 */
+	uint16_t session_id;
+	/**
+	 * @private
+	 * Session id proposed by client in opening handshake, kept for retransmits of the same handshake
+	 */
+	uint16_t session_id_open;
 	/**
 	 * Camera ID to filter data for
 	 * @attention Has to be set before first call to @ref atem_tally_updated if it is to be used 
 	 */
 	uint8_t dest;
+	/**
+	 * @private
+	 * Number of opening handshake retries since last accepted connection, used by @ref atem_reconnect_delay
+	 */
+	uint8_t reconnect_attempts;
+	/**
+	 * @private
+	 * Indicates packets parsed by @ref atem_parse_batch are waiting for a cumulative acknowledgement
+	 */
+	bool ack_deferred;
+#if ATEM_READ_BUF
 	/**
 	 * Buffer of ATEM UDP packet to parse with @ref atem_parse
 	 * @attention Caller is responsible for filling this buffer before calling @ref atem_parse
 	 */
 	uint8_t read_buf[ATEM_PACKET_LEN_MAX];
+#endif // ATEM_READ_BUF
 	/**
 	 * State of PVW tally, updated from @ref atem_tally_updated.
 	 * Can safely be accessed at any point
@@ -196,8 +354,144 @@ typedef struct atem {
 	 * Can safely be accessed at any point
 	 */
 	bool tally_pgm;
+#if ATEM_WRITE_BUF_CONTEXT
+	/**
+	 * @private
+	 * Response buffers owned by the context that @ref atem.write_buf points to
+	 */
+	struct {
+		uint8_t open[20];
+		uint8_t close[20];
+		uint8_t ack[12];
+		uint8_t retxreq[12];
+	} write_bufs;
+#endif // ATEM_WRITE_BUF_CONTEXT
+#if ATEM_REORDER_WINDOW
+	/**
+	 * @private
+	 * Packets received ahead of sequence, indexed by remote id modulo @ref ATEM_REORDER_WINDOW
+	 */
+	struct {
+		uint16_t len[ATEM_REORDER_WINDOW];
+		uint8_t buf[ATEM_REORDER_WINDOW][ATEM_REORDER_PACKET_LEN];
+	} reorder;
+#endif // ATEM_REORDER_WINDOW
+#if ATEM_SEND_WINDOW
+	/**
+	 * @private
+	 * Ring of outbound packets, starting with the oldest unacknowledged packet followed by packets not yet sent
+	 */
+	struct {
+		uint8_t buf[ATEM_SEND_WINDOW][ATEM_SEND_PACKET_LEN];
+		uint32_t sent_at[ATEM_SEND_WINDOW];
+		uint16_t len[ATEM_SEND_WINDOW];
+		uint16_t head;
+		uint16_t count;
+		uint16_t sent;
+		uint16_t local_id_last;
+	} send;
+	/**
+	 * Queued ATEM packet to transmit if result from @ref atem_send_poll indicates to do so.
+	 * Separate from @ref atem.write_buf since that has to keep pointing at the last response from @ref atem_parse.
+	 * @attention Only valid until the next call to @ref atem_cmd_enqueue, @ref atem_parse,
+	 * @ref atem_connection_open or @ref atem_connection_close.
+	 */
+	uint8_t* send_buf;
+	/**
+	 * Length of queued ATEM packet pointed to by @ref atem.send_buf
+	 * @attention Same validity conditions as @ref atem.send_buf
+	 */
+	uint16_t send_len;
+#endif // ATEM_SEND_WINDOW
 } atem_t;
 
+/**
+ * Tally states for all inputs packed into bitsets, updated from @ref atem_tally_all_updated.
+ * Bit `n` in each bitset represents camera identifier `n + 1`, use @ref atem_tally_pgm,
+ * @ref atem_tally_pvw and @ref atem_tally_changed to access a single input.
+ */
+struct atem_tally {
+	/**
+	 * Bitset of inputs in PGM
+	 */
+	uint32_t pgm[ATEM_TALLY_WORDS];
+	/**
+	 * Bitset of inputs in PVW and not in PGM
+	 */
+	uint32_t pvw[ATEM_TALLY_WORDS];
+	/**
+	 * Bitset of inputs with PGM or PVW state changed by the last update
+	 */
+	uint32_t changed[ATEM_TALLY_WORDS];
+	/**
+	 * Number of inputs in the last tally command
+	 */
+	uint16_t len;
+};
+
+/**
+ * Location of a command in the parsed ATEM packet, filled in by @ref atem_cmd_index.
+ */
+struct atem_cmd_entry {
+	/**
+	 * Name of the command as a 32 bit integer, same as returned from @ref atem_cmd_next
+	 */
+	uint32_t name;
+	/**
+	 * Offset of command payload in @ref atem.parse_buf
+	 */
+	uint16_t offset;
+	/**
+	 * Length of command payload
+	 */
+	uint16_t len;
+};
+
+/**
+ * Last value assigned to a camera control parameter in @ref atem_cc_cache.
+ */
+struct atem_cc_cache_entry {
+	/**
+	 * Camera control category of the cached parameter
+	 */
+	uint8_t category;
+	/**
+	 * Camera control parameter within @ref atem_cc_cache_entry.category
+	 */
+	uint8_t parameter;
+	/**
+	 * Camera control data type of the value
+	 */
+	uint8_t type;
+	/**
+	 * Number of bytes in @ref atem_cc_cache_entry.value, 0 if entry is unused
+	 */
+	uint8_t len;
+	/**
+	 * Last assigned value in the big endian byte order used by the ATEM protocol
+	 */
+	uint8_t value[ATEM_CC_CACHE_VALUE_LEN];
+};
+
+/**
+ * Last camera control values assigned to @ref atem.dest, updated from @ref atem_cc_cache_changed.
+ * Used to drop camera control updates that would not change anything before writing them to the camera.
+ */
+struct atem_cc_cache {
+	/**
+	 * Last assigned value for each cached parameter, an entry with length 0 is unused
+	 */
+	struct atem_cc_cache_entry entries[ATEM_CC_CACHE_LEN];
+	/**
+	 * Number of camera control updates dropped for not changing the cached value
+	 */
+	uint32_t suppressed;
+	/**
+	 * Number of camera control updates that should be written to the camera
+	 */
+	uint32_t forwarded;
+};
+
 // Makes functions available in C++
 #ifdef __cplusplus
 extern "C" {
@@ -219,9 +513,29 @@ extern "C" {
  * Close any existing connection before resetting, or reset as a response
  * to the prior connection being dropped.
  *
+ * A new session id is proposed from @p random for every new opening handshake,
+ * so devices booting at the same time do not collide on the switcher. Calling
+ * this again before the handshake is completed retransmits the same handshake
+ * with the same session id.
+ *
  * @param[in,out] atem The atem connection context to reset the connection for.
+ * @param random Random value used to pick the session id between 1 and 0x7fff proposed to the switcher.
  */
-void atem_connection_open(struct atem* atem);
+void atem_connection_open(struct atem* atem, uint32_t random);
+
+/**
+ * @brief Gets delay before retrying an opening handshake that got no response.
+ *
+ * Starts at @ref ATEM_RECONNECT_DELAY_MS and doubles for every call until the
+ * connection is accepted, capped at @ref ATEM_TIMEOUT_MS. The delay is jittered
+ * down to half its value so devices dropped at the same time do not reconnect
+ * in lockstep.
+ *
+ * @param[in,out] atem The atem connection context to get the delay for.
+ * @param random Random value used to jitter the delay.
+ * @returns Number of milliseconds to wait before calling atem_connection_open() again.
+ */
+uint32_t atem_reconnect_delay(struct atem* atem, uint32_t random);
 
 /**
  * @brief Requests the ATEM connection to close.
@@ -238,6 +552,7 @@ void atem_connection_open(struct atem* atem);
  */
 void atem_connection_close(struct atem* atem);
 
+#if ATEM_READ_BUF
 /**
  * @brief Parses the ATEM packet available in @ref atem.read_buf.
  *
@@ -257,6 +572,117 @@ void atem_connection_close(struct atem* atem);
  * @returns Describes the basic purpose of the received ATEM packet.
  */
 enum atem_status atem_parse(struct atem* atem);
+#endif // ATEM_READ_BUF
+
+/**
+ * @brief Parses an ATEM packet located in a caller-owned buffer without copying it.
+ *
+ * Works the same as atem_parse() but reads the packet directly from @p buf,
+ * allowing a network stacks receive buffer to be parsed in place.
+ * Commands in the packet are accessed through atem_cmd_next() as usual.
+ *
+ * @attention The buffer has to remain valid and unmodified by anything else than
+ * this API for as long as commands or command payloads are being accessed.
+ * @attention Camera control translation with atem_cc_translate() rewrites the
+ * buffer in place.
+ *
+ * @param[in,out] atem The atem connection context to parse the data for.
+ * @param[in,out] buf Buffer containing the ATEM UDP packet to parse.
+ * @param len Number of bytes received in @p buf.
+ * @returns Describes the basic purpose of the received ATEM packet,
+ * @ref ATEM_STATUS_ERROR if the packet is shorter than its header indicates.
+ */
+enum atem_status atem_parse_buf(struct atem* atem, uint8_t* buf, uint16_t len);
+
+/**
+ * @brief Parses a batch of received ATEM packets, acknowledging them with a single cumulative acknowledgement.
+ *
+ * Parses packets from @p bufs one at a time starting at @p index, returning
+ * the status of every packet the caller has to act on. Instead of one
+ * acknowledgement per packet, a single acknowledgement for the last remote id
+ * received in sequence is returned as @ref ATEM_STATUS_WRITE_ONLY after the
+ * last packet in the batch, since the ATEM protocol acknowledges cumulatively.
+ * Should be called until it returns @ref ATEM_STATUS_NONE, processing commands
+ * with atem_cmd_next() every time it returns @ref ATEM_STATUS_WRITE.
+ * Packets held by @ref ATEM_REORDER_WINDOW are released as part of the batch.
+ *
+ * @attention @ref atem.write_buf should be sent for every returned status it would
+ * be sent for with atem_parse(), except @ref ATEM_STATUS_WRITE since its
+ * acknowledgement is deferred.
+ * @attention Every buffer has the same requirements as for atem_parse_buf() and
+ * has to remain valid until this function returns @ref ATEM_STATUS_NONE.
+ *
+ * @param[in,out] atem The atem connection context to parse the data for.
+ * @param[in,out] bufs Buffers containing the received ATEM UDP packets.
+ * @param[in] lens Number of bytes received in each buffer of @p bufs.
+ * @param count Number of packets in the batch.
+ * @param[in,out] index Index of next packet in @p bufs to parse, start at 0.
+ * @returns Describes the basic purpose of the parsed ATEM packet or the cumulative
+ * acknowledgement, @ref ATEM_STATUS_NONE when the batch is done.
+ */
+enum atem_status atem_parse_batch(struct atem* atem, uint8_t* const bufs[], const uint16_t lens[], uint16_t count, uint16_t* index);
+
+#if ATEM_REORDER_WINDOW
+/**
+ * @brief Parses next packet held by @ref ATEM_REORDER_WINDOW if it is now in sequence.
+ *
+ * Should be called after commands of a packet where atem_parse() returned
+ * @ref ATEM_STATUS_WRITE have been processed, until it no longer returns
+ * @ref ATEM_STATUS_WRITE. Each released packet is processed the same way as if
+ * atem_parse() returned the status.
+ *
+ * @param[in,out] atem The atem connection context containing the held packets.
+ * @returns @ref ATEM_STATUS_WRITE if a held packet was released or @ref ATEM_STATUS_NONE otherwise.
+ */
+enum atem_status atem_parse_reordered(struct atem* atem);
+#else // ATEM_REORDER_WINDOW
+static inline enum atem_status atem_parse_reordered(struct atem* atem) {
+	assert(atem != NULL);
+	(void)atem;
+	return ATEM_STATUS_NONE;
+}
+#endif // ATEM_REORDER_WINDOW
+
+#if ATEM_SEND_WINDOW
+/**
+ * @brief Enqueues a command to send to the ATEM switcher.
+ *
+ * Commands enqueued between calls to atem_send_poll() are batched into as few
+ * packets as possible. The returned payload buffer has to be filled in before
+ * the next call to atem_send_poll().
+ *
+ * @param[in,out] atem The atem connection context to enqueue the command in.
+ * @param name Command name as a 32 bit integer, can be constructed with ATEM_CMDNAME().
+ * @param len Length of the command payload.
+ * @returns Pointer to the command payload buffer to fill in or NULL if the queue is full
+ * or the command does not fit in a packet of @ref ATEM_SEND_PACKET_LEN bytes.
+ */
+uint8_t* atem_cmd_enqueue(struct atem* atem, uint32_t name, uint16_t len);
+
+/**
+ * @brief Gets next queued packet to transmit to the ATEM switcher.
+ *
+ * Sets @ref atem.send_buf to the next packet to transmit, either a packet not yet
+ * sent or an unacknowledged packet due for retransmission. Should be called until
+ * it returns @ref ATEM_STATUS_NONE, sending @ref atem.send_buf every time it
+ * returns @ref ATEM_STATUS_WRITE_ONLY. Packets are only sent when connected,
+ * and the queue is dropped when the connection is closed or reopened.
+ *
+ * @param[in,out] atem The atem connection context containing the queue.
+ * @param now Current time in milliseconds from a monotonic clock, allowed to wrap around.
+ * @returns @ref ATEM_STATUS_WRITE_ONLY if there is a packet to send or @ref ATEM_STATUS_NONE otherwise.
+ */
+enum atem_status atem_send_poll(struct atem* atem, uint32_t now);
+
+/**
+ * @brief Gets time until atem_send_poll() has a packet to send.
+ * @param[in] atem The atem connection context containing the queue.
+ * @param now Current time in milliseconds from the same clock as used for atem_send_poll().
+ * @returns Number of milliseconds to wait, 0 if a packet is ready to be sent
+ * or UINT32_MAX if there are no packets queued.
+ */
+uint32_t atem_send_wait(struct atem* atem, uint32_t now);
+#endif // ATEM_SEND_WINDOW
 
 /**
  * @brief Checks if there are any commands available to process.
@@ -284,6 +710,7 @@ static inline bool atem_cmd_available(struct atem* atem) {
  * commands in the ATEM packet.
  * Some commands are available in @ref atem_commands.
  * Command names can be constructed using ATEM_CMDNAME() macro function.
+ * Commands not matching @ref atem.cmd_filter are skipped.
  * 
  * @attention This function can ONLY be called when atem_parse() returns
  * @ref ATEM_STATUS_WRITE.
@@ -291,10 +718,67 @@ static inline bool atem_cmd_available(struct atem* atem) {
  * returns true to indicate there is a command available in the ATEM packet.
  * 
  * @param[in,out] atem The atem connection context containing the parsed data.
- * @returns A command name as a 32 bit integer.
+ * @returns A command name as a 32 bit integer or 0 if the command header is malformed
+ * or no remaining command matches @ref atem.cmd_filter, ending the iteration.
  */
 uint32_t atem_cmd_next(struct atem* atem);
 
+/**
+ * @brief Validates all command headers and indexes them in a single pass.
+ *
+ * Alternative to iterating with atem_cmd_available() and atem_cmd_next(), useful
+ * for large packets where only a few commands are of interest. Commands are
+ * written to @p entries in packet order. Use atem_cmd_index_find() to look up a
+ * command by name and atem_cmd_index_select() to process it like it was
+ * returned from atem_cmd_next().
+ *
+ * @attention This function can ONLY be called when atem_parse() returns
+ * @ref ATEM_STATUS_WRITE.
+ *
+ * @param[in] atem The atem connection context containing the parsed data.
+ * @param[out] entries Array to index commands in, can hold all commands if it has @ref ATEM_CMD_INDEX_MAX elements.
+ * @param entries_len Number of elements in @p entries.
+ * @returns Number of commands in the packet, only the first @p entries_len are indexed if it is larger,
+ * or -1 if any command header is malformed.
+ */
+int atem_cmd_index(struct atem* atem, struct atem_cmd_entry* entries, uint16_t entries_len);
+
+/**
+ * @brief Finds the first indexed command with the given name.
+ * @param[in] entries Commands indexed by atem_cmd_index().
+ * @param entries_len Number of indexed commands in @p entries.
+ * @param name Command name to look for.
+ * @returns Pointer to the indexed command or NULL if it is not in the index.
+ */
+static inline const struct atem_cmd_entry* atem_cmd_index_find(const struct atem_cmd_entry* entries, uint16_t entries_len, uint32_t name) {
+	assert(entries != NULL || entries_len == 0);
+	for (uint16_t i = 0; i < entries_len; i++) {
+		if (entries[i].name == name) return &entries[i];
+	}
+	return NULL;
+}
+
+/**
+ * @brief Selects an indexed command for processing.
+ *
+ * Sets @ref atem.cmd_payload_buf and @ref atem.cmd_payload_len to the indexed
+ * command, making functions requiring a command returned from atem_cmd_next()
+ * available for it.
+ *
+ * @param[in,out] atem The atem connection context containing the parsed data.
+ * @param[in] entry Command indexed by atem_cmd_index() for the same parsed packet.
+ * @returns The command name as a 32 bit integer.
+ */
+static inline uint32_t atem_cmd_index_select(struct atem* atem, const struct atem_cmd_entry* entry) {
+	assert(atem != NULL);
+	assert(entry != NULL);
+	assert(atem->parse_buf != NULL);
+	assert((entry->offset + entry->len) <= atem->read_len);
+	atem->cmd_payload_buf = &atem->parse_buf[entry->offset];
+	atem->cmd_payload_len = entry->len;
+	return entry->name;
+}
+
 /**
  * @brief Gets the major version of the ATEM protocol from @ref ATEM_CMDNAME_VERSION
  * command in ATEM protocol.
@@ -340,6 +824,59 @@ static inline uint16_t atem_protocol_minor(struct atem* atem) {
  */
 bool atem_tally_updated(struct atem* atem);
 
+/**
+ * @brief Gets tally status for all inputs from @ref ATEM_CMDNAME_TALLY command in ATEM packet.
+ *
+ * Decodes the tally states of every input in a single pass into the bitsets in
+ * @p tally and marks inputs whose state differs from the previous update in
+ * @ref atem_tally.changed. Zero initialize @p tally before its first update.
+ * Inputs beyond @ref ATEM_TALLY_INPUTS_MAX are ignored.
+ *
+ * @attention This function can ONLY be called when atem_cmd_next() returns
+ * the command name @ref ATEM_CMDNAME_TALLY.
+ *
+ * @param[in] atem The atem connection context containing the parsed data.
+ * @param[in,out] tally The tally states to update.
+ * @returns Indicates if the tally state changed for any input.
+ */
+bool atem_tally_all_updated(struct atem* atem, struct atem_tally* tally);
+
+/**
+ * @brief Checks if an input is in PGM in tally states updated by atem_tally_all_updated().
+ * @param[in] tally The tally states to read from.
+ * @param dest Camera identifier of the input, starting at 1.
+ * @returns Indicates if the input is in PGM.
+ */
+static inline bool atem_tally_pgm(const struct atem_tally* tally, uint8_t dest) {
+	assert(tally != NULL);
+	assert(dest > 0);
+	return (tally->pgm[(dest - 1) / 32] >> ((dest - 1) % 32)) & 1;
+}
+
+/**
+ * @brief Checks if an input is in PVW in tally states updated by atem_tally_all_updated().
+ * @param[in] tally The tally states to read from.
+ * @param dest Camera identifier of the input, starting at 1.
+ * @returns Indicates if the input is in PVW and not in PGM.
+ */
+static inline bool atem_tally_pvw(const struct atem_tally* tally, uint8_t dest) {
+	assert(tally != NULL);
+	assert(dest > 0);
+	return (tally->pvw[(dest - 1) / 32] >> ((dest - 1) % 32)) & 1;
+}
+
+/**
+ * @brief Checks if an inputs tally state changed in the last call to atem_tally_all_updated().
+ * @param[in] tally The tally states to read from.
+ * @param dest Camera identifier of the input, starting at 1.
+ * @returns Indicates if the inputs PGM or PVW state changed.
+ */
+static inline bool atem_tally_changed(const struct atem_tally* tally, uint8_t dest) {
+	assert(tally != NULL);
+	assert(dest > 0);
+	return (tally->changed[(dest - 1) / 32] >> ((dest - 1) % 32)) & 1;
+}
+
 /**
  * @brief Checks dest in the @ref ATEM_CMDNAME_CAMERACONTROL command in ATEM packet.
  * 
@@ -369,13 +906,89 @@ static inline bool atem_cc_updated(struct atem* atem) {
  * 
  * @attention This function can ONLY be called when atem_cmd_next() returns
  * the command name @ref ATEM_CMDNAME_CAMERACONTROL.
- * @attention The transformed data is still located inside the @ref atem.read_buf
+ * @attention The transformed data is still located inside the @ref atem.parse_buf
  * and will therefore be overwritten when parsing next packet.
  * 
  * @param[in,out] atem The atem connection context containing the parsed data.
  */
 void atem_cc_translate(struct atem* atem);
 
+/**
+ * @brief Translates camera control data for @ref ATEM_CMDNAME_CAMERACONTROL command
+ * in ATEM packet into a separate buffer.
+ *
+ * Same translation as atem_cc_translate() but writes the Blackmagic SDI Camera
+ * Control Protocol data to @p buf without modifying the parsed packet. Calling it
+ * for every camera control command in a packet with @p buf pointing right after
+ * the previously translated data gathers them into a single contiguous buffer
+ * that can be transmitted at once.
+ *
+ * @attention This function can ONLY be called when atem_cmd_next() returns
+ * the command name @ref ATEM_CMDNAME_CAMERACONTROL.
+ *
+ * @param[in] atem The atem connection context containing the parsed data.
+ * @param[out] buf Buffer to write translated data to.
+ * @param size Number of bytes available in @p buf.
+ * @returns Number of bytes written to @p buf, 0 if the translated data does not fit
+ * or the command payload is malformed.
+ */
+uint16_t atem_cc_translate_buf(struct atem* atem, uint8_t* buf, uint16_t size);
+
+/**
+ * @brief Checks if camera control data for @ref ATEM_CMDNAME_CAMERACONTROL command
+ * in ATEM packet changes anything on the camera.
+ *
+ * ATEM switchers regularly resend camera control values that have not changed.
+ * Absolute assignments of a value identical to the last one assigned to the same
+ * category and parameter are dropped and counted in @ref atem_cc_cache.suppressed.
+ * Relative offsets, values without data and values longer than
+ * @ref ATEM_CC_CACHE_VALUE_LEN are always reported as changed, with relative
+ * offsets forgetting the cached value since the result is not known.
+ *
+ * @attention This function can ONLY be called when atem_cmd_next() returns
+ * the command name @ref ATEM_CMDNAME_CAMERACONTROL and should only be called
+ * for commands where atem_cc_updated() returns true.
+ * @attention The cache has to be cleared with atem_cc_cache_reset() when the
+ * camera state can no longer be assumed to match it, like after reconnecting.
+ *
+ * @param[in] atem The atem connection context containing the parsed data.
+ * @param[in,out] cache Last camera control values assigned.
+ * @returns Indicates if the camera control data should be translated and written to the camera.
+ */
+bool atem_cc_cache_changed(struct atem* atem, struct atem_cc_cache* cache);
+
+/**
+ * @private
+ * @brief Gets index in @ref atem_cc_cache.entries that a camera control parameter is cached in.
+ */
+static inline uint32_t atem_cc_cache_slot(uint8_t category, uint8_t parameter) {
+	// Mixes bits with golden ratio multiplier and maps upper bits to slot, spreading parameters in nearby categories
+	const uint32_t hash = ((uint32_t)category << 8 | parameter) * 0x9e3779b1u;
+	return (uint32_t)(((uint64_t)hash * ATEM_CC_CACHE_LEN) >> 32);
+}
+
+/**
+ * @brief Gets last value assigned to a camera control parameter in the cache.
+ * @param[in] cache Camera control cache updated by atem_cc_cache_changed().
+ * @param category Camera control category of the parameter.
+ * @param parameter Camera control parameter within @p category.
+ * @returns Cached entry for the parameter or NULL if its value is not known.
+ */
+static inline const struct atem_cc_cache_entry* atem_cc_cache_get(const struct atem_cc_cache* cache, uint8_t category, uint8_t parameter) {
+	assert(cache != NULL);
+	const struct atem_cc_cache_entry* const entry = &cache->entries[atem_cc_cache_slot(category, parameter)];
+	if (entry->len == 0 || entry->category != category || entry->parameter != parameter) {
+		return NULL;
+	}
+	return entry;
+}
+
+/**
+ * @brief Forgets all camera control values in the cache without clearing counters.
+ * @param[out] cache Camera control cache to clear.
+ */
+void atem_cc_cache_reset(struct atem_cc_cache* cache);
+
 // Ends extern C block
 #ifdef __cplusplus
 }
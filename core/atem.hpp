@@ -0,0 +1,130 @@
+/**
+ * @file
+ * @brief Header-only C++17 bindings for the ATEM core API
+ *
+ * Commands are dispatched through a list of handlers given as template
+ * parameters, generating the same comparisons as a hand-written switch with no
+ * virtual calls or allocations:
+ *
+ *     void handle_tally(struct atem& atem, waccat::payload payload);
+ *     using dispatch = waccat::dispatcher<
+ *         waccat::command<ATEM_CMDNAME_TALLY, 2, handle_tally>
+ *     >;
+ *     atem.cmd_filter = dispatch::filter;
+ *     dispatch::process(atem);
+ *
+ * Handlers take the ATEM context and a view of the command payload, pointing
+ * directly into the parsed packet. Registering the same command twice fails to compile.
+ */
+
+// Include guard
+#ifndef ATEM_HPP
+#define ATEM_HPP
+
+#include <cstddef> // std::size_t
+#include <cstdint> // uint8_t, uint16_t, uint32_t
+
+#include "./atem.h" // struct atem, atem_cmd_available, atem_cmd_next, ATEM_CMD_FILTER_BIT
+
+namespace waccat {
+
+/**
+ * @brief View of a command payload inside a parsed ATEM packet.
+ * @attention Only valid until the next command is read from the ATEM context.
+ */
+class payload {
+	uint8_t* buf;
+	uint16_t len;
+
+public:
+	/** Creates view of @p payload_len bytes starting at @p payload_buf. */
+	constexpr payload(uint8_t* payload_buf, uint16_t payload_len) noexcept : buf(payload_buf), len(payload_len) {}
+
+	/** Creates view of the payload of the last command read with atem_cmd_next(). */
+	explicit payload(struct atem& atem) noexcept : buf(atem.cmd_payload_buf), len(atem.cmd_payload_len) {}
+
+	/** Gets pointer to first byte of payload. */
+	constexpr uint8_t* data() const noexcept { return buf; }
+	/** Gets length of payload. */
+	constexpr uint16_t size() const noexcept { return len; }
+	/** Checks if payload has no data. */
+	constexpr bool empty() const noexcept { return len == 0; }
+	/** Gets byte at @p index without bounds checking. */
+	constexpr uint8_t& operator[](std::size_t index) const noexcept { return buf[index]; }
+	/** Gets iterator to first byte of payload. */
+	constexpr uint8_t* begin() const noexcept { return buf; }
+	/** Gets iterator past last byte of payload. */
+	constexpr uint8_t* end() const noexcept { return buf + len; }
+
+	/** Gets big-endian 16 bit value at @p offset without bounds checking. */
+	constexpr uint16_t u16(std::size_t offset) const noexcept {
+		return static_cast<uint16_t>(buf[offset] << 8 | buf[offset + 1]);
+	}
+	/** Gets big-endian 32 bit value at @p offset without bounds checking. */
+	constexpr uint32_t u32(std::size_t offset) const noexcept {
+		return static_cast<uint32_t>(u16(offset)) << 16 | u16(offset + 2);
+	}
+};
+
+/**
+ * @brief Registers a handler for a command.
+ * @tparam Name Command name from ATEM_CMDNAME().
+ * @tparam LenMin Minimum payload length required by the handler, shorter commands are ignored.
+ * @tparam Handler Function called as `Handler(struct atem&, waccat::payload)`.
+ */
+template <uint32_t Name, uint16_t LenMin, auto Handler>
+struct command {
+	static constexpr uint32_t name = Name;
+	static constexpr uint16_t len_min = LenMin;
+
+	/** Calls handler if payload is long enough, returns true if handler was called. */
+	static bool dispatch(struct atem& atem, payload buf) {
+		if (buf.size() < LenMin) return false;
+		Handler(atem, buf);
+		return true;
+	}
+};
+
+/**
+ * @brief Dispatches commands to handlers registered with @ref command.
+ * @tparam Commands Command registrations, each command name can only be registered once.
+ */
+template <typename... Commands>
+struct dispatcher {
+private:
+	// Checks that no command name is registered more than once
+	static constexpr bool names_unique() {
+		constexpr uint32_t names[] = { Commands::name..., 0 };
+		for (std::size_t i = 0; i < sizeof...(Commands); i++) {
+			for (std::size_t j = i + 1; j < sizeof...(Commands); j++) {
+				if (names[i] == names[j]) return false;
+			}
+		}
+		return true;
+	}
+	static_assert(names_unique(), "Command registered more than once");
+
+public:
+	/** Command filter for @ref atem.cmd_filter skipping commands without a registered handler. */
+	static constexpr uint32_t filter = (static_cast<uint32_t>(0) | ... | ATEM_CMD_FILTER_BIT(Commands::name));
+
+	/**
+	 * @brief Calls handler registered for command.
+	 * @return True if a handler was called, false if command is not registered or its payload is too short.
+	 */
+	static bool dispatch(uint32_t name, struct atem& atem, payload buf) {
+		return ((name == Commands::name && Commands::dispatch(atem, buf)) || ...);
+	}
+
+	/** Dispatches all remaining commands in the last parsed packet. */
+	static void process(struct atem& atem) {
+		while (atem_cmd_available(&atem)) {
+			const uint32_t name = atem_cmd_next(&atem);
+			dispatch(name, atem, payload(atem));
+		}
+	}
+};
+
+} // namespace waccat
+
+#endif // ATEM_HPP
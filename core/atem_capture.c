@@ -0,0 +1,142 @@
+#include <stdbool.h> // bool, true, false
+#include <stdint.h> // uint8_t, uint16_t, uint64_t
+#include <stddef.h> // size_t, NULL
+#include <stdio.h> // FILE, fopen, fclose, fwrite, fread
+#include <string.h> // memcpy, memset, memcmp
+#include <assert.h> // assert
+#include <time.h> // struct timespec, clock_gettime, CLOCK_MONOTONIC, timespec_get, TIME_UTC
+
+#include <netinet/in.h> // struct sockaddr_in, AF_INET
+
+#include "./atem.h" // ATEM_PACKET_LEN_MAX
+#include "./atem_capture.h" // enum atem_capture_role, enum atem_capture_dir, struct atem_capture_record, ATEM_CAPTURE_VERSION, ATEM_CAPTURE_LEN_HEADER, ATEM_CAPTURE_LEN_RECORD
+
+// Magic value at the start of every capture file
+#define ATEM_CAPTURE_MAGIC "ATCP"
+
+// Flag for sent datagrams and mask for datagram length in the length field of a record
+#define ATEM_CAPTURE_FLAG_SEND 0x8000
+#define ATEM_CAPTURE_MASK_LEN 0x7fff
+
+// Gets nanoseconds from monotonic clock, falls back to wall clock where no monotonic clock is available
+static uint64_t atem_capture_time(void) {
+	struct timespec ts;
+#ifdef CLOCK_MONOTONIC
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#else // CLOCK_MONOTONIC
+	timespec_get(&ts, TIME_UTC);
+#endif // CLOCK_MONOTONIC
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// Creates capture file with file header
+FILE* atem_capture_open(const char* path, enum atem_capture_role role) {
+	assert(path != NULL);
+	assert(role == ATEM_CAPTURE_ROLE_CLIENT || role == ATEM_CAPTURE_ROLE_SERVER);
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	const uint8_t header[ATEM_CAPTURE_LEN_HEADER] = {
+		'A', 'T', 'C', 'P',
+		ATEM_CAPTURE_VERSION, (uint8_t)role, 0, 0
+	};
+	if (fwrite(header, sizeof(header), 1, file) != 1) {
+		fclose(file);
+		return NULL;
+	}
+
+	return file;
+}
+
+// Writes record header and datagram in a single write to keep records intact
+bool atem_capture_write(FILE* file, enum atem_capture_dir dir, const struct sockaddr_in* peer, const void* buf, size_t len) {
+	assert(file != NULL);
+	assert(dir == ATEM_CAPTURE_DIR_RECV || dir == ATEM_CAPTURE_DIR_SEND);
+	assert(buf != NULL);
+	assert(len <= ATEM_PACKET_LEN_MAX);
+
+	uint8_t record[ATEM_CAPTURE_LEN_RECORD + ATEM_PACKET_LEN_MAX];
+
+	// Sets timestamp
+	const uint64_t time = atem_capture_time();
+	for (int i = 0; i < 8; i++) {
+		record[i] = (uint8_t)(time >> ((7 - i) * 8));
+	}
+
+	// Sets peer address already in network byte order
+	if (peer != NULL) {
+		memcpy(&record[8], &peer->sin_addr.s_addr, 4);
+		memcpy(&record[12], &peer->sin_port, 2);
+	}
+	else {
+		memset(&record[8], 0, 6);
+	}
+
+	// Sets direction and length
+	const uint16_t len_field = (uint16_t)len | ((dir == ATEM_CAPTURE_DIR_SEND) ? ATEM_CAPTURE_FLAG_SEND : 0);
+	record[14] = (uint8_t)(len_field >> 8);
+	record[15] = (uint8_t)(len_field & 0xff);
+
+	memcpy(&record[ATEM_CAPTURE_LEN_RECORD], buf, len);
+	return fwrite(record, ATEM_CAPTURE_LEN_RECORD + len, 1, file) == 1;
+}
+
+// Opens capture file and validates its file header
+FILE* atem_capture_load(const char* path, enum atem_capture_role* role) {
+	assert(path != NULL);
+	assert(role != NULL);
+
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	uint8_t header[ATEM_CAPTURE_LEN_HEADER];
+	if (
+		fread(header, sizeof(header), 1, file) != 1 ||
+		memcmp(header, ATEM_CAPTURE_MAGIC, 4) ||
+		header[4] != ATEM_CAPTURE_VERSION ||
+		header[5] > ATEM_CAPTURE_ROLE_SERVER
+	) {
+		fclose(file);
+		return NULL;
+	}
+
+	*role = (enum atem_capture_role)header[5];
+	return file;
+}
+
+// Reads next record from capture file
+bool atem_capture_read(FILE* file, struct atem_capture_record* record) {
+	assert(file != NULL);
+	assert(record != NULL);
+
+	uint8_t header[ATEM_CAPTURE_LEN_RECORD];
+	if (fread(header, sizeof(header), 1, file) != 1) {
+		return false;
+	}
+
+	// Gets timestamp
+	record->time = 0;
+	for (int i = 0; i < 8; i++) {
+		record->time = record->time << 8 | header[i];
+	}
+
+	// Gets peer address
+	memset(&record->peer, 0, sizeof(record->peer));
+	record->peer.sin_family = AF_INET;
+	memcpy(&record->peer.sin_addr.s_addr, &header[8], 4);
+	memcpy(&record->peer.sin_port, &header[12], 2);
+
+	// Gets direction and datagram
+	const uint16_t len_field = (uint16_t)(header[14] << 8 | header[15]);
+	record->dir = (len_field & ATEM_CAPTURE_FLAG_SEND) ? ATEM_CAPTURE_DIR_SEND : ATEM_CAPTURE_DIR_RECV;
+	record->len = len_field & ATEM_CAPTURE_MASK_LEN;
+	if (record->len > ATEM_PACKET_LEN_MAX) {
+		return false;
+	}
+	return record->len == 0 || fread(record->buf, record->len, 1, file) == 1;
+}
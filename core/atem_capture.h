@@ -0,0 +1,132 @@
+/**
+ * @file
+ * @brief Recording and reading ATEM traffic capture files
+ *
+ * A capture file starts with an 8 byte file header followed by one record per datagram.
+ * All multi-byte values are stored in network byte order, the same as the ATEM protocol.
+ *
+ * File header:
+ * | Bytes | Description                                                 |
+ * | ----- | ----------------------------------------------------------- |
+ * | 0-3   | Magic value `ATCP`                                          |
+ * | 4     | Format version, @ref ATEM_CAPTURE_VERSION                   |
+ * | 5     | Role of recorder, @ref atem_capture_role                    |
+ * | 6-7   | Reserved, set to 0                                          |
+ *
+ * Record:
+ * | Bytes | Description                                                 |
+ * | ----- | ----------------------------------------------------------- |
+ * | 0-7   | Monotonic timestamp in nanoseconds                          |
+ * | 8-11  | IPv4 address of peer, 0 if not known                        |
+ * | 12-13 | UDP port of peer, 0 if not known                            |
+ * | 14-15 | Direction in highest bit (1 for sent) and datagram length   |
+ * | 16-   | Datagram as sent or received                                |
+ */
+
+// Include guard
+#ifndef ATEM_CAPTURE_H
+#define ATEM_CAPTURE_H
+
+#include <stdbool.h> // bool
+#include <stdint.h> // uint8_t, uint16_t, uint64_t
+#include <stddef.h> // size_t
+#include <stdio.h> // FILE
+
+#include <netinet/in.h> // struct sockaddr_in
+
+#include "./atem.h" // ATEM_PACKET_LEN_MAX
+
+/**
+ * Version of capture file format written by atem_capture_open().
+ */
+#define ATEM_CAPTURE_VERSION 1
+
+/**
+ * Length of capture file header.
+ */
+#define ATEM_CAPTURE_LEN_HEADER 8
+
+/**
+ * Length of header before each datagram in capture file.
+ */
+#define ATEM_CAPTURE_LEN_RECORD 16
+
+/**
+ * @brief Side of the ATEM connection the capture was recorded on.
+ */
+enum atem_capture_role {
+	/** Recorded by an ATEM client, received packets are from the switcher. */
+	ATEM_CAPTURE_ROLE_CLIENT = 0,
+	/** Recorded by an ATEM server such as the proxy, received packets are from clients. */
+	ATEM_CAPTURE_ROLE_SERVER = 1
+};
+
+/**
+ * @brief Direction of a captured datagram as seen by the recorder.
+ */
+enum atem_capture_dir {
+	ATEM_CAPTURE_DIR_RECV = 0,
+	ATEM_CAPTURE_DIR_SEND = 1
+};
+
+/**
+ * @brief Datagram read from a capture file.
+ */
+struct atem_capture_record {
+	/** Monotonic timestamp in nanoseconds when datagram was recorded. */
+	uint64_t time;
+	/** Address of peer in network byte order, 0 if not known. */
+	struct sockaddr_in peer;
+	/** Direction of datagram as seen by the recorder. */
+	enum atem_capture_dir dir;
+	/** Length of datagram in @ref buf. */
+	uint16_t len;
+	/** Datagram as sent or received. */
+	uint8_t buf[ATEM_PACKET_LEN_MAX];
+};
+
+// Makes functions available to C++ with extern C block
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Creates capture file and writes its file header.
+ * @param path Path of capture file to create, truncated if it already exists.
+ * @param role Side of the connection that is recording.
+ * @return Capture file to pass to atem_capture_write() and close with fclose(), NULL with `errno` set on failure.
+ */
+FILE* atem_capture_open(const char* path, enum atem_capture_role role);
+
+/**
+ * @brief Records a datagram with current monotonic timestamp to capture file.
+ * @param file Capture file from atem_capture_open().
+ * @param dir Direction of datagram as seen by the recorder.
+ * @param peer Address datagram was sent to or received from, NULL if not known.
+ * @param buf Datagram to record.
+ * @param len Length of datagram, not allowed to be more than @ref ATEM_PACKET_LEN_MAX.
+ * @return Indicates if record was written or not.
+ */
+bool atem_capture_write(FILE* file, enum atem_capture_dir dir, const struct sockaddr_in* peer, const void* buf, size_t len);
+
+/**
+ * @brief Opens capture file for reading and validates its file header.
+ * @param path Path of capture file to read.
+ * @param[out] role Set to side of the connection the capture was recorded on.
+ * @return Capture file to pass to atem_capture_read() and close with fclose(), NULL on failure.
+ */
+FILE* atem_capture_load(const char* path, enum atem_capture_role* role);
+
+/**
+ * @brief Reads next datagram from capture file.
+ * @param file Capture file from atem_capture_load().
+ * @param[out] record Set to the next datagram in capture file.
+ * @return True if a datagram was read, false at end of file or for truncated or invalid records.
+ */
+bool atem_capture_read(FILE* file, struct atem_capture_record* record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ATEM_CAPTURE_H
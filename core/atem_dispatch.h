@@ -0,0 +1,105 @@
+// Include guard
+#ifndef ATEM_DISPATCH_H
+#define ATEM_DISPATCH_H
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t
+#include <stdbool.h> // bool, true, false
+
+#include "./atem.h" // ATEM_CMD_FILTER_BIT
+
+/**
+ * @file
+ * Declarative command dispatch. A command registry is an X-macro listing every
+ * command a build target handles, with the minimum payload length the handler
+ * requires:
+ *
+ *     #define COMMANDS(X) \
+ *         X(ATEM_CMDNAME_VERSION, 4, handle_version) \
+ *         X(ATEM_CMDNAME_TALLY, 2, handle_tally)
+ *     ATEM_DISPATCH_DEFINE(dispatch, COMMANDS)
+ *
+ * Handlers take the command payload and its length as
+ * `void handler(uint8_t* buf, uint16_t len)`, or no arguments when defined with
+ * ATEM_DISPATCH_DEFINE_CONTEXT() for handlers reading the command from their
+ * atem context. Only registered handlers are compiled in and registering the
+ * same command twice fails to compile.
+ */
+
+/**
+ * @private
+ * Expands a registry entry to a switch case calling its handler when the payload is long enough.
+ */
+#define ATEM_DISPATCH_CASE(cmd_name, len_min, handler) \
+	case (cmd_name): { \
+		const uint16_t cmd_len_min = (len_min); \
+		if (len < cmd_len_min) return false; \
+		handler(buf, len); \
+		return true; \
+	}
+
+/**
+ * @private
+ * Expands a registry entry to a switch case calling its handler without arguments when the payload is long enough.
+ */
+#define ATEM_DISPATCH_CASE_CONTEXT(cmd_name, len_min, handler) \
+	case (cmd_name): { \
+		const uint16_t cmd_len_min = (len_min); \
+		if (len < cmd_len_min) return false; \
+		handler(); \
+		return true; \
+	}
+
+/**
+ * @private
+ * Expands a registry entry to its bit in a command filter.
+ */
+#define ATEM_DISPATCH_FILTER_BIT(cmd_name, len_min, handler) | ATEM_CMD_FILTER_BIT(cmd_name)
+
+/**
+ * @brief Gets a command filter matching every command in an X-macro registry.
+ *
+ * Evaluates to a constant expression that can be assigned to @ref atem.cmd_filter
+ * to skip commands without a registered handler in atem_cmd_next().
+ *
+ * @param registry X-macro taking a macro to expand for each `(cmd_name, len_min, handler)` entry.
+ */
+#define ATEM_DISPATCH_FILTER(registry) ((uint32_t)0 registry(ATEM_DISPATCH_FILTER_BIT))
+
+/**
+ * @brief Defines a static dispatch function for the commands in an X-macro registry.
+ *
+ * The defined function has the signature `bool fn(uint32_t name, uint8_t* buf, uint16_t len)`
+ * and returns true if a handler was called for the command.
+ * Commands not in the registry or with a payload shorter than its registered minimum length are ignored.
+ *
+ * @param fn Name of the dispatch function to define.
+ * @param registry X-macro taking a macro to expand for each `(cmd_name, len_min, handler)` entry.
+ */
+#define ATEM_DISPATCH_DEFINE(fn, registry) \
+	static bool fn(uint32_t name, uint8_t* buf, uint16_t len) { \
+		switch (name) { \
+			registry(ATEM_DISPATCH_CASE) \
+			default: return false; \
+		} \
+	}
+
+/**
+ * @brief Defines a static dispatch function for handlers taking no arguments.
+ *
+ * The defined function has the signature `bool fn(uint32_t name, uint16_t len)`
+ * and returns true if a handler was called for the command. Used when handlers
+ * read the command from the atem context it was parsed with.
+ * Commands not in the registry or with a payload shorter than its registered minimum length are ignored.
+ *
+ * @param fn Name of the dispatch function to define.
+ * @param registry X-macro taking a macro to expand for each `(cmd_name, len_min, handler)` entry.
+ */
+#define ATEM_DISPATCH_DEFINE_CONTEXT(fn, registry) \
+	static bool fn(uint32_t name, uint16_t len) { \
+		switch (name) { \
+			registry(ATEM_DISPATCH_CASE_CONTEXT) \
+			default: return false; \
+		} \
+	}
+
+#endif // ATEM_DISPATCH_H
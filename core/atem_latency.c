@@ -0,0 +1,157 @@
+#include <stdbool.h> // bool, true, false
+#include <stdint.h> // uint32_t, uint64_t
+#include <stddef.h> // NULL
+#include <stdio.h> // FILE, fprintf
+#include <inttypes.h> // PRIu64
+#include <string.h> // memcpy
+#include <assert.h> // assert
+#include <time.h> // struct timespec, timespec_get, TIME_UTC
+
+#include <sys/socket.h> // setsockopt, SOL_SOCKET, SO_TIMESTAMPNS, SO_TIMESTAMP, SCM_TIMESTAMP, struct msghdr, struct cmsghdr, CMSG_FIRSTHDR, CMSG_NXTHDR, CMSG_DATA
+#include <sys/time.h> // struct timeval
+
+#include "./atem_latency.h" // struct atem_latency, struct atem_latency_histogram, ATEM_LATENCY_BUCKETS
+
+// Uses nanosecond timestamps where available and microsecond timestamps otherwise
+// Linux control message type is the same as the socket option, SCM_TIMESTAMPNS is hidden in strict ISO C builds
+#if defined(SO_TIMESTAMPNS)
+#define ATEM_LATENCY_SO SO_TIMESTAMPNS
+#define ATEM_LATENCY_SCM SO_TIMESTAMPNS
+#define ATEM_LATENCY_NS
+#elif defined(SO_TIMESTAMP) && defined(SCM_TIMESTAMP)
+#define ATEM_LATENCY_SO SO_TIMESTAMP
+#define ATEM_LATENCY_SCM SCM_TIMESTAMP
+#endif // SO_TIMESTAMPNS
+
+// Enables kernel receive timestamps on socket
+bool atem_latency_enable(int sock) {
+#ifdef ATEM_LATENCY_SO
+	const int enable = 1;
+	return setsockopt(sock, SOL_SOCKET, ATEM_LATENCY_SO, &enable, sizeof(enable)) == 0;
+#else // ATEM_LATENCY_SO
+	(void)sock;
+	return false;
+#endif // ATEM_LATENCY_SO
+}
+
+// Gets nanoseconds from wall clock, the same clock kernel receive timestamps use
+uint64_t atem_latency_now(void) {
+	struct timespec ts;
+	int timespec_result = timespec_get(&ts, TIME_UTC);
+	assert(timespec_result == TIME_UTC);
+	(void)timespec_result;
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// Gets kernel receive timestamp from control messages, falls back to current time if missing
+uint64_t atem_latency_recv_time(struct msghdr* msg) {
+	assert(msg != NULL);
+
+#ifdef ATEM_LATENCY_SCM
+	for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != ATEM_LATENCY_SCM) continue;
+#ifdef ATEM_LATENCY_NS
+		struct timespec ts;
+		memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+		return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#else // ATEM_LATENCY_NS
+		struct timeval tv;
+		memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+		return (uint64_t)tv.tv_sec * 1000000000 + (uint64_t)tv.tv_usec * 1000;
+#endif // ATEM_LATENCY_NS
+	}
+#endif // ATEM_LATENCY_SCM
+
+	return atem_latency_now();
+}
+
+// Records latency in bucket for its number of significant bits in microseconds
+void atem_latency_record(struct atem_latency_histogram* histogram, uint64_t start, uint64_t end) {
+	assert(histogram != NULL);
+
+	// Records clock going backwards as no latency
+	const uint64_t latency = (end > start) ? end - start : 0;
+
+	uint64_t micros = latency / 1000;
+	int bucket = 0;
+	while (micros > 0 && bucket < ATEM_LATENCY_BUCKETS - 1) {
+		micros >>= 1;
+		bucket++;
+	}
+	histogram->buckets[bucket]++;
+	histogram->count++;
+	if (latency > histogram->max) {
+		histogram->max = latency;
+	}
+}
+
+// Records receive to parse latency and starts parse to send measurement if not already started
+void atem_latency_parsed(struct atem_latency* latency, uint64_t recv_time, bool ack) {
+	assert(latency != NULL);
+	const uint64_t now = atem_latency_now();
+	atem_latency_record(&latency->recv_to_parse, recv_time, now);
+	if (ack && latency->parse_time == 0) {
+		latency->parse_time = now;
+	}
+}
+
+// Records parse to send latency for first packet waiting for acknowledgement
+void atem_latency_sent(struct atem_latency* latency) {
+	assert(latency != NULL);
+	if (latency->parse_time == 0) return;
+	atem_latency_record(&latency->parse_to_send, latency->parse_time, atem_latency_now());
+	latency->parse_time = 0;
+}
+
+// Gets upper bound of the bucket the percentile falls in
+uint64_t atem_latency_percentile(const struct atem_latency_histogram* histogram, unsigned int percent) {
+	assert(histogram != NULL);
+	assert(percent <= 100);
+
+	if (histogram->count == 0) {
+		return 0;
+	}
+
+	// Finds bucket containing the rank of the percentile, rounded up to at least the first sample
+	uint64_t rank = (histogram->count * percent + 99) / 100;
+	if (rank == 0) {
+		rank = 1;
+	}
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < ATEM_LATENCY_BUCKETS - 1; bucket++) {
+		seen += histogram->buckets[bucket];
+		if (seen >= rank) {
+			return (uint64_t)1 << bucket;
+		}
+	}
+
+	// Last bucket has no upper bound other than largest recorded latency
+	return (histogram->max + 999) / 1000;
+}
+
+// Prints summary line followed by one line per non-empty bucket
+void atem_latency_print(FILE* file, const char* name, const struct atem_latency_histogram* histogram) {
+	assert(file != NULL);
+	assert(name != NULL);
+	assert(histogram != NULL);
+
+	if (histogram->count == 0) {
+		fprintf(file, "%s: count 0\n", name);
+		return;
+	}
+	fprintf(
+		file, "%s: count %" PRIu64 ", p50 <%" PRIu64 "us, p99 <%" PRIu64 "us, max %" PRIu64 "us\n",
+		name, histogram->count,
+		atem_latency_percentile(histogram, 50), atem_latency_percentile(histogram, 99),
+		(histogram->max + 999) / 1000
+	);
+	for (int bucket = 0; bucket < ATEM_LATENCY_BUCKETS; bucket++) {
+		if (histogram->buckets[bucket] == 0) continue;
+		if (bucket < ATEM_LATENCY_BUCKETS - 1) {
+			fprintf(file, "\t<%" PRIu64 "us: %" PRIu32 "\n", (uint64_t)1 << bucket, histogram->buckets[bucket]);
+		}
+		else {
+			fprintf(file, "\t>=%" PRIu64 "us: %" PRIu32 "\n", (uint64_t)1 << (bucket - 1), histogram->buckets[bucket]);
+		}
+	}
+}
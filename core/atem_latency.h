@@ -0,0 +1,136 @@
+/**
+ * @file
+ * @brief Kernel receive timestamps and latency histograms for ATEM traffic
+ *
+ * Sockets enabled with atem_latency_enable() get a kernel timestamp attached to every received datagram,
+ * read with atem_latency_recv_time() from the control messages filled in by `recvmsg`.
+ * Latencies are recorded in histograms with power of two microsecond buckets:
+ *
+ * | Bucket | Latency                                                     |
+ * | ------ | ----------------------------------------------------------- |
+ * | 0      | Less than 1 microsecond                                     |
+ * | n      | At least 2^(n-1) and less than 2^n microseconds             |
+ * | last   | Everything not fitting in a lower bucket                    |
+ */
+
+// Include guard
+#ifndef ATEM_LATENCY_H
+#define ATEM_LATENCY_H
+
+#include <stdbool.h> // bool
+#include <stdint.h> // uint32_t, uint64_t
+#include <stdio.h> // FILE
+
+#include <sys/socket.h> // struct msghdr, struct cmsghdr
+
+/**
+ * Number of buckets in a latency histogram, the last bucket holds everything from about half a second.
+ */
+#define ATEM_LATENCY_BUCKETS 20
+
+/**
+ * Length of control buffer to pass to `recvmsg` for receiving the kernel timestamp.
+ * Has to be aligned for `struct cmsghdr`, for example by declaring it in a union with a `size_t`.
+ */
+#define ATEM_LATENCY_CONTROL_LEN 64
+
+/**
+ * @brief Histogram of latencies with power of two microsecond buckets.
+ */
+struct atem_latency_histogram {
+	/** Number of latencies recorded. */
+	uint64_t count;
+	/** Largest latency recorded in nanoseconds. */
+	uint64_t max;
+	/** Number of latencies recorded in each bucket. */
+	uint32_t buckets[ATEM_LATENCY_BUCKETS];
+};
+
+/**
+ * @brief Latencies for received packets from being received by the kernel until acknowledged.
+ */
+struct atem_latency {
+	/** Time from the kernel receiving a packet until it is parsed. */
+	struct atem_latency_histogram recv_to_parse;
+	/** Time from the first unacknowledged packet being parsed until its acknowledgement is sent. */
+	struct atem_latency_histogram parse_to_send;
+	/**
+	 * @private
+	 * Time from atem_latency_now() first unacknowledged packet was parsed, 0 if none is pending.
+	 */
+	uint64_t parse_time;
+	/** Indicates if receive times are from the kernel or from when packets were read by the application. */
+	bool kernel;
+};
+
+// Makes functions available to C++ with extern C block
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Enables kernel receive timestamps on socket.
+ * Uses `SO_TIMESTAMPNS` where available and `SO_TIMESTAMP` otherwise.
+ * @param sock Socket to enable receive timestamps for.
+ * @return Indicates if the kernel timestamps received datagrams,
+ * atem_latency_recv_time() falls back to the current time otherwise.
+ */
+bool atem_latency_enable(int sock);
+
+/**
+ * @brief Gets nanoseconds from the same wall clock the kernel timestamps received datagrams with.
+ * @return Current time in nanoseconds.
+ */
+uint64_t atem_latency_now(void);
+
+/**
+ * @brief Gets kernel receive timestamp from datagram received with `recvmsg`.
+ * @param msg Message header from `recvmsg` with a control buffer of @ref ATEM_LATENCY_CONTROL_LEN bytes.
+ * @return Time in nanoseconds the datagram was received, current time from atem_latency_now() if not timestamped.
+ */
+uint64_t atem_latency_recv_time(struct msghdr* msg);
+
+/**
+ * @brief Records latency between two times in histogram.
+ * @param histogram Histogram to record latency in.
+ * @param start Time in nanoseconds when measurement started.
+ * @param end Time in nanoseconds when measurement ended, recorded as no latency if before @p start.
+ */
+void atem_latency_record(struct atem_latency_histogram* histogram, uint64_t start, uint64_t end);
+
+/**
+ * @brief Records time from kernel receiving packet until now.
+ * @param latency Latencies for connection the packet was received on.
+ * @param recv_time Time from atem_latency_recv_time() the packet was received.
+ * @param ack Indicates if the packet is waiting for acknowledgement, starting parse-to-send measurement if not already started.
+ */
+void atem_latency_parsed(struct atem_latency* latency, uint64_t recv_time, bool ack);
+
+/**
+ * @brief Records time from first packet waiting for acknowledgement being parsed until now.
+ * Does nothing if no packet is waiting for acknowledgement.
+ * @param latency Latencies for connection the acknowledgement was sent on.
+ */
+void atem_latency_sent(struct atem_latency* latency);
+
+/**
+ * @brief Gets upper bound of bucket containing percentile.
+ * @param histogram Histogram to get percentile from.
+ * @param percent Percentile between 0 and 100.
+ * @return Upper bound of bucket in microseconds, largest recorded latency rounded up for the last bucket and 0 for empty histograms.
+ */
+uint64_t atem_latency_percentile(const struct atem_latency_histogram* histogram, unsigned int percent);
+
+/**
+ * @brief Prints summary and non-empty buckets of histogram.
+ * @param file File to print histogram to.
+ * @param name Name to print histogram with.
+ * @param histogram Histogram to print.
+ */
+void atem_latency_print(FILE* file, const char* name, const struct atem_latency_histogram* histogram);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ATEM_LATENCY_H
@@ -1,19 +1,50 @@
+// Enables recvmmsg on Linux for receiving batches of packets in a single system call
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif // __linux__ && !_GNU_SOURCE
+
 #include <stdbool.h> // bool, true, false
-#include <errno.h> // errno, EFAULT
+#include <errno.h> // errno, EFAULT, ENOBUFS, EAGAIN, EWOULDBLOCK, EINTR
 #include <assert.h> // assert
 #include <stdint.h> // uint32_t
 
-#include <sys/socket.h> // socket, AF_INET, SOCK_DGRAM, connect, recv, send, struct sockaddr
+#include <sys/socket.h> // socket, AF_INET, SOCK_DGRAM, connect, recv, recvmsg, send, struct sockaddr, struct msghdr, MSG_DONTWAIT, recvmmsg, struct mmsghdr
+#include <sys/uio.h> // struct iovec
 #include <netinet/in.h> // in_addr_t, struct sockaddr_in
 #include <arpa/inet.h> // htons
 #include <poll.h> // poll, struct pollfd, POLLIN
-#include <unistd.h> // close
+#include <unistd.h> // close, getpid
 #include <sys/types.h> // ssize_t
+#include <stddef.h> // size_t
+#include <string.h> // memcpy, memset
+#include <time.h> // clock_gettime, CLOCK_MONOTONIC, struct timespec
+#include <stdlib.h> // rand
 
-#include "./atem.h" // struct atem, ATEM_PORT, atem_connection_open, ATEM_TIMEOUT_MS, ATEM_PACKET_LEN_MAX, atem_parse, atem_cmd_available
+#include "./atem.h" // struct atem, ATEM_PORT, atem_connection_open, atem_reconnect_delay, ATEM_RECONNECT_DELAY_MS, ATEM_TIMEOUT_MS, ATEM_LIVENESS_TIMEOUT_MS, ATEM_PACKET_LEN_MAX, atem_parse_buf, atem_parse_reordered, atem_parse_batch, atem_cmd_available, ATEM_STATUS_WRITE, ATEM_SEND_WINDOW, atem_cmd_enqueue, atem_send_poll, atem_send_wait, ATEM_STATUS_WRITE_ONLY
 #include "./atem_protocol.h" // ATEM_LEN_HEADER
+#include "./atem_capture.h" // atem_capture_write, ATEM_CAPTURE_DIR_SEND, ATEM_CAPTURE_DIR_RECV
+#include "./atem_latency.h" // atem_latency_enable, atem_latency_now, atem_latency_recv_time, atem_latency_parsed, atem_latency_sent, ATEM_LATENCY_CONTROL_LEN
 #include "./atem_posix.h" // enum atem_posix_status, ATEM_POSIX_STATUS_ERROR_NETWORK, ATEM_POSIX_STATUS_ERROR_PARSE, ATEM_POSIX_STATUS_DROPPED
 
+// POSIX client receives packets directly into the contexts read buffer
+#if !ATEM_READ_BUF
+#error ATEM POSIX client requires ATEM_READ_BUF to be enabled
+#endif // !ATEM_READ_BUF
+
+// Gets milliseconds from monotonic clock used for deadlines
+uint32_t atem_posix_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)ts.tv_sec * 1000 + (uint32_t)(ts.tv_nsec / 1000000);
+}
+
+// Gets random value for session ids and retry jitter, mixing in process id and clock to differ between processes started together
+static uint32_t atem_posix_random(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)rand() ^ ((uint32_t)getpid() * 0x9e3779b1u) ^ (uint32_t)ts.tv_nsec;
+}
+
 // Initializes ATEM communication by creating UDP socket for context
 bool atem_init(struct atem_posix_ctx* atem_ctx, in_addr_t addr) {
 	assert(atem_ctx != NULL);
@@ -48,36 +79,95 @@ bool atem_init(struct atem_posix_ctx* atem_ctx, in_addr_t addr) {
 
 	// Initializes context and starts opening handshake
 	atem_ctx->atem.read_len = 0;
+	atem_ctx->atem.cmd_filter = 0;
 	atem_ctx->atem.tally_pgm = 0;
 	atem_ctx->atem.tally_pvw = 0;
-	atem_connection_open(&atem_ctx->atem);
+	atem_ctx->atem.reconnect_attempts = 0;
+	atem_ctx->capture = NULL;
+#if ATEM_POSIX_BATCH
+	atem_ctx->batch.count = 0;
+	atem_ctx->batch.index = 0;
+#endif // ATEM_POSIX_BATCH
+#if ATEM_POSIX_LATENCY
+	memset(&atem_ctx->latency, 0, sizeof(atem_ctx->latency));
+	atem_ctx->latency.kernel = atem_latency_enable(atem_ctx->sock);
+#endif // ATEM_POSIX_LATENCY
+	atem_ctx->atem.write_buf = NULL;
+	atem_connection_open(&atem_ctx->atem, atem_posix_random());
+	atem_ctx->deadline = atem_posix_now() + atem_reconnect_delay(&atem_ctx->atem, atem_posix_random());
 
 	return true;
 }
 
+// Sends packet using ATEM UDP socket, recording it if capturing traffic
+static bool atem_send_buf(struct atem_posix_ctx* atem_ctx, const uint8_t* buf, uint16_t len) {
+	assert(atem_ctx != NULL);
+	assert(buf != NULL);
+	assert(len > 0);
+	assert(((buf[0] << 8 | buf[1]) & ATEM_PACKET_LEN_MAX) == len);
+
+	ssize_t sent = send(atem_ctx->sock, buf, len, 0);
+	assert(sent == -1 || sent == len);
+
+	// Records sent packet if capturing traffic
+	if (atem_ctx->capture != NULL && sent != -1) {
+		atem_capture_write(atem_ctx->capture, ATEM_CAPTURE_DIR_SEND, NULL, buf, len);
+	}
+
+	return sent == len;
+}
+
 // Sens buffered packet in context using ATEM UDP socket
 bool atem_send(struct atem_posix_ctx* atem_ctx) {
 	assert(atem_ctx != NULL);
 	struct atem* atem = &atem_ctx->atem;
-	assert(atem->write_buf != NULL);
-	assert(atem->write_len > 0);
-	assert(((atem->write_buf[0] << 8 | atem->write_buf[1]) & ATEM_PACKET_LEN_MAX) == atem->write_len);
+	const bool sent = atem_send_buf(atem_ctx, atem->write_buf, atem->write_len);
 
-	ssize_t sent = send(atem_ctx->sock, atem->write_buf, atem->write_len, 0);
-	assert(sent == -1 || sent == atem->write_len);
-	return sent == atem->write_len;
+#if ATEM_POSIX_LATENCY
+	// Completes parse to send measurement for packets waiting for acknowledgement
+	if (sent) {
+		atem_latency_sent(&atem_ctx->latency);
+	}
+#endif // ATEM_POSIX_LATENCY
+
+	return sent;
 }
 
-// Reads next ATEM packet from server and parses its content
-enum atem_posix_status atem_recv(struct atem_posix_ctx* atem_ctx) {
+// Reads next ATEM packet from server with recv flags and parses its content
+static enum atem_posix_status atem_recv_flags(struct atem_posix_ctx* atem_ctx, int flags) {
 	assert(atem_ctx != NULL);
 
-	ssize_t recved = recv(atem_ctx->sock, atem_ctx->atem.read_buf, sizeof(atem_ctx->atem.read_buf), 0);
+#if ATEM_POSIX_LATENCY
+	// Receives packet together with its kernel receive timestamp
+	struct iovec iov = { .iov_base = atem_ctx->atem.read_buf, .iov_len = sizeof(atem_ctx->atem.read_buf) };
+	union {
+		size_t align;
+		uint8_t buf[ATEM_LATENCY_CONTROL_LEN];
+	} control;
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = control.buf,
+		.msg_controllen = sizeof(control.buf)
+	};
+	ssize_t recved = recvmsg(atem_ctx->sock, &msg, flags);
+#else // ATEM_POSIX_LATENCY
+	ssize_t recved = recv(atem_ctx->sock, atem_ctx->atem.read_buf, sizeof(atem_ctx->atem.read_buf), flags);
+#endif // ATEM_POSIX_LATENCY
 	assert(recved >= -1);
 	assert(recved <= (ssize_t)sizeof(atem_ctx->atem.read_buf));
 
+	// Records received packet before parsing if capturing traffic
+	if (atem_ctx->capture != NULL && recved != -1) {
+		atem_capture_write(atem_ctx->capture, ATEM_CAPTURE_DIR_RECV, NULL, atem_ctx->atem.read_buf, (size_t)recved);
+	}
+
 	if (recved >= ATEM_LEN_HEADER) {
-		return (enum atem_posix_status)atem_parse(&atem_ctx->atem);
+		enum atem_posix_status status = (enum atem_posix_status)atem_parse_buf(&atem_ctx->atem, atem_ctx->atem.read_buf, (uint16_t)recved);
+#if ATEM_POSIX_LATENCY
+		atem_latency_parsed(&atem_ctx->latency, atem_latency_recv_time(&msg), status >= 0 && !(status & 1));
+#endif // ATEM_POSIX_LATENCY
+		return status;
 	}
 	else if (recved == -1) {
 		return ATEM_POSIX_STATUS_ERROR_NETWORK;
@@ -87,37 +177,256 @@ enum atem_posix_status atem_recv(struct atem_posix_ctx* atem_ctx) {
 	}
 }
 
-// Reads and parses ATEM packets until a packet that could contain a payload is received
-enum atem_posix_status atem_poll(struct atem_posix_ctx* atem_ctx) {
+// Reads next ATEM packet from server and parses its content
+enum atem_posix_status atem_recv(struct atem_posix_ctx* atem_ctx) {
+	return atem_recv_flags(atem_ctx, 0);
+}
+
+#if ATEM_SEND_WINDOW
+// Sends all queued packets that are due for transmission
+bool atem_flush(struct atem_posix_ctx* atem_ctx) {
 	assert(atem_ctx != NULL);
+	while (atem_send_poll(&atem_ctx->atem, atem_posix_now()) == ATEM_STATUS_WRITE_ONLY) {
+		if (!atem_send_buf(atem_ctx, atem_ctx->atem.send_buf, atem_ctx->atem.send_len)) {
+			return false;
+		}
+	}
+	return true;
+}
 
-	struct pollfd poll_fd = { .fd = atem_ctx->sock, .events = POLLIN };
-	int poll_len = poll(&poll_fd, 1, ATEM_TIMEOUT_MS);
+// Enqueues command and sends it right away if connected
+bool atem_cmd_send(struct atem_posix_ctx* atem_ctx, uint32_t name, const void* payload, uint16_t len) {
+	assert(atem_ctx != NULL);
+	assert(payload != NULL || len == 0);
 
-	if (poll_len != 1) {
-		// Returns network error status if poll gets an error
-		if (poll_len == -1) {
+	// Rejects command if queue is full or command is too large
+	uint8_t* cmd_buf = atem_cmd_enqueue(&atem_ctx->atem, name, len);
+	if (cmd_buf == NULL) {
+		errno = ENOBUFS;
+		return false;
+	}
+	if (len > 0) {
+		memcpy(cmd_buf, payload, len);
+	}
+
+	return atem_flush(atem_ctx);
+}
+#endif // ATEM_SEND_WINDOW
+
+// Gets next deadline, including retransmits for queued commands
+uint32_t atem_posix_deadline(struct atem_posix_ctx* atem_ctx) {
+	assert(atem_ctx != NULL);
+#if ATEM_SEND_WINDOW
+	const uint32_t now = atem_posix_now();
+	const uint32_t send_wait = atem_send_wait(&atem_ctx->atem, now);
+	if (send_wait < (uint32_t)(atem_ctx->deadline - now)) {
+		return now + send_wait;
+	}
+#endif // ATEM_SEND_WINDOW
+	return atem_ctx->deadline;
+}
+
+#if ATEM_POSIX_BATCH
+// Parses next packet in batch, receiving all queued packets without blocking when the previous batch is done
+static enum atem_posix_status atem_recv_batch(struct atem_posix_ctx* atem_ctx) {
+	assert(atem_ctx != NULL);
+	assert(atem_ctx->batch.index <= atem_ctx->batch.count);
+
+	uint8_t* bufs[ATEM_POSIX_BATCH];
+	for (int i = 0; i < ATEM_POSIX_BATCH; i++) {
+		bufs[i] = atem_ctx->batch.buf[i];
+	}
+
+	while (true) {
+		// Parses remaining packets in batch
+#if ATEM_POSIX_LATENCY
+		const uint16_t index = atem_ctx->batch.index;
+#endif // ATEM_POSIX_LATENCY
+		enum atem_status status = atem_parse_batch(&atem_ctx->atem, bufs, atem_ctx->batch.len, atem_ctx->batch.count, &atem_ctx->batch.index);
+#if ATEM_POSIX_LATENCY
+		// Records latency for packets parsed, all waiting for the cumulative acknowledgement
+		for (uint16_t i = index; i < atem_ctx->batch.index; i++) {
+			atem_latency_parsed(&atem_ctx->latency, atem_ctx->batch.recv_time[i], true);
+		}
+#endif // ATEM_POSIX_LATENCY
+		if (status != ATEM_STATUS_NONE) {
+			return (enum atem_posix_status)status;
+		}
+
+#ifdef __linux__
+		// Receives all queued packets in a single system call
+		struct iovec iovs[ATEM_POSIX_BATCH];
+		struct mmsghdr msgs[ATEM_POSIX_BATCH];
+#if ATEM_POSIX_LATENCY
+		union {
+			size_t align;
+			uint8_t buf[ATEM_LATENCY_CONTROL_LEN];
+		} controls[ATEM_POSIX_BATCH];
+#endif // ATEM_POSIX_LATENCY
+		for (int i = 0; i < ATEM_POSIX_BATCH; i++) {
+			iovs[i].iov_base = atem_ctx->batch.buf[i];
+			iovs[i].iov_len = sizeof(atem_ctx->batch.buf[i]);
+			memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+#if ATEM_POSIX_LATENCY
+			msgs[i].msg_hdr.msg_control = controls[i].buf;
+			msgs[i].msg_hdr.msg_controllen = sizeof(controls[i].buf);
+#endif // ATEM_POSIX_LATENCY
+		}
+		const int count = recvmmsg(atem_ctx->sock, msgs, ATEM_POSIX_BATCH, MSG_DONTWAIT, NULL);
+		if (count == -1) {
 			return ATEM_POSIX_STATUS_ERROR_NETWORK;
 		}
+		for (int i = 0; i < count; i++) {
+			atem_ctx->batch.len[i] = (uint16_t)msgs[i].msg_len;
+#if ATEM_POSIX_LATENCY
+			atem_ctx->batch.recv_time[i] = atem_latency_recv_time(&msgs[i].msg_hdr);
+#endif // ATEM_POSIX_LATENCY
+		}
+#else // __linux__
+		// Receives all queued packets one at a time where recvmmsg is not available
+		int count = 0;
+		while (count < ATEM_POSIX_BATCH) {
+			const ssize_t recved = recv(atem_ctx->sock, atem_ctx->batch.buf[count], sizeof(atem_ctx->batch.buf[count]), MSG_DONTWAIT);
+			if (recved == -1) break;
+#if ATEM_POSIX_LATENCY
+			atem_ctx->batch.recv_time[count] = atem_latency_now();
+#endif // ATEM_POSIX_LATENCY
+			atem_ctx->batch.len[count++] = (uint16_t)recved;
+		}
+		if (count == 0) {
+			return ATEM_POSIX_STATUS_ERROR_NETWORK;
+		}
+#endif // __linux__
 
-		// Resets to send new opening handshake if connection is dropped
-		assert(poll_len == 0);
-		atem_connection_open(&atem_ctx->atem);
-		return ATEM_POSIX_STATUS_DROPPED;
+		// Records received packets before parsing if capturing traffic
+		if (atem_ctx->capture != NULL) {
+			for (int i = 0; i < count; i++) {
+				atem_capture_write(atem_ctx->capture, ATEM_CAPTURE_DIR_RECV, NULL, atem_ctx->batch.buf[i], atem_ctx->batch.len[i]);
+			}
+		}
+		atem_ctx->batch.count = (uint16_t)count;
+		atem_ctx->batch.index = 0;
+	}
+}
+#endif // ATEM_POSIX_BATCH
+
+// Reads, parses and acknowledges next ATEM packet without blocking
+enum atem_posix_status atem_posix_readable(struct atem_posix_ctx* atem_ctx) {
+	assert(atem_ctx != NULL);
+
+#if ATEM_POSIX_BATCH
+	// Parses next packet in batch, only sending cumulative acknowledgement after the last packet
+	enum atem_posix_status status = atem_recv_batch(atem_ctx);
+	if (status == ATEM_POSIX_STATUS_ERROR_NETWORK) {
+#if ATEM_POSIX_LATENCY
+		// Drops parse to send measurement for packets in batch that needed no acknowledgement
+		atem_ctx->latency.parse_time = 0;
+#endif // ATEM_POSIX_LATENCY
+		return (errno == EAGAIN || errno == EWOULDBLOCK) ? ATEM_POSIX_STATUS_NONE : status;
+	}
+	if (status > 0 && !(status & 1)) {
+		atem_send(atem_ctx);
+	}
+#else // ATEM_POSIX_BATCH
+	// Releases packets held by reorder window before receiving new packets
+	if (atem_parse_reordered(&atem_ctx->atem) == ATEM_STATUS_WRITE) {
+		atem_send(atem_ctx);
+		return ATEM_POSIX_STATUS_WRITE;
 	}
 
 	// Parses and acknowledges received ATEM packet
-	enum atem_posix_status status = atem_recv(atem_ctx);
+	enum atem_posix_status status = atem_recv_flags(atem_ctx, MSG_DONTWAIT);
+	if (status == ATEM_POSIX_STATUS_ERROR_NETWORK) {
+		return (errno == EAGAIN || errno == EWOULDBLOCK) ? ATEM_POSIX_STATUS_NONE : status;
+	}
 	if (status >= 0 && !(status & 1)) {
 		atem_send(atem_ctx);
 	}
+#endif // ATEM_POSIX_BATCH
+
+	// Detects dropped connection after a few missed pings or waits full timeout with jitter if ATEM ended connection
+	if (status == ATEM_POSIX_STATUS_REJECTED || status == ATEM_POSIX_STATUS_CLOSING) {
+		atem_ctx->deadline = atem_posix_now() + ATEM_TIMEOUT_MS + atem_posix_random() % ATEM_RECONNECT_DELAY_MS;
+	}
+	else {
+		atem_ctx->deadline = atem_posix_now() + ATEM_LIVENESS_TIMEOUT_MS;
+	}
 	return status;
 }
 
+// Drops connection if its deadline is reached and transmits queued packets that are due
+enum atem_posix_status atem_posix_deadline_reached(struct atem_posix_ctx* atem_ctx) {
+	assert(atem_ctx != NULL);
+	const uint32_t now = atem_posix_now();
+
+	// Resets to send new opening handshake if connection is dropped, retrying with exponential backoff
+	if ((int32_t)(atem_ctx->deadline - now) <= 0) {
+		atem_connection_open(&atem_ctx->atem, atem_posix_random());
+		atem_ctx->deadline = now + atem_reconnect_delay(&atem_ctx->atem, atem_posix_random());
+		return ATEM_POSIX_STATUS_DROPPED;
+	}
+
+#if ATEM_SEND_WINDOW
+	// Transmits queued packets that are due
+	if (!atem_flush(atem_ctx)) {
+		return ATEM_POSIX_STATUS_ERROR_NETWORK;
+	}
+#endif // ATEM_SEND_WINDOW
+
+	return ATEM_POSIX_STATUS_NONE;
+}
+
+// Reads and parses ATEM packets until a packet that could contain a payload is received
+enum atem_posix_status atem_poll(struct atem_posix_ctx* atem_ctx) {
+	assert(atem_ctx != NULL);
+
+	struct pollfd poll_fd = { .fd = atem_ctx->sock, .events = POLLIN };
+	while (true) {
+		// Handles dropped connection and queued packets before waiting
+		enum atem_posix_status status = atem_posix_deadline_reached(atem_ctx);
+		if (status != ATEM_POSIX_STATUS_NONE) {
+			return status;
+		}
+
+#if ATEM_POSIX_BATCH
+		// Finishes current batch before waiting since its packets and cumulative acknowledgement are no longer on the socket
+		if (atem_ctx->batch.index < atem_ctx->batch.count || atem_ctx->atem.ack_deferred) {
+			status = atem_posix_readable(atem_ctx);
+			if (status != ATEM_POSIX_STATUS_NONE) {
+				return status;
+			}
+		}
+#endif // ATEM_POSIX_BATCH
+
+		// Waits for next packet until next deadline
+		const int32_t wait = (int32_t)(atem_posix_deadline(atem_ctx) - atem_posix_now());
+		int poll_len = poll(&poll_fd, 1, (wait > 0) ? (int)wait : 0);
+		if (poll_len == -1) {
+			if (errno == EINTR) continue;
+			return ATEM_POSIX_STATUS_ERROR_NETWORK;
+		}
+		if (poll_len == 0) continue;
+
+		// Parses and acknowledges received ATEM packet
+		status = atem_posix_readable(atem_ctx);
+		if (status != ATEM_POSIX_STATUS_NONE) {
+			return status;
+		}
+	}
+}
+
 // Returns status codes or iterates through commands in ATEM packets
 int32_t atem_next(struct atem_posix_ctx* atem_ctx) {
 	assert(atem_ctx != NULL);
 	while (!atem_cmd_available(&atem_ctx->atem)) {
+		// Releases packets held by reorder window before receiving new packets
+		if (atem_parse_reordered(&atem_ctx->atem) == ATEM_STATUS_WRITE) {
+			atem_send(atem_ctx);
+			continue;
+		}
+
 		enum atem_posix_status status;
 		while ((status = atem_poll(atem_ctx)) != ATEM_POSIX_STATUS_WRITE) {
 			switch (status) {
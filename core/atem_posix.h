@@ -8,20 +8,76 @@
 #define ATEM_POSIX_H
 
 #include <stdbool.h> // bool
-#include <stdint.h> // uint32_t
+#include <stdint.h> // uint32_t, uint64_t
+#include <stdio.h> // FILE
 
 #include <netinet/in.h> // in_addr_t
 
-#include "./atem.h" // struct atem
+#include "./atem.h" // struct atem, ATEM_SEND_WINDOW, ATEM_PACKET_LEN_MAX
+#include "./atem_latency.h" // struct atem_latency
 
 
 
+/**
+ * Number of packets atem_posix_readable() receives at once, using a single system call on Linux.
+ * Each batch is acknowledged with a single cumulative acknowledgement instead of one per packet,
+ * reducing the number of packets sent during the initial state dump and other bursts.
+ * Each packet uses @ref ATEM_PACKET_LEN_MAX bytes of the context, 0 receives one packet at a time.
+ * @attention Has to be defined to the same value in all translation units since it changes the layout of @ref atem_posix_ctx.
+ * @attention Packets are only received in batches by atem_posix_readable() and functions using it,
+ * so atem_recv() should not be used when enabled.
+ */
+#ifndef ATEM_POSIX_BATCH
+#define ATEM_POSIX_BATCH (0)
+#endif // ATEM_POSIX_BATCH
+
+/**
+ * Enables kernel receive timestamps on the socket and records latencies of received packets in @ref atem_posix_ctx.latency.
+ * Uses the time packets are read by the application where the kernel does not timestamp received packets.
+ * @attention Has to be defined to the same value in all translation units since it changes the layout of @ref atem_posix_ctx.
+ */
+#ifndef ATEM_POSIX_LATENCY
+#define ATEM_POSIX_LATENCY (0)
+#endif // ATEM_POSIX_LATENCY
+
 /**
  * @brief Context for ATEM connection
  */
 struct atem_posix_ctx {
 	struct atem atem;
 	int sock;
+	/**
+	 * @private
+	 * Time from atem_posix_now() when connection is reported as dropped if no packet is received
+	 */
+	uint32_t deadline;
+	/**
+	 * Capture file from atem_capture_open() recording all datagrams sent and received, NULL to disable.
+	 * Set to NULL by atem_init(). Records have no peer address since the socket only talks to one switcher.
+	 */
+	FILE* capture;
+#if ATEM_POSIX_BATCH
+	/**
+	 * @private
+	 * Packets received at once by atem_posix_readable(), parsed one at a time with atem_parse_batch()
+	 */
+	struct {
+		uint16_t len[ATEM_POSIX_BATCH];
+		uint16_t count;
+		uint16_t index;
+		uint8_t buf[ATEM_POSIX_BATCH][ATEM_PACKET_LEN_MAX];
+#if ATEM_POSIX_LATENCY
+		uint64_t recv_time[ATEM_POSIX_BATCH];
+#endif // ATEM_POSIX_LATENCY
+	} batch;
+#endif // ATEM_POSIX_BATCH
+#if ATEM_POSIX_LATENCY
+	/**
+	 * Receive-to-parse and parse-to-send latency histograms for received packets, reset by atem_init().
+	 * Print them with atem_latency_print().
+	 */
+	struct atem_latency latency;
+#endif // ATEM_POSIX_LATENCY
 };
 
 /**
@@ -51,8 +107,9 @@ enum atem_posix_status {
 	/**
 	 * The connection to the ATEM server was dropped.
 	 * This status will continuously be reported until the connection is re-established.
+	 * Reported after @ref ATEM_LIVENESS_TIMEOUT_MS without receiving any packet while connected.
 	 * Call atem_send() to automatically reconnect.
-	 * It is recommended to wait a few hundred milliseconds before attempting a reconnect to not harass the ATEM.
+	 * Reconnect attempts are reported at an exponential backoff to not harass the ATEM.
 	 */
 	ATEM_POSIX_STATUS_DROPPED
 };
@@ -92,6 +149,81 @@ enum atem_posix_status atem_recv(struct atem_posix_ctx* atem);
  */
 enum atem_posix_status atem_poll(struct atem_posix_ctx* atem);
 
+#if ATEM_SEND_WINDOW
+/**
+ * @brief Enqueues a command for reliable delivery to the ATEM server and sends it if connected.
+ *
+ * Commands are retransmitted by atem_poll() until acknowledged by the ATEM server.
+ * Commands enqueued while not connected are sent once connected and dropped if the connection is reopened.
+ *
+ * @param atem ATEM POSIX context to send the command with.
+ * @param name Command name as a 32 bit integer, can be constructed with ATEM_CMDNAME().
+ * @param payload Command payload to copy into the queue.
+ * @param len Length of the command payload.
+ * @return Indicates if the command was enqueued and sending was successful, `errno` is set on failure.
+ * `errno` is set to `ENOBUFS` if the queue is full or the command does not fit in a packet.
+ */
+bool atem_cmd_send(struct atem_posix_ctx* atem, uint32_t name, const void* payload, uint16_t len);
+
+/**
+ * @brief Sends all queued packets due for transmission or retransmission.
+ * @param atem ATEM POSIX context containing the queue.
+ * @return Indicates if sending data was successful or not, `errno` is set on failure.
+ */
+bool atem_flush(struct atem_posix_ctx* atem);
+#endif // ATEM_SEND_WINDOW
+
+/**
+ * @brief Gets milliseconds from the monotonic clock used for deadlines.
+ * @return Current time in milliseconds, wraps around.
+ */
+uint32_t atem_posix_now(void);
+
+/**
+ * @brief Gets socket to watch for readability when integrating with an external event loop.
+ * @param atem ATEM POSIX context to get socket for.
+ * @return UDP socket file descriptor for the connection.
+ */
+static inline int atem_posix_fd(const struct atem_posix_ctx* atem) {
+	return atem->sock;
+}
+
+/**
+ * @brief Gets absolute time when atem_posix_deadline_reached() has to be called.
+ * @param atem ATEM POSIX context to get deadline for.
+ * @return Deadline in milliseconds from the same clock as atem_posix_now(), wraps around.
+ * The deadline changes after calls to atem_posix_readable(), atem_posix_deadline_reached() or atem_cmd_send().
+ */
+uint32_t atem_posix_deadline(struct atem_posix_ctx* atem);
+
+/**
+ * @brief Reads, parses and acknowledges the next ATEM packet without blocking.
+ *
+ * Call this when the socket from atem_posix_fd() is readable and keep calling it,
+ * processing commands with atem_cmd_next() when it returns @ref ATEM_POSIX_STATUS_WRITE,
+ * until it returns @ref ATEM_POSIX_STATUS_NONE.
+ * With @ref ATEM_POSIX_BATCH enabled, all packets received at once are acknowledged
+ * together after the last of them has been returned.
+ *
+ * @param atem ATEM POSIX context to read data into.
+ * @return Status code describing the result from reading and parsing ATEM packet,
+ * @ref ATEM_POSIX_STATUS_NONE when there are no more packets to read.
+ */
+enum atem_posix_status atem_posix_readable(struct atem_posix_ctx* atem);
+
+/**
+ * @brief Handles timeouts for the connection without blocking.
+ *
+ * Call this when the time from atem_posix_deadline() is reached.
+ * Calling it before the deadline is harmless.
+ *
+ * @param atem ATEM POSIX context to handle timeouts for.
+ * @return @ref ATEM_POSIX_STATUS_DROPPED if the connection timed out, call atem_send() to reconnect.
+ * @ref ATEM_POSIX_STATUS_ERROR_NETWORK if queued commands could not be sent.
+ * @ref ATEM_POSIX_STATUS_NONE if nothing timed out.
+ */
+enum atem_posix_status atem_posix_deadline_reached(struct atem_posix_ctx* atem);
+
 /**
  * @brief Reads ATEM packets and returns its status or commands.
  * @param atem ATEM POSIX context to read data into.
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief Header-only C++17 bindings for the ATEM POSIX API
+ */
+
+// Include guard
+#ifndef ATEM_POSIX_HPP
+#define ATEM_POSIX_HPP
+
+#include <cerrno> // errno
+#include <cstdint> // uint32_t
+#include <system_error> // std::system_error, std::generic_category
+
+#include <netinet/in.h> // in_addr_t
+#include <unistd.h> // close
+
+#include "./atem.h" // struct atem
+#include "./atem_posix.h" // struct atem_posix_ctx, enum atem_posix_status, atem_init, atem_send, atem_poll, atem_posix_fd, atem_posix_deadline, atem_posix_readable, atem_posix_deadline_reached
+#include "./atem.hpp" // waccat::dispatcher
+
+namespace waccat {
+
+/**
+ * @brief ATEM connection owning its UDP socket.
+ *
+ * Sends the opening handshake on construction and closes the socket on destruction.
+ * Not copyable or movable since the ATEM context can reference its own buffers.
+ */
+class posix_connection {
+	struct atem_posix_ctx ctx;
+
+public:
+	/**
+	 * @brief Creates socket for ATEM server and sends opening handshake.
+	 * @param addr IP address of ATEM server in network byte order.
+	 * @throw std::system_error If socket could not be created or handshake could not be sent.
+	 */
+	explicit posix_connection(in_addr_t addr) {
+		if (!atem_init(&ctx, addr)) {
+			throw std::system_error(errno, std::generic_category(), "Failed to create ATEM socket");
+		}
+		if (!atem_send(&ctx)) {
+			const int err = errno;
+			close(ctx.sock);
+			throw std::system_error(err, std::generic_category(), "Failed to send ATEM handshake");
+		}
+	}
+
+	~posix_connection() {
+		close(ctx.sock);
+	}
+
+	posix_connection(const posix_connection&) = delete;
+	posix_connection& operator=(const posix_connection&) = delete;
+
+	/** Gets ATEM context for use with the core API. */
+	struct atem& state() noexcept { return ctx.atem; }
+	/** Gets POSIX context for use with the POSIX API. */
+	struct atem_posix_ctx& native() noexcept { return ctx; }
+
+	/** @copydoc atem_posix_fd */
+	int fd() const noexcept { return atem_posix_fd(&ctx); }
+	/** @copydoc atem_posix_deadline */
+	uint32_t deadline() noexcept { return atem_posix_deadline(&ctx); }
+	/** @copydoc atem_send */
+	bool send() noexcept { return atem_send(&ctx); }
+	/** @copydoc atem_poll */
+	enum atem_posix_status poll() noexcept { return atem_poll(&ctx); }
+	/** @copydoc atem_posix_readable */
+	enum atem_posix_status readable() noexcept { return atem_posix_readable(&ctx); }
+	/** @copydoc atem_posix_deadline_reached */
+	enum atem_posix_status deadline_reached() noexcept { return atem_posix_deadline_reached(&ctx); }
+
+	/**
+	 * @brief Dispatches all commands in the last parsed packet.
+	 * @tparam Dispatcher A @ref waccat::dispatcher with the command handlers.
+	 */
+	template <typename Dispatcher>
+	void process() {
+		Dispatcher::process(ctx.atem);
+	}
+};
+
+} // namespace waccat
+
+#endif // ATEM_POSIX_HPP
@@ -0,0 +1,173 @@
+#include <stdbool.h> // bool, true, false
+#include <stdint.h> // uint32_t, int32_t, UINT32_MAX, INT32_MAX
+#include <stddef.h> // NULL
+#include <assert.h> // assert
+#include <errno.h> // errno, EINTR
+
+#include <sys/epoll.h> // epoll_create1, epoll_ctl, epoll_wait, EPOLL_CTL_ADD, EPOLL_CTL_DEL, EPOLLIN, EPOLL_CLOEXEC, struct epoll_event
+#include <netinet/in.h> // in_addr_t
+#include <unistd.h> // close
+
+#include "./atem.h" // atem_cmd_available, atem_cmd_next
+#include "./atem_posix.h" // struct atem_posix_ctx, enum atem_posix_status, atem_init, atem_send, atem_posix_now, atem_posix_deadline, atem_posix_readable, atem_posix_deadline_reached, ATEM_POSIX_STATUS_NONE, ATEM_POSIX_STATUS_WRITE, ATEM_POSIX_STATUS_WRITE_ONLY, ATEM_POSIX_STATUS_DROPPED, ATEM_POSIX_STATUS_ERROR_NETWORK
+#include "./atem_posix_group.h" // struct atem_posix_group, struct atem_posix_group_ctx, ATEM_POSIX_GROUP_EVENTS
+
+
+
+// Creates epoll instance for group
+bool atem_group_init(struct atem_posix_group* group) {
+	assert(group != NULL);
+	group->epoll = epoll_create1(EPOLL_CLOEXEC);
+	group->ctxs = NULL;
+	group->current = NULL;
+	group->events_len = 0;
+	group->events_index = 0;
+	return group->epoll != -1;
+}
+
+// Closes all connections and the epoll instance
+void atem_group_close(struct atem_posix_group* group) {
+	assert(group != NULL);
+	while (group->ctxs != NULL) {
+		atem_group_remove(group, group->ctxs);
+	}
+	close(group->epoll);
+}
+
+// Initializes connection, registers its socket to epoll and sends opening handshake
+bool atem_group_add(struct atem_posix_group* group, struct atem_posix_group_ctx* ctx, in_addr_t addr) {
+	assert(group != NULL);
+	assert(ctx != NULL);
+
+	// Creates socket for connection
+	if (!atem_init(&ctx->posix, addr)) {
+		return false;
+	}
+
+	// Registers socket to group
+	struct epoll_event event = { .events = EPOLLIN, .data.ptr = ctx };
+	if (epoll_ctl(group->epoll, EPOLL_CTL_ADD, ctx->posix.sock, &event) == -1) {
+		int err = errno;
+		close(ctx->posix.sock);
+		errno = err;
+		return false;
+	}
+
+	// Links connection into group
+	ctx->prev = NULL;
+	ctx->next = group->ctxs;
+	if (group->ctxs != NULL) {
+		group->ctxs->prev = ctx;
+	}
+	group->ctxs = ctx;
+
+	// Sends opening handshake
+	atem_send(&ctx->posix);
+
+	return true;
+}
+
+// Unregisters connection from group and closes its socket
+void atem_group_remove(struct atem_posix_group* group, struct atem_posix_group_ctx* ctx) {
+	assert(group != NULL);
+	assert(ctx != NULL);
+
+	// Unlinks connection from group
+	if (ctx->prev != NULL) {
+		ctx->prev->next = ctx->next;
+	}
+	else {
+		assert(group->ctxs == ctx);
+		group->ctxs = ctx->next;
+	}
+	if (ctx->next != NULL) {
+		ctx->next->prev = ctx->prev;
+	}
+
+	// Prevents pending events from referencing removed connection
+	if (group->current == ctx) {
+		group->current = NULL;
+	}
+	for (int i = group->events_index; i < group->events_len; i++) {
+		if (group->events[i].data.ptr == ctx) {
+			group->events[i].data.ptr = NULL;
+		}
+	}
+
+	// Unregisters socket from epoll and closes it
+	epoll_ctl(group->epoll, EPOLL_CTL_DEL, ctx->posix.sock, NULL);
+	close(ctx->posix.sock);
+}
+
+// Returns status codes or iterates through commands in ATEM packets for all connections in group
+int32_t atem_group_next(struct atem_posix_group* group, struct atem_posix_group_ctx** ctx_out) {
+	assert(group != NULL);
+	assert(ctx_out != NULL);
+
+	while (true) {
+		// Iterates through commands of last processed packet
+		struct atem_posix_group_ctx* ctx = group->current;
+		if (ctx != NULL) {
+			if (atem_cmd_available(&ctx->posix.atem)) {
+				*ctx_out = ctx;
+				return (int32_t)atem_cmd_next(&ctx->posix.atem);
+			}
+
+			group->current = NULL;
+		}
+
+		// Processes sockets that were readable in last epoll wait until all their packets are read
+		if (group->events_index < group->events_len) {
+			ctx = group->events[group->events_index].data.ptr;
+			enum atem_posix_status status = (ctx != NULL) ? atem_posix_readable(&ctx->posix) : ATEM_POSIX_STATUS_NONE;
+			switch (status) {
+				case ATEM_POSIX_STATUS_NONE: {
+					group->events_index++;
+					continue;
+				}
+				case ATEM_POSIX_STATUS_WRITE_ONLY: {
+					continue;
+				}
+				case ATEM_POSIX_STATUS_WRITE: {
+					group->current = ctx;
+					continue;
+				}
+				default: {
+					*ctx_out = ctx;
+					return (int32_t)status;
+				}
+			}
+		}
+
+		// Reconnects first timed out connection, flushes send queues and gets time until next deadline
+		const uint32_t now = atem_posix_now();
+		uint32_t wait = UINT32_MAX;
+		for (ctx = group->ctxs; ctx != NULL; ctx = ctx->next) {
+			const enum atem_posix_status status = atem_posix_deadline_reached(&ctx->posix);
+			if (status != ATEM_POSIX_STATUS_NONE) {
+				if (status == ATEM_POSIX_STATUS_DROPPED) {
+					atem_send(&ctx->posix);
+				}
+				*ctx_out = ctx;
+				return (int32_t)status;
+			}
+			const int32_t remaining = (int32_t)(atem_posix_deadline(&ctx->posix) - now);
+			if (remaining <= 0) {
+				wait = 0;
+			}
+			else if ((uint32_t)remaining < wait) {
+				wait = (uint32_t)remaining;
+			}
+		}
+
+		// Waits for sockets to become readable or next connection to time out
+		int events_len = epoll_wait(group->epoll, group->events, ATEM_POSIX_GROUP_EVENTS, (wait > INT32_MAX) ? -1 : (int)wait);
+		if (events_len == -1) {
+			if (errno == EINTR) continue;
+			*ctx_out = NULL;
+			return ATEM_POSIX_STATUS_ERROR_NETWORK;
+		}
+		group->events_len = events_len;
+		group->events_index = 0;
+	}
+}
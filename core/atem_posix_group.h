@@ -0,0 +1,127 @@
+/**
+ * @file
+ * @brief Linux epoll engine driving multiple ATEM connections from a single thread
+ */
+
+// Include guard
+#ifndef ATEM_POSIX_GROUP_H
+#define ATEM_POSIX_GROUP_H
+
+#include <stdbool.h> // bool
+#include <stdint.h> // uint32_t, int32_t
+
+#include <netinet/in.h> // in_addr_t
+#include <sys/epoll.h> // struct epoll_event
+
+#include "./atem_posix.h" // struct atem_posix_ctx
+
+/**
+ * Maximum number of readable sockets to get from epoll at once.
+ */
+#ifndef ATEM_POSIX_GROUP_EVENTS
+#define ATEM_POSIX_GROUP_EVENTS 64
+#endif // ATEM_POSIX_GROUP_EVENTS
+
+
+
+/**
+ * @brief ATEM connection driven by an @ref atem_posix_group.
+ */
+struct atem_posix_group_ctx {
+	/**
+	 * ATEM POSIX context with its own UDP socket for the connection.
+	 */
+	struct atem_posix_ctx posix;
+	/**
+	 * @private
+	 * Links to other connections in the same group
+	 */
+	struct atem_posix_group_ctx* prev;
+	struct atem_posix_group_ctx* next;
+};
+
+/**
+ * @brief Group of ATEM connections sharing a single epoll instance and timeout handling.
+ */
+struct atem_posix_group {
+	/**
+	 * @private
+	 * Epoll instance all connection sockets are registered to
+	 */
+	int epoll;
+	/**
+	 * @private
+	 * Linked list of all connections in the group
+	 */
+	struct atem_posix_group_ctx* ctxs;
+	/**
+	 * @private
+	 * Connection with commands currently being iterated through
+	 */
+	struct atem_posix_group_ctx* current;
+	/**
+	 * @private
+	 * Readable sockets from last epoll wait not yet processed
+	 */
+	struct epoll_event events[ATEM_POSIX_GROUP_EVENTS];
+	int events_len;
+	int events_index;
+};
+
+// Makes functions available to C++ with extern C block
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Creates epoll instance for a group of ATEM connections.
+ * @param group Group to initialize.
+ * @return Indicates if initialization was successful or not, `errno` set on failure.
+ */
+bool atem_group_init(struct atem_posix_group* group);
+
+/**
+ * @brief Closes epoll instance and all connections in the group without sending closing handshakes.
+ * @param group Group to close.
+ */
+void atem_group_close(struct atem_posix_group* group);
+
+/**
+ * @brief Creates connection to an ATEM server and adds it to the group.
+ *
+ * The opening handshake is sent right away and the connection is driven by atem_group_next()
+ * from then on. The context has to stay valid until it is removed from the group.
+ *
+ * @param group Group to add connection to.
+ * @param ctx Connection context to initialize.
+ * @param addr IP address of ATEM server to connect to.
+ * @return Indicates if adding connection was successful or not, `errno` set on failure.
+ */
+bool atem_group_add(struct atem_posix_group* group, struct atem_posix_group_ctx* ctx, in_addr_t addr);
+
+/**
+ * @brief Removes connection from the group and closes its socket without sending a closing handshake.
+ * @param group Group containing the connection.
+ * @param ctx Connection context to remove.
+ */
+void atem_group_remove(struct atem_posix_group* group, struct atem_posix_group_ctx* ctx);
+
+/**
+ * @brief Reads ATEM packets for all connections in group and returns status or commands for one of them.
+ *
+ * Works like atem_next() for every connection in the group. Packets are
+ * acknowledged, dropped connections are reconnected and timeouts for all
+ * connections are tracked by the group.
+ *
+ * @param group Group to read data for.
+ * @param[out] ctx Set to the connection the returned status or command belongs to,
+ * NULL for @ref ATEM_POSIX_STATUS_ERROR_NETWORK from epoll.
+ * @return Status code from atem_poll() or command in an ATEM packet.
+ */
+int32_t atem_group_next(struct atem_posix_group* group, struct atem_posix_group_ctx** ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ATEM_POSIX_GROUP_H
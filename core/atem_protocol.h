@@ -50,6 +50,23 @@
 // Byte offset from start of command block to command name
 #define ATEM_OFFSET_CMDNAME 4
 
+// Camera control command payload indexes
+#define ATEM_INDEX_CC_DEST      0
+#define ATEM_INDEX_CC_CATEGORY  1
+#define ATEM_INDEX_CC_PARAMETER 2
+#define ATEM_INDEX_CC_TYPE      3
+#define ATEM_INDEX_CC_OPERATION 4
+#define ATEM_INDEX_CC_COUNT8    5
+#define ATEM_INDEX_CC_COUNT16   7
+#define ATEM_INDEX_CC_COUNT32   9
+
+// Byte offset from start of camera control command payload to its data
+#define ATEM_OFFSET_CC_DATA 16
+
+// Camera control operations
+#define ATEM_CC_OPERATION_ASSIGN 0x00
+#define ATEM_CC_OPERATION_OFFSET 0x01
+
 // ATEM resends
 #define ATEM_RESENDS         10
 #define ATEM_RESENDS_CLOSING 1
@@ -0,0 +1,200 @@
+#include <stdbool.h> // bool, true, false
+#include <stdint.h> // uint8_t, uint16_t, uint32_t
+#include <assert.h> // assert
+#include <stddef.h> // NULL
+
+#include "./atem.h" // struct atem, struct atem_cc_cache_entry, atem_protocol_major, atem_protocol_minor, atem_tally_all_updated, ATEM_CC_CACHE_VALUE_LEN, ATEM_CMDNAME_VERSION, ATEM_CMDNAME_TALLY, ATEM_CMDNAME_CAMERACONTROL, ATEM_CMDNAME_PROGRAM, ATEM_CMDNAME_PREVIEW, ATEM_TALLY_WORDS
+#include "./atem_protocol.h" // ATEM_INDEX_CC_DEST, ATEM_INDEX_CC_CATEGORY, ATEM_INDEX_CC_PARAMETER, ATEM_INDEX_CC_TYPE, ATEM_INDEX_CC_OPERATION, ATEM_INDEX_CC_COUNT8, ATEM_INDEX_CC_COUNT16, ATEM_INDEX_CC_COUNT32, ATEM_OFFSET_CC_DATA, ATEM_CC_OPERATION_ASSIGN, ATEM_CC_OPERATION_OFFSET
+#include "./atem_state.h" // struct atem_state, enum atem_state_dirty, ATEM_STATE_ME_MAX, ATEM_STATE_CAMERAS_MAX, ATEM_STATE_CC_ENTRIES, ATEM_STATE_SOURCE_UNKNOWN
+
+// Minimum payload lengths of commands used by the state
+#define STATE_LEN_VERSION 4
+#define STATE_LEN_SOURCE 4
+
+// Multiplier for hashing camera control keys, the golden ratio in 32 bits
+#define STATE_CC_HASH 0x9e3779b1u
+
+// Updates program or preview source for mix effect bus
+static bool atem_state_source_update(uint16_t sources[ATEM_STATE_ME_MAX], struct atem* atem) {
+	const uint8_t me = atem->cmd_payload_buf[0];
+	const uint16_t source = (uint16_t)(atem->cmd_payload_buf[2] << 8 | atem->cmd_payload_buf[3]);
+	if (me >= ATEM_STATE_ME_MAX || sources[me] == source) {
+		return false;
+	}
+	sources[me] = source;
+	return true;
+}
+
+// Gets index of camera control entry for camera and parameter, or of the unused entry to store it in
+static uint32_t atem_state_cc_index(const struct atem_state* state, uint8_t dest, uint8_t category, uint8_t parameter) {
+	const uint32_t key = (uint32_t)dest << 16 | (uint32_t)category << 8 | parameter;
+	uint32_t index = (uint32_t)(((uint64_t)(key * STATE_CC_HASH) * ATEM_STATE_CC_ENTRIES) >> 32);
+	while (state->cc_dest[index] != 0 && (state->cc_dest[index] != dest || state->cc[index].category != category || state->cc[index].parameter != parameter)) {
+		index = (index + 1) % ATEM_STATE_CC_ENTRIES;
+	}
+	return index;
+}
+
+// Updates camera control value for tracked camera and parameter, applying relative offsets to known values
+static bool atem_state_cc_update(struct atem_state* state, struct atem* atem) {
+	const uint8_t* const cc_buf = atem->cmd_payload_buf;
+	const uint8_t dest = cc_buf[ATEM_INDEX_CC_DEST];
+	const uint8_t category = cc_buf[ATEM_INDEX_CC_CATEGORY];
+	const uint8_t parameter = cc_buf[ATEM_INDEX_CC_PARAMETER];
+	const uint8_t type = cc_buf[ATEM_INDEX_CC_TYPE];
+	if (dest == 0 || dest > ATEM_STATE_CAMERAS_MAX) {
+		return false;
+	}
+
+	// Ignores triggers without data, values too long to track and malformed data
+	const uint8_t count8 = cc_buf[ATEM_INDEX_CC_COUNT8];
+	const uint8_t count16 = cc_buf[ATEM_INDEX_CC_COUNT16];
+	const uint8_t count32 = cc_buf[ATEM_INDEX_CC_COUNT32];
+	const uint16_t len = (uint16_t)(count8 + count16 * 2 + count32 * 4);
+	if (len == 0 || len > ATEM_CC_CACHE_VALUE_LEN || (ATEM_OFFSET_CC_DATA + len) > atem->cmd_payload_len) {
+		return false;
+	}
+	const uint8_t* const data = &cc_buf[ATEM_OFFSET_CC_DATA];
+	const uint32_t slot = atem_state_cc_index(state, dest, category, parameter);
+	struct atem_cc_cache_entry* const entry = &state->cc[slot];
+	const bool known = state->cc_dest[slot] != 0;
+
+	// Gets value after assignment or offset
+	uint8_t value[ATEM_CC_CACHE_VALUE_LEN];
+	switch (cc_buf[ATEM_INDEX_CC_OPERATION]) {
+		case ATEM_CC_OPERATION_ASSIGN: {
+			for (uint16_t i = 0; i < len; i++) {
+				value[i] = data[i];
+			}
+			break;
+		}
+		case ATEM_CC_OPERATION_OFFSET: {
+			// Offsets can only be applied to a known value with the same layout
+			if (!known || entry->len != len || entry->type != type) return false;
+
+			// Adds big endian offsets to each value with wrap around
+			const uint16_t width = (uint16_t)((count8 > 0) + (count16 > 0) * 2 + (count32 > 0) * 4);
+			for (uint16_t index = 0; index < len; index += width) {
+				uint16_t carry = 0;
+				for (uint16_t offset = width; offset-- > 0;) {
+					const uint16_t sum = (uint16_t)(entry->value[index + offset] + data[index + offset] + carry);
+					value[index + offset] = (uint8_t)(sum & 0xff);
+					carry = sum >> 8;
+				}
+			}
+			break;
+		}
+		default: {
+			return false;
+		}
+	}
+
+	// Only updates state if value changed
+	if (known && entry->len == len && entry->type == type) {
+		uint16_t i = 0;
+		while (i < len && entry->value[i] == value[i]) i++;
+		if (i == len) return false;
+	}
+
+	// Stores new parameter in unused entry unless the table is too full to keep lookups short
+	if (!known) {
+		if (state->cc_len >= ATEM_STATE_CC_ENTRIES * 3 / 4) return false;
+		state->cc_dest[slot] = dest;
+		state->cc_len++;
+	}
+	entry->category = category;
+	entry->parameter = parameter;
+	entry->type = type;
+	entry->len = (uint8_t)len;
+	for (uint16_t i = 0; i < len; i++) {
+		entry->value[i] = value[i];
+	}
+	state->cc_dirty |= (uint32_t)1 << (dest - 1);
+	return true;
+}
+
+// Resets state to nothing received
+void atem_state_init(struct atem_state* state) {
+	assert(state != NULL);
+	state->dirty = 0;
+	state->cc_dirty = 0;
+	state->protocol_major = 0;
+	state->protocol_minor = 0;
+	for (uint32_t i = 0; i < ATEM_STATE_ME_MAX; i++) {
+		state->program[i] = ATEM_STATE_SOURCE_UNKNOWN;
+		state->preview[i] = ATEM_STATE_SOURCE_UNKNOWN;
+	}
+	for (uint32_t i = 0; i < ATEM_TALLY_WORDS; i++) {
+		state->tally.pgm[i] = 0;
+		state->tally.pvw[i] = 0;
+		state->tally.changed[i] = 0;
+	}
+	state->tally.len = 0;
+	state->cc_len = 0;
+	for (uint32_t i = 0; i < ATEM_STATE_CC_ENTRIES; i++) {
+		state->cc_dest[i] = 0;
+	}
+}
+
+// Gets camera control value from hash table
+const struct atem_cc_cache_entry* atem_state_cc_get(const struct atem_state* state, uint8_t dest, uint8_t category, uint8_t parameter) {
+	assert(state != NULL);
+	if (dest == 0 || dest > ATEM_STATE_CAMERAS_MAX) {
+		return NULL;
+	}
+	const uint32_t index = atem_state_cc_index(state, dest, category, parameter);
+	if (state->cc_dest[index] == 0) {
+		return NULL;
+	}
+	return &state->cc[index];
+}
+
+// Updates state from command in ATEM packet
+bool atem_state_update(struct atem_state* state, struct atem* atem, uint32_t name) {
+	assert(state != NULL);
+	assert(atem != NULL);
+
+	switch (name) {
+		// Updates protocol version
+		case ATEM_CMDNAME_VERSION: {
+			if (atem->cmd_payload_len < STATE_LEN_VERSION) return false;
+			const uint16_t major = atem_protocol_major(atem);
+			const uint16_t minor = atem_protocol_minor(atem);
+			if (major == state->protocol_major && minor == state->protocol_minor) return false;
+			state->protocol_major = major;
+			state->protocol_minor = minor;
+			state->dirty |= ATEM_STATE_DIRTY_VERSION;
+			return true;
+		}
+		// Updates tally for all inputs
+		case ATEM_CMDNAME_TALLY: {
+			if (!atem_tally_all_updated(atem, &state->tally)) return false;
+			state->dirty |= ATEM_STATE_DIRTY_TALLY;
+			return true;
+		}
+		// Updates program source for mix effect bus
+		case ATEM_CMDNAME_PROGRAM: {
+			if (atem->cmd_payload_len < STATE_LEN_SOURCE) return false;
+			if (!atem_state_source_update(state->program, atem)) return false;
+			state->dirty |= ATEM_STATE_DIRTY_PROGRAM;
+			return true;
+		}
+		// Updates preview source for mix effect bus
+		case ATEM_CMDNAME_PREVIEW: {
+			if (atem->cmd_payload_len < STATE_LEN_SOURCE) return false;
+			if (!atem_state_source_update(state->preview, atem)) return false;
+			state->dirty |= ATEM_STATE_DIRTY_PREVIEW;
+			return true;
+		}
+		// Updates camera control value for tracked cameras
+		case ATEM_CMDNAME_CAMERACONTROL: {
+			if (atem->cmd_payload_len < ATEM_OFFSET_CC_DATA) return false;
+			if (!atem_state_cc_update(state, atem)) return false;
+			state->dirty |= ATEM_STATE_DIRTY_CC;
+			return true;
+		}
+	}
+
+	// Ignores commands not part of the state
+	return false;
+}
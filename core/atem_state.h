@@ -0,0 +1,199 @@
+/**
+ * @file
+ * @brief Incrementally updated snapshot of ATEM switcher state
+ *
+ * Keeps the state most consumers need from an ATEM switcher in a single
+ * structure, updated from each parsed command with atem_state_update().
+ * Readers can query the current state at any time without re-parsing any
+ * commands and use the dirty flags to only act on what changed.
+ */
+
+// Include guard
+#ifndef ATEM_STATE_H
+#define ATEM_STATE_H
+
+#include <stdbool.h> // bool
+#include <stdint.h> // uint8_t, uint16_t, uint32_t
+#include <assert.h> // assert
+#include <stddef.h> // NULL
+
+#include "./atem.h" // struct atem, struct atem_tally, struct atem_cc_cache_entry, ATEM_CC_CACHE_VALUE_LEN, ATEM_CMD_FILTER_BIT, ATEM_CMDNAME_VERSION, ATEM_CMDNAME_TALLY, ATEM_CMDNAME_CAMERACONTROL, ATEM_CMDNAME_PROGRAM, ATEM_CMDNAME_PREVIEW
+
+/**
+ * Number of mix effect buses to track program and preview sources for.
+ */
+#ifndef ATEM_STATE_ME_MAX
+#define ATEM_STATE_ME_MAX (4)
+#endif // ATEM_STATE_ME_MAX
+
+/**
+ * Number of cameras to track camera control values for, starting at camera identifier 1.
+ */
+#ifndef ATEM_STATE_CAMERAS_MAX
+#define ATEM_STATE_CAMERAS_MAX (8)
+#endif // ATEM_STATE_CAMERAS_MAX
+
+/**
+ * Number of camera control values to track for all cameras together, each using 13 bytes of the state.
+ * Values are only stored for parameters received, and values for new parameters are not tracked
+ * once three quarters of the entries are used to keep lookups short.
+ */
+#ifndef ATEM_STATE_CC_ENTRIES
+#define ATEM_STATE_CC_ENTRIES (ATEM_STATE_CAMERAS_MAX * 64)
+#endif // ATEM_STATE_CC_ENTRIES
+
+// Cameras with updated camera control values are tracked in a 32 bit bitset
+#if ATEM_STATE_CAMERAS_MAX > 32
+#error ATEM_STATE_CAMERAS_MAX can not be larger than 32
+#endif // ATEM_STATE_CAMERAS_MAX > 32
+
+// Number of camera control values used is tracked in a 16 bit integer
+#if ATEM_STATE_CC_ENTRIES < 1 || ATEM_STATE_CC_ENTRIES > 0xffff
+#error ATEM_STATE_CC_ENTRIES has to be between 1 and 65535
+#endif // ATEM_STATE_CC_ENTRIES < 1 || ATEM_STATE_CC_ENTRIES > 0xffff
+
+/**
+ * Source in @ref atem_state.program and @ref atem_state.preview before it has been received.
+ */
+#define ATEM_STATE_SOURCE_UNKNOWN (0xffff)
+
+/**
+ * Command filter for @ref atem.cmd_filter with all commands used by atem_state_update().
+ */
+#define ATEM_STATE_CMD_FILTER (\
+	ATEM_CMD_FILTER_BIT(ATEM_CMDNAME_VERSION) |\
+	ATEM_CMD_FILTER_BIT(ATEM_CMDNAME_TALLY) |\
+	ATEM_CMD_FILTER_BIT(ATEM_CMDNAME_CAMERACONTROL) |\
+	ATEM_CMD_FILTER_BIT(ATEM_CMDNAME_PROGRAM) |\
+	ATEM_CMD_FILTER_BIT(ATEM_CMDNAME_PREVIEW)\
+)
+
+/**
+ * Flags in @ref atem_state.dirty indicating what parts of the state have changed.
+ */
+enum atem_state_dirty {
+	/** Protocol version in @ref atem_state.protocol_major or @ref atem_state.protocol_minor changed */
+	ATEM_STATE_DIRTY_VERSION = 0x01,
+	/** Tally for at least one input in @ref atem_state.tally changed, see atem_tally_changed() */
+	ATEM_STATE_DIRTY_TALLY = 0x02,
+	/** Program source changed for at least one mix effect bus in @ref atem_state.program */
+	ATEM_STATE_DIRTY_PROGRAM = 0x04,
+	/** Preview source changed for at least one mix effect bus in @ref atem_state.preview */
+	ATEM_STATE_DIRTY_PREVIEW = 0x08,
+	/** Camera control values changed for cameras in @ref atem_state.cc_dirty */
+	ATEM_STATE_DIRTY_CC = 0x10
+};
+
+/**
+ * Snapshot of ATEM switcher state, frequently accessed values placed first.
+ */
+struct atem_state {
+	/**
+	 * Bits from @ref atem_state_dirty for parts of the state changed since last cleared by the reader
+	 */
+	uint32_t dirty;
+	/**
+	 * Bitset of cameras with camera control values changed since last cleared by the reader,
+	 * bit `n` represents camera identifier `n + 1`
+	 */
+	uint32_t cc_dirty;
+	/**
+	 * Major version of the ATEM protocol, 0 until received
+	 */
+	uint16_t protocol_major;
+	/**
+	 * Minor version of the ATEM protocol, 0 until received
+	 */
+	uint16_t protocol_minor;
+	/**
+	 * Source in program for each mix effect bus, @ref ATEM_STATE_SOURCE_UNKNOWN until received
+	 */
+	uint16_t program[ATEM_STATE_ME_MAX];
+	/**
+	 * Source in preview for each mix effect bus, @ref ATEM_STATE_SOURCE_UNKNOWN until received
+	 */
+	uint16_t preview[ATEM_STATE_ME_MAX];
+	/**
+	 * Tally states for all inputs
+	 */
+	struct atem_tally tally;
+	/**
+	 * @private
+	 * Number of entries used in @ref atem_state.cc
+	 */
+	uint16_t cc_len;
+	/**
+	 * @private
+	 * Camera identifier for each entry in @ref atem_state.cc, 0 if the entry is unused
+	 */
+	uint8_t cc_dest[ATEM_STATE_CC_ENTRIES];
+	/**
+	 * @private
+	 * Camera control values for all cameras in a hash table keyed by camera identifier, category and parameter,
+	 * use atem_state_cc_get() to access a single value.
+	 */
+	struct atem_cc_cache_entry cc[ATEM_STATE_CC_ENTRIES];
+};
+
+// Makes functions available in C++
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Resets state to nothing received.
+ *
+ * Has to be called before the first update and should be called again when
+ * a new connection is accepted since the switcher resends its entire state.
+ *
+ * @param[out] state State to reset.
+ */
+void atem_state_init(struct atem_state* state);
+
+/**
+ * @brief Updates state from command in ATEM packet.
+ *
+ * Call this function for every command returned by atem_cmd_next(), commands
+ * not part of the state are ignored. Setting @ref atem.cmd_filter to
+ * @ref ATEM_STATE_CMD_FILTER skips all other commands before they reach this function.
+ *
+ * @param[in,out] state State to update.
+ * @param[in] atem The atem connection context containing the parsed command.
+ * @param name Command name returned by atem_cmd_next().
+ * @returns Indicates if the command changed the state.
+ */
+bool atem_state_update(struct atem_state* state, struct atem* atem, uint32_t name);
+
+/**
+ * @brief Gets and clears dirty flags.
+ * @param[in,out] state State to get dirty flags for.
+ * @returns Bits from @ref atem_state_dirty changed since last call.
+ */
+static inline uint32_t atem_state_dirty_take(struct atem_state* state) {
+	assert(state != NULL);
+	const uint32_t dirty = state->dirty;
+	state->dirty = 0;
+	return dirty;
+}
+
+/**
+ * @brief Gets current value of a camera control parameter of a camera.
+ *
+ * Values are assigned by absolute updates and modified by relative offsets,
+ * without clamping to the range of the parameter. Offsets to values not yet
+ * known and values longer than @ref ATEM_CC_CACHE_VALUE_LEN are not tracked.
+ *
+ * @param[in] state State to get value from.
+ * @param dest Camera identifier to get value for.
+ * @param category Camera control category of the parameter.
+ * @param parameter Camera control parameter within @p category.
+ * @returns Value or NULL if it is not known or the parameter is not tracked.
+ */
+const struct atem_cc_cache_entry* atem_state_cc_get(const struct atem_state* state, uint8_t dest, uint8_t category, uint8_t parameter);
+
+// Ends extern C block
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ATEM_STATE_H
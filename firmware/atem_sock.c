@@ -3,21 +3,23 @@
 #include <stdbool.h> // bool, true, false
 
 #include <lwip/udp.h> // struct udp_pcb, udp_send, udp_new, udp_recv, udp_connect, udp_remove
-#include <lwip/pbuf.h> // struct pbuf, pbuf_alloc_reference, PBUF_REF, pbuf_free, pbuf_copy_partial
+#include <lwip/pbuf.h> // struct pbuf, pbuf_alloc_reference, PBUF_REF, pbuf_free, pbuf_get_contiguous
 #include <lwip/ip_addr.h> // ip_addr_t, IPADDR4_INIT, ip_2_ip4
 #include <lwip/err.h> // err_t, ERR_OK
-#include <lwip/arch.h> // LWIP_UNUSED_ARG
+#include <lwip/arch.h> // LWIP_UNUSED_ARG, LWIP_RAND
+#include <lwip/sys.h> // sys_now
 #include <lwip/timeouts.h> // sys_timeout, sys_untimeout
 #include <lwip/netif.h> // struct netif, netif_ip4_addr, netif_ip4_netmask, netif_ip4_gw, NETIF_FOREACH, netif_is_up, netif_is_link_up
 #include <lwip/ip4.h> // ip4_route
 #include <lwip/ip4_addr.h> // ip4_addr_isany_val, ip4_addr_netcmp, ip4_addr_t
 
-#include "../core/atem.h" // struct atem atem_connection_open, atem_parse, ATEM_STATUS_WRITE, ATEM_STATUS_CLOSING, ATEM_STATUS_REJECTED, ATEM_STATUS_WRITE_ONLY, ATEM_STATUS_CLOSED, ATEM_STATUS_ACCEPTED, ATEM_STATUS_ERROR, ATEM_STATUS_NONE, ATEM_TIMEOUT, ATEM_PORT, atem_cmd_available, atem_cmd_next, ATEM_CMDNAME_VERSION, ATEM_CMDNAME_TALLY, ATEM_CMDNAME_CAMERACONTROL, atem_protocol_major, atem_protocol_minor, ATEM_TIMEOUT_MS
+#include "./user_config.h" // DEBUG_TALLY, DEBUG_CC, DEBUG_ATEM, PIN_CONN, PIN_PGM, PIN_PVW, PIN_SCL, PIN_SDA, ATEM_LIVENESS_TIMEOUT_MS
+#include "../core/atem.h" // struct atem atem_connection_open, atem_parse_buf, atem_parse_reordered, atem_cc_translate_buf, struct atem_cc_cache, atem_cc_cache_changed, atem_cc_cache_reset, ATEM_STATUS_WRITE, ATEM_STATUS_CLOSING, ATEM_STATUS_REJECTED, ATEM_STATUS_WRITE_ONLY, ATEM_STATUS_CLOSED, ATEM_STATUS_ACCEPTED, ATEM_STATUS_ERROR, ATEM_STATUS_NONE, ATEM_TIMEOUT, ATEM_PORT, atem_cmd_available, atem_cmd_next, ATEM_CMDNAME_VERSION, ATEM_CMDNAME_TALLY, ATEM_CMDNAME_CAMERACONTROL, atem_protocol_major, atem_protocol_minor, ATEM_TIMEOUT_MS, ATEM_LIVENESS_TIMEOUT_MS, atem_reconnect_delay, ATEM_RECONNECT_DELAY_MS
 #include "../core/atem_protocol.h" // ATEM_INDEX_FLAGS, ATEM_INDEX_REMOTEID_HIGH, ATEM_INDEX_REMOTEID_LOW, ATEM_FLAG_ACK
-#include "./user_config.h" // DEBUG_TALLY, DEBUG_CC, DEBUG_ATEM, PIN_CONN, PIN_PGM, PIN_PVW, PIN_SCL, PIN_SDA
+#include "../core/atem_dispatch.h" // ATEM_DISPATCH_DEFINE_CONTEXT, ATEM_DISPATCH_FILTER
 #include "./led.h" // LED_TALLY, LED_CONN, led_init
-#include "./sdi.h" // SDI_ENABLED, sdi_write_tally, sdi_write_cc, sdi_init
-#include "./debug.h" // DEBUG_PRINTF, DEBUG_ERR_PRINTF, DEBUG_IP, IP_FMT, IP_VALUE, WRAP, DEBUG_ATEM_PRINTF
+#include "./sdi.h" // SDI_ENABLED, SDI_CC_LEN_MAX, sdi_write_tally, sdi_write_cc, sdi_init
+#include "./debug.h" // DEBUG_PRINTF, DEBUG_ERR_PRINTF, DEBUG_CC_PRINTF, DEBUG_IP, IP_FMT, IP_VALUE, WRAP, DEBUG_ATEM_PRINTF
 #include "./wlan.h" // wlan_softap_disable
 #include "./ws2812.h" // ws2812_init, ws2812_update
 #include "./atem_sock.h"
@@ -59,6 +61,11 @@
 #define BOOT_INFO_PIN_I2C "SDI shield: disabled\n"
 #endif // SDI_ENABLED
 
+// Uses time since boot to jitter reconnects if lwIP port has no random number generator
+#ifndef LWIP_RAND
+#define LWIP_RAND() sys_now()
+#endif // LWIP_RAND
+
 
 
 // ATEM connection context
@@ -71,6 +78,12 @@ const char* const atem_state_dropped = "Lost connection";
 const char* const atem_state_rejected = "Rejected";
 const char* const atem_state_disconnected = "Disconnected";
 
+#if DEBUG
+// Time since boot when opening handshake was first sent, used to report time to first tally
+static uint32_t atem_connect_time;
+static bool atem_tally_reported;
+#endif // DEBUG
+
 
 
 // Resets tally and connection status when disconnected from ATEM
@@ -104,16 +117,151 @@ static void atem_send(struct udp_pcb* pcb) {
 	DEBUG_ERR_PRINTF("Failed to send pbuf to ATEM: %d\n", (int)err);
 }
 
+// Turns on connection status LED and disables access point when connected to ATEM
+static void atem_cmd_version(void) {
+	DEBUG_PRINTF(
+		"Got ATEM protocol version: %d.%d\n"
+		"Connected to ATEM\n",
+		atem_protocol_major(&atem), atem_protocol_minor(&atem)
+	);
+	LED_CONN(true);
+	atem_state = atem_state_connected;
+	wlan_softap_disable();
+}
+
+// Outputs tally status on GPIO pins and SDI
+static void atem_cmd_tally(void) {
+#if DEBUG
+	// Reports time from boot and from first opening handshake until tally is known
+	if (!atem_tally_reported) {
+		atem_tally_reported = true;
+		const uint32_t now = sys_now();
+		DEBUG_PRINTF(
+			"Time to first tally: %lu ms from boot, %lu ms from connecting\n",
+			(unsigned long)now, (unsigned long)(now - atem_connect_time)
+		);
+	}
+#endif // DEBUG
+
+	// Only processes tally updates for selected camera
+	if (!atem_tally_updated(&atem)) return;
+
+	DEBUG_TALLY_PRINTF(
+		"Changed state: %s\n",
+		((atem.tally_pgm) ? "PGM" : ((atem.tally_pvw) ? "PVW" : "NONE"))
+	);
+
+	// Sets tally pin states
+	LED_TALLY(atem.tally_pgm, atem.tally_pvw);
+
+	// Sets RGB tally states
+	ws2812_update(atem.tally_pgm, atem.tally_pvw);
+
+	// Writes tally data over SDI
+	sdi_write_tally(atem.dest, atem.tally_pgm, atem.tally_pvw);
+}
+
+#if defined(SDI_ENABLED) || DEBUG_CC
+// Camera control data translated from all commands in an ATEM packet with 2 header bytes for SDI register address
+static uint8_t cc_buf[2 + SDI_CC_LEN_MAX];
+static uint16_t cc_len;
+
+// Last camera control values written to camera, used to drop updates not changing anything
+static struct atem_cc_cache cc_cache;
+
+// Writes all camera control data batched from ATEM packet over SDI in a single transaction
+static void atem_cc_flush(void) {
+	if (cc_len == 0) return;
+	sdi_write_cc(cc_buf, cc_len);
+	cc_len = 0;
+}
+
+// Batches camera control data to send over SDI
+static void atem_cmd_cc(void) {
+	// Only processes camera control updates for selected camera
+	if (!atem_cc_updated(&atem)) return;
+
+	// Drops updates assigning the same value as already written to camera to save I2C bus time
+	if (!atem_cc_cache_changed(&atem, &cc_cache)) {
+		DEBUG_CC_PRINTF("Suppressed unchanged camera control data, %u suppressed and %u written\n", (unsigned)cc_cache.suppressed, (unsigned)cc_cache.forwarded);
+		return;
+	}
+
+	// Translates ATEM camera control protocol to SDI camera control protocol, flushing batch when full
+	uint16_t sdi_len = atem_cc_translate_buf(&atem, &cc_buf[2 + cc_len], SDI_CC_LEN_MAX - cc_len);
+	if (sdi_len == 0 && cc_len > 0) {
+		atem_cc_flush();
+		sdi_len = atem_cc_translate_buf(&atem, &cc_buf[2], SDI_CC_LEN_MAX);
+	}
+	if (sdi_len == 0) {
+		DEBUG_ERR_PRINTF("Invalid camera control data\n");
+		return;
+	}
+
+#if DEBUG_CC
+	char buf_print[SDI_CC_LEN_MAX * 3 + 1];
+	uint16_t offset = 0;
+	for (uint16_t i = 0; i < sdi_len; i++) {
+		buf_print[offset++] = ' ';
+		buf_print[offset++] = "0123456789abcdef"[cc_buf[2 + cc_len + i] >> 4];
+		buf_print[offset++] = "0123456789abcdef"[cc_buf[2 + cc_len + i] & 0xf];
+	}
+	buf_print[offset] = '\0';
+	DEBUG_CC_PRINTF("Got camera control data:%s\n", buf_print);
+#endif // DEBUG_CC
+
+	// Adds translated data to batch written over SDI after all commands in packet are processed
+	cc_len += sdi_len;
+}
+
+// Registers camera control command only when it is used
+#define ATEM_COMMANDS_CC(X) X(ATEM_CMDNAME_CAMERACONTROL, 24, atem_cmd_cc)
+
+// Forgets camera control values written to camera since camera state is unknown on new connection
+#define atem_cc_reset() atem_cc_cache_reset(&cc_cache)
+#else // SDI_ENABLED || DEBUG_CC
+#define ATEM_COMMANDS_CC(X)
+#define atem_cc_flush()
+#define atem_cc_reset()
+#endif // SDI_ENABLED || DEBUG_CC
+
+// Commands processed from ATEM with minimum payload lengths required by their handlers
+#define ATEM_COMMANDS(X) \
+	X(ATEM_CMDNAME_VERSION, 4, atem_cmd_version) \
+	X(ATEM_CMDNAME_TALLY, 2, atem_cmd_tally) \
+	ATEM_COMMANDS_CC(X)
+
+// Dispatches command to its registered handler reading the command from the atem context
+ATEM_DISPATCH_DEFINE_CONTEXT(atem_cmd_dispatch, ATEM_COMMANDS)
+
+// Processes all commands in parsed ATEM packet
+static void atem_cmds_process(void) {
+	while (atem_cmd_available(&atem)) {
+		const uint32_t cmd_name = atem_cmd_next(&atem);
+		atem_cmd_dispatch(cmd_name, atem.cmd_payload_len);
+	}
+}
+
+// Reconnects ATEM after timeout
+static void atem_timeout_callback(void* arg);
+
+// Waits full timeout with jitter before reconnecting when ATEM ends connection to not harass it
+static void atem_timeout_full(struct udp_pcb* pcb) {
+	sys_untimeout(atem_timeout_callback, pcb);
+	sys_timeout(ATEM_TIMEOUT_MS + LWIP_RAND() % ATEM_RECONNECT_DELAY_MS, atem_timeout_callback, pcb);
+}
+
 // Processes received ATEM packet
-static inline void atem_process(struct udp_pcb* pcb) {
+static inline void atem_process(struct udp_pcb* pcb, uint8_t* buf, uint16_t len) {
 	// Parses received ATEM packet
-	switch (atem_parse(&atem)) {
+	switch (atem_parse_buf(&atem, buf, len)) {
 		case ATEM_STATUS_ERROR:
 		case ATEM_STATUS_CLOSED:
 		case ATEM_STATUS_NONE: return;
 		case ATEM_STATUS_REJECTED: {
 			atem_state = atem_state_rejected;
 			DEBUG_PRINTF("ATEM connection rejected\n");
+			atem_timeout_full(pcb);
 			return;
 		}
 		case ATEM_STATUS_WRITE: {
@@ -124,17 +272,22 @@ static inline void atem_process(struct udp_pcb* pcb) {
 			atem_state = atem_state_disconnected;
 			tally_reset();
 			DEBUG_PRINTF("ATEM connection closed\n");
+			atem_timeout_full(pcb);
 			break;
 		}
-		case ATEM_STATUS_ACCEPTED:
+		case ATEM_STATUS_ACCEPTED: {
+			atem_cc_reset();
+			atem_send(pcb);
+			return;
+		}
 		case ATEM_STATUS_WRITE_ONLY: {
 			atem_send(pcb);
 #if DEBUG_ATEM
 			if (atem.remote_id_last > 0 && atem.write_buf[ATEM_INDEX_FLAGS] == ATEM_FLAG_ACK) {
 				DEBUG_ATEM_PRINTF(
 					"out-of-order packet: %d\n",
-					atem.read_buf[ATEM_INDEX_REMOTEID_HIGH] << 8 |
-					atem.read_buf[ATEM_INDEX_REMOTEID_LOW]
+					atem.parse_buf[ATEM_INDEX_REMOTEID_HIGH] << 8 |
+					atem.parse_buf[ATEM_INDEX_REMOTEID_LOW]
 				);
 			}
 #endif // DEBUG_ATEM
@@ -146,81 +299,25 @@ static inline void atem_process(struct udp_pcb* pcb) {
 	atem_send(pcb);
 
 	// Processes commands received from ATEM
-	while (atem_cmd_available(&atem)) switch (atem_cmd_next(&atem)) {
-		// Turns on connection status LED and disables access point when connected to ATEM
-		case ATEM_CMDNAME_VERSION: {
-			DEBUG_PRINTF(
-				"Got ATEM protocol version: %d.%d\n"
-				"Connected to ATEM\n",
-				atem_protocol_major(&atem), atem_protocol_minor(&atem)
-			);
-			LED_CONN(true);
-			atem_state = atem_state_connected;
-			wlan_softap_disable();
-			break;
-		}
-		// Outputs tally status on GPIO pins and SDI
-		case ATEM_CMDNAME_TALLY: {
-			// Only processes tally updates for selected camera
-			if (!atem_tally_updated(&atem)) break;
-
-			DEBUG_TALLY_PRINTF(
-				"Changed state: %s\n",
-				((atem.tally_pgm) ? "PGM" : ((atem.tally_pvw) ? "PVW" : "NONE"))
-			);
-
-			// Sets tally pin states
-			LED_TALLY(atem.tally_pgm, atem.tally_pvw);
-
-			// Sets RGB tally states
-			ws2812_update(atem.tally_pgm, atem.tally_pvw);
+	atem_cmds_process();
 
-			// Writes tally data over SDI
-			sdi_write_tally(atem.dest, atem.tally_pgm, atem.tally_pvw);
-
-			break;
-		}
-#if defined(SDI_ENABLED) || DEBUG_CC
-		// Sends camera control data over SDI
-		case ATEM_CMDNAME_CAMERACONTROL: {
-			// Only processes camera control updates for selected camera
-			if (!atem_cc_updated(&atem)) break;
-
-			// Translates ATEM camera control protocol to SDI camera control protocol
-			atem_cc_translate(&atem);
-
-#if DEBUG_CC
-			char buf_print[255 * 3 + 1];
-			uint8_t offset = 0;
-			for (uint16_t i = 0; i < atem.cmd_len; i++) {
-				buf_print[offset++] = ' ';
-				buf_print[offset++] = "0123456789abcdef"[atem.cmd_payload_buf[i] >> 4];
-				buf_print[offset++] = "0123456789abcdef"[atem.cmd_payload_buf[i] & 0xf];
-			}
-			buf_print[offset] = '\0';
-			DEBUG_PRINTF("[ Camera Control ] Got camera control data:%s\n", buf_print);
-#endif // DEBUG_CC
-
-			// Writes camera control data over SDI
-			sdi_write_cc(atem.cmd_payload_buf - 2, atem.cmd_payload_len);
-
-			break;
-		}
-#endif // SDI_ENABLED || DEBUG_CC
-		// Lets compiler know not all command names should be expected
-		default: {
-			break;
-		}
+	// Processes packets held by reorder window that are now in sequence
+	while (atem_parse_reordered(&atem) == ATEM_STATUS_WRITE) {
+		atem_send(pcb);
+		atem_cmds_process();
 	}
+
+	// Writes camera control data from all commands in packet over SDI at once
+	atem_cc_flush();
 }
 
 // Reconnects ATEM after timeout
 static void atem_timeout_callback(void* arg) {
-	// Restarts timeout timer
-	sys_timeout(ATEM_TIMEOUT_MS, atem_timeout_callback, arg);
+	// Retries opening handshake with exponential backoff until connected
+	sys_timeout(atem_reconnect_delay(&atem, LWIP_RAND()), atem_timeout_callback, arg);
 
 	// Sends handshake to ATEM
-	atem_connection_open(&atem);
+	atem_connection_open(&atem, LWIP_RAND());
 	atem_send(arg);
 
 	// Indicates connection lost with LEDs, SDI, HTML and serial
@@ -244,19 +341,21 @@ static void atem_recv_callback(void* arg, struct udp_pcb* pcb, struct pbuf* p, c
 	LWIP_UNUSED_ARG(addr);
 	LWIP_UNUSED_ARG(port);
 
-	// Copies contents of pbuf to atem structs processing buffer
-	if (!pbuf_copy_partial(p, atem.read_buf, sizeof(atem.read_buf), 0)) {
-		DEBUG_ERR_PRINTF("Failed to copy ATEM packet\n");
+	// Gets contiguous ATEM packet, only copying to atem structs read buffer if pbuf is chained
+	uint16_t len = (p->tot_len < sizeof(atem.read_buf)) ? p->tot_len : sizeof(atem.read_buf);
+	uint8_t* buf = pbuf_get_contiguous(p, atem.read_buf, sizeof(atem.read_buf), len, 0);
+	if (buf == NULL) {
+		DEBUG_ERR_PRINTF("Failed to get ATEM packet\n");
 		pbuf_free(p);
 		return;
 	}
 
-	// Resets drop timeout timer
+	// Resets drop timeout timer, detecting dropped connection after a few missed pings
 	sys_untimeout(atem_timeout_callback, pcb);
-	sys_timeout(ATEM_TIMEOUT_MS, atem_timeout_callback, pcb);
+	sys_timeout(ATEM_LIVENESS_TIMEOUT_MS, atem_timeout_callback, pcb);
 
 	// Processes the received ATEM packet
-	atem_process(pcb);
+	atem_process(pcb, buf, len);
 
 	// Releases pbuf
 	pbuf_free(p);
@@ -284,11 +383,15 @@ static void atem_netif_poll(void* arg) {
 			);
 			DEBUG_PRINTF("Connecting to ATEM\n");
 
-			// Sends ATEM handshake
+			// Sends ATEM handshake with session id mixed with local address to differ between devices booting together
+			atem_connection_open(&atem, LWIP_RAND() ^ netif_ip4_addr(netif)->addr);
+#if DEBUG
+			atem_connect_time = sys_now();
+#endif // DEBUG
 			atem_send(pcb);
 
 			// Enables ATEM timeout callback function
-			sys_timeout(ATEM_TIMEOUT_MS, atem_timeout_callback, pcb);
+			sys_timeout(atem_reconnect_delay(&atem, LWIP_RAND()), atem_timeout_callback, pcb);
 
 			// Returns when initialization is complete
 			return;
@@ -349,8 +452,8 @@ struct udp_pcb* atem_init(uint32_t addr, uint8_t dest) {
 	// Initializes RGB LED
 	ws2812_init();
 
-	// Initializes ATEM struct for handshake
-	atem_connection_open(&atem);
+	// Skips commands without a handler when iterating, most of the state dump at connect is never processed
+	atem.cmd_filter = ATEM_DISPATCH_FILTER(ATEM_COMMANDS);
 
 	// Tries to connect to SDI shield
 	if (!sdi_init(dest)) {
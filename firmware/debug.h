@@ -134,6 +134,13 @@
 #define DEBUG_TALLY_PRINTF(...)
 #endif // DEBUG_TALLY
 
+// Only prints camera control debug info when it is enabled in user_config.h
+#if DEBUG_CC
+#define DEBUG_CC_PRINTF(...) DEBUG_PRINTF("[ Camera Control ] " __VA_ARGS__)
+#else // DEBUG_CC
+#define DEBUG_CC_PRINTF(...)
+#endif // DEBUG_CC
+
 // Only prints ATEM debug info when it is enabled in user_config.h
 #if DEBUG_ATEM
 #define DEBUG_ATEM_PRINTF(...) DEBUG_PRINTF("[ ATEM ] " __VA_ARGS__)
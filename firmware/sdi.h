@@ -15,6 +15,9 @@
 #error Both PIN_SCL and PIN_SDA has to be defined if SDI shield is to be used or none of them defined if SDI shield is not to be used
 #endif
 
+// Maximum length of camera control data written in a single I2C transaction, excluding 2 byte register address
+#define SDI_CC_LEN_MAX 252
+
 // Strips out SDI communication functions if SDI is disabled
 #ifdef SDI_ENABLED
 bool sdi_init(uint8_t dest);
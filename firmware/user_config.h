@@ -136,6 +136,25 @@
 
 
 
+/**
+ * @def ATEM_LIVENESS_TIMEOUT_MS
+ * @brief Sets milliseconds without receiving any packet before the ATEM connection is considered dropped.
+ *
+ * The ATEM switcher pings every 500 ms, so the default reconnects after three
+ * missed pings. Official clients wait the full ATEM timeout of 5000 ms, which
+ * is what the client conformance tests expect, so set it to 5000 when
+ * running those tests against the device.
+ *
+ * Valid numbers are any positive integers up to 5000.
+ *
+ * **Default value:** `1500`
+ */
+#if defined(ATEM_LIVENESS_TIMEOUT_MS) && (ATEM_LIVENESS_TIMEOUT_MS <= 0 || ATEM_LIVENESS_TIMEOUT_MS > 5000)
+#error Invalid configuration value for ATEM_LIVENESS_TIMEOUT_MS
+#endif // ATEM_LIVENESS_TIMEOUT_MS <= 0 || ATEM_LIVENESS_TIMEOUT_MS > 5000
+
+
+
 /**
  * @def PIN_PGM
  * @brief Sets pin number to use when outputting program tally to LED.
@@ -9,8 +9,9 @@
 
 #include "../core/atem.h" // ATEM_PACKET_LEN_MAX, ATEM_PACKET_LEN_MAX_SOFT
 #include "../core/atem_protocol.h" // ATEM_LEN_HEADER, ATEM_INDEX_FLAGS, ATEM_INDEX_LEN_HIGH, ATEM_INDEX_LEN_LOW, ATEM_INDEX_ACKID_HIGH, ATEM_INDEX_ACKID_LOW, ATEM_INDEX_LOCALID_HIGH, ATEM_INDEX_LOCALID_LOW, ATEM_INDEX_UNKNOWNID_HIGH, ATEM_INDEX_UNKNOWNID_LOW, ATEM_INDEX_REMOTEID_HIGH, ATEM_INDEX_REMOTEID_LOW, ATEM_FLAG_ACKREQ
-#include "./atem_session.h" // struct atem_session, atem_session_send
+#include "./atem_session.h" // struct atem_session, atem_session_send, atem_session_send_begin, atem_session_send_flush
 #include "./atem_packet.h" // struct atem_packet, atem_packet_enqueue, ATEM_PACKET_FLAG_NONE, atem_packet_create
+#include "../core/atem_dispatch.h" // ATEM_DISPATCH_DEFINE
 #include "./atem_server.h" // atem_server, atem_server_broadcast
 #include "./atem_cache.h"
 
@@ -111,21 +112,22 @@ static struct atem_packet* atem_cache_packet_create(
 ) {
 	// Creates ATEM packet acknowledge request
 	uint16_t packet_len = chunk->len + ATEM_LEN_HEADER;
-	struct atem_packet* packet_next = atem_packet_create(1, packet_len);
-	packet_next->buf[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACKREQ;
-	packet_next->buf[ATEM_INDEX_LEN_HIGH] |= packet_len >> 8;
-	packet_next->buf[ATEM_INDEX_LEN_LOW] = packet_len & 0xff;
-	packet_next->buf[ATEM_INDEX_ACKID_HIGH] = 0x00;
-	packet_next->buf[ATEM_INDEX_ACKID_LOW] = 0x00;
-	packet_next->buf[ATEM_INDEX_LOCALID_HIGH] = 0x00;
-	packet_next->buf[ATEM_INDEX_LOCALID_LOW] = 0x00;
-	packet_next->buf[ATEM_INDEX_UNKNOWNID_HIGH] = 0x00;
-	packet_next->buf[ATEM_INDEX_UNKNOWNID_LOW] = 0x00;
-	packet_next->buf[ATEM_INDEX_REMOTEID_HIGH] = remote_id >> 8;
-	packet_next->buf[ATEM_INDEX_REMOTEID_LOW] = remote_id & 0xff;
+	uint8_t* buf;
+	struct atem_packet* packet_next = atem_packet_create(1, packet_len, &buf);
+	buf[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACKREQ;
+	buf[ATEM_INDEX_LEN_HIGH] |= packet_len >> 8;
+	buf[ATEM_INDEX_LEN_LOW] = packet_len & 0xff;
+	buf[ATEM_INDEX_ACKID_HIGH] = 0x00;
+	buf[ATEM_INDEX_ACKID_LOW] = 0x00;
+	buf[ATEM_INDEX_LOCALID_HIGH] = 0x00;
+	buf[ATEM_INDEX_LOCALID_LOW] = 0x00;
+	buf[ATEM_INDEX_UNKNOWNID_HIGH] = 0x00;
+	buf[ATEM_INDEX_UNKNOWNID_LOW] = 0x00;
+	buf[ATEM_INDEX_REMOTEID_HIGH] = remote_id >> 8;
+	buf[ATEM_INDEX_REMOTEID_LOW] = remote_id & 0xff;
 
 	// Copies over from data chunk to packet payload
-	memcpy(packet_next->buf + ATEM_LEN_HEADER, chunk, chunk->len);
+	memcpy(buf + ATEM_LEN_HEADER, chunk, chunk->len);
 
 	// Sends packet and enqueues on global queue
 	atem_session_send(session, packet_next->buf);
@@ -214,16 +216,17 @@ static void atem_cache_update_cc(uint8_t* buf_req, uint16_t len) {
 
 	// Broadcasts parameter update to all connected clients
 	const uint8_t res_len = sizeof(*cc_cache) + ATEM_LEN_HEADER;
-	struct atem_packet* packet = atem_packet_create(atem_server.sessions_connected, res_len);
-	packet->buf[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACKREQ;
-	packet->buf[ATEM_INDEX_LEN_LOW] = res_len;
-	packet->buf[ATEM_INDEX_ACKID_HIGH] = 0;
-	packet->buf[ATEM_INDEX_ACKID_LOW] = 0;
-	packet->buf[ATEM_INDEX_LOCALID_HIGH] = 0;
-	packet->buf[ATEM_INDEX_LOCALID_LOW] = 0;
-	packet->buf[ATEM_INDEX_UNKNOWNID_LOW] = 0;
-	packet->buf[ATEM_INDEX_UNKNOWNID_LOW] = 0;
-	memcpy(packet->buf + ATEM_LEN_HEADER, cc_cache, sizeof(*cc_cache));
+	uint8_t* buf;
+	struct atem_packet* packet = atem_packet_create(atem_server.sessions_connected, res_len, &buf);
+	buf[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACKREQ;
+	buf[ATEM_INDEX_LEN_LOW] = res_len;
+	buf[ATEM_INDEX_ACKID_HIGH] = 0;
+	buf[ATEM_INDEX_ACKID_LOW] = 0;
+	buf[ATEM_INDEX_LOCALID_HIGH] = 0;
+	buf[ATEM_INDEX_LOCALID_LOW] = 0;
+	buf[ATEM_INDEX_UNKNOWNID_LOW] = 0;
+	buf[ATEM_INDEX_UNKNOWNID_LOW] = 0;
+	memcpy(buf + ATEM_LEN_HEADER, cc_cache, sizeof(*cc_cache));
 	atem_server_broadcast(packet, ATEM_PACKET_FLAG_NONE);
 }
 
@@ -427,7 +430,8 @@ void atem_cache_dump(struct atem_session* session) {
 	struct atem_cache_chunk* chunk = atem_cache.data;
 	assert(chunk != NULL);
 
-	// Dumps first cache data buffer
+	// Dumps first cache data buffer, sending all buffers with as few system calls as possible
+	atem_session_send_begin();
 	struct atem_packet* packet = atem_cache_packet_create(session, chunk, 1);
 	session->packet_head = packet;
 
@@ -445,6 +449,7 @@ void atem_cache_dump(struct atem_session* session) {
 		packet->sessions[0].packet_session_index_next = 0;
 		packet = packet_next;
 	}
+	atem_session_send_flush();
 
 	// Ends local packet queue correctly
 	packet->sessions[0].packet_next = NULL;
@@ -453,6 +458,14 @@ void atem_cache_dump(struct atem_session* session) {
 	session->remote_id = atem_cache.chunks_count;
 }
 
+// Commands updating cache with minimum payload lengths required by their handlers
+// Camera control handler checks length itself to report unexpected lengths
+#define ATEM_CACHE_COMMANDS(X) \
+	X(ATEM_CMDNAME('C', 'C', 'm', 'd'), 0, atem_cache_update_cc)
+
+// Dispatches command to its registered cache handler
+ATEM_DISPATCH_DEFINE(atem_cache_dispatch, ATEM_CACHE_COMMANDS)
+
 // Updates ATEM cache data from ATEM command
 void atem_cache_update(uint8_t* buf, uint16_t len) {
 	assert(buf != NULL);
@@ -460,21 +473,17 @@ void atem_cache_update(uint8_t* buf, uint16_t len) {
 
 	uint16_t offset = ATEM_LEN_HEADER;
 	while (offset < len) {
-		// Parses command header
+		// Parses command header and stops on malformed command length
 		uint8_t* cmd_buf = &buf[offset];
 		uint16_t cmd_len = cmd_buf[0] << 8 | cmd_buf[1];
+		if (cmd_len < ATEM_LEN_CMDHEADER || cmd_len > (len - offset)) {
+			fprintf(stderr, "Invalid command length: %d\n", cmd_len);
+			return;
+		}
 		uint32_t cmd_name = ATEM_CMDNAME(cmd_buf[4], cmd_buf[5], cmd_buf[6], cmd_buf[7]);
-		uint16_t cmd_payload_len = cmd_len - ATEM_LEN_CMDHEADER;
-		uint8_t* cmd_payload_buf = cmd_buf + ATEM_LEN_CMDHEADER;
 		offset += cmd_len;
 
 		// Processes command
-		switch (cmd_name) {
-			// Updates ATEM camera control data
-			case ATEM_CMDNAME('C', 'C', 'm', 'd'): {
-				atem_cache_update_cc(cmd_payload_buf, cmd_payload_len);
-				break;
-			}
-		}
+		atem_cache_dispatch(cmd_name, cmd_buf + ATEM_LEN_CMDHEADER, cmd_len - ATEM_LEN_CMDHEADER);
 	}
 }
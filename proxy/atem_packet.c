@@ -4,23 +4,25 @@
 #include <time.h> // struct timespec, timespec_get, TIME_UTC
 #include <assert.h> // assert
 #include <stdbool.h> // true, false
-#include <string.h> // memset
+#include <string.h> // memset, memcpy
 
 #include "../core/atem.h" // ATEM_PACKET_LEN_MAX_SOFT
-#include "../core/atem_protocol.h" // ATEM_INDEX_REMOTEID_HIGH, ATEM_INDEX_REMOTEID_LOW, ATEM_LEN_HEADER, ATEM_INDEX_FLAGS, ATEM_FLAG_RETX, ATEM_LEN_SYN, ATEM_FLAG_SYN, ATEM_INDEX_LEN_LOW, ATEM_INDEX_OPCODE, ATEM_OPCODE_CLOSING, ATEM_RESENDS_CLOSING
+#include "../core/atem_protocol.h" // ATEM_INDEX_REMOTEID_HIGH, ATEM_INDEX_REMOTEID_LOW, ATEM_LEN_HEADER, ATEM_INDEX_FLAGS, ATEM_FLAG_RETX, ATEM_FLAG_ACKREQ, ATEM_LEN_SYN, ATEM_FLAG_SYN, ATEM_INDEX_LEN_LOW, ATEM_INDEX_OPCODE, ATEM_OPCODE_CLOSING, ATEM_RESENDS_CLOSING
 #include "./atem_server.h" // atem_server, atem_server_release, atem_server_broadcast
-#include "./atem_session.h" // struct atem_session, atem_session_send, atem_session_get, atem_session_lookup_get, atem_session_release, atem_session_terminate, atem_session_drop
+#include "./atem_session.h" // struct atem_session, atem_session_send, atem_session_send_header, atem_session_send_begin, atem_session_send_flush, atem_session_get, atem_session_lookup_get, atem_session_release, atem_session_terminate, atem_session_drop
 #include "./atem_packet.h" // struct atem_packet_session, struct atem_packet, ATEM_PACKET_FLAG_NONE
 #include "./atem_debug.h" // DEBUG_PRINTF
 
 // Preallocated closing request buffer
-static uint8_t buf_closing[ATEM_LEN_SYN] = {
+static const uint8_t buf_closing[ATEM_LEN_SYN] = {
+	[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN,
 	[ATEM_INDEX_LEN_LOW] = ATEM_LEN_SYN,
 	[ATEM_INDEX_OPCODE] = ATEM_OPCODE_CLOSING
 };
 
 // Preallocated ping buffer
-static uint8_t buf_ping[ATEM_LEN_HEADER] = {
+static const uint8_t buf_ping[ATEM_LEN_HEADER] = {
+	[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACKREQ,
 	[ATEM_INDEX_LEN_LOW] = ATEM_LEN_HEADER
 };
 
@@ -103,27 +105,35 @@ struct atem_packet* atem_packet_alloc(uint16_t sessions_count, uint16_t oversize
 	return packet;
 }
 
-// Creates an ATEM packet with allocated packet buffer of specified length
-struct atem_packet* atem_packet_create(uint16_t sessions_count, uint16_t packet_len) {
+/**
+ * Creates an ATEM packet with allocated packet buffer of specified length
+ * @attention Buffer is only writable through buf until the packet is sent for the first time
+ */
+struct atem_packet* atem_packet_create(uint16_t sessions_count, uint16_t packet_len, uint8_t** buf) {
 	assert(packet_len >= ATEM_LEN_HEADER);
 	assert(packet_len <= ATEM_PACKET_LEN_MAX_SOFT);
+	assert(buf != NULL);
 
 	struct atem_packet* packet = atem_packet_alloc(sessions_count, packet_len);
-	packet->buf = (uint8_t*)&packet->sessions[sessions_count];
+	*buf = (uint8_t*)&packet->sessions[sessions_count];
+	packet->buf = *buf;
 	return packet;
 }
 
-// Transmits the ATEM packet to the session peer
-void atem_packet_send(struct atem_packet* packet, struct atem_packet_session* packet_session) {
+// Transmits the ATEM packet to the session peer with remote id and additional flags in a per session header
+void atem_packet_send(struct atem_packet* packet, struct atem_packet_session* packet_session, uint8_t flags) {
 	assert(packet != NULL);
 	assert(packet_session != NULL);
 	struct atem_session* session = atem_session_get(atem_session_lookup_get(packet_session->session_id));
 	assert(session != NULL);
 	assert(session->session_id == packet_session->session_id);
 
-	packet->buf[ATEM_INDEX_REMOTEID_HIGH] = packet_session->remote_id_high;
-	packet->buf[ATEM_INDEX_REMOTEID_LOW] = packet_session->remote_id_low;
-	atem_session_send(session, packet->buf);
+	uint8_t header[ATEM_LEN_HEADER];
+	memcpy(header, packet->buf, ATEM_LEN_HEADER);
+	header[ATEM_INDEX_FLAGS] |= flags;
+	header[ATEM_INDEX_REMOTEID_HIGH] = packet_session->remote_id_high;
+	header[ATEM_INDEX_REMOTEID_LOW] = packet_session->remote_id_low;
+	atem_session_send_header(session, header, packet->buf);
 }
 
 // Enqueues packet to ATEM server for retransmission
@@ -244,7 +254,7 @@ void atem_packet_retransmit(struct timespec* now) {
 	// Sends packet to sessions as retransmit if there are retransmits left
 	if (packet->resends_remaining > 0) {
 		assert(packet == atem_server.packet_queue_head);
-		packet->buf[ATEM_INDEX_FLAGS] |= ATEM_FLAG_RETX;
+		atem_session_send_begin();
 		for (uint16_t i = 0; i < packet->sessions_remaining; i++) {
 			uint16_t packet_session_index = packet->sessions[i].packet_session_index;
 			struct atem_packet_session* packet_session = atem_packet_session_get(packet, packet_session_index);
@@ -254,8 +264,9 @@ void atem_packet_retransmit(struct timespec* now) {
 				(void*)packet,
 				packet_session->session_id
 			);
-			atem_packet_send(packet, packet_session);
+			atem_packet_send(packet, packet_session, ATEM_FLAG_RETX);
 		}
+		atem_session_send_flush();
 		atem_packet_requeue(now);
 		packet->resends_remaining--;
 		return;
@@ -294,10 +305,10 @@ void atem_packet_retransmit(struct timespec* now) {
 	}
 
 	// Replaces packet buffer with preallocated closing request
-	buf_closing[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN;
 	packet->buf = buf_closing;
 
 	// Starts closing sessions when packet has run out of retransmits
+	atem_session_send_begin();
 	for (uint16_t i = 0; i < packet->sessions_remaining; i++) {
 		uint16_t packet_session_index = packet->sessions[i].packet_session_index;
 		struct atem_packet_session* packet_session = atem_packet_session_get(packet, packet_session_index);
@@ -320,8 +331,9 @@ void atem_packet_retransmit(struct timespec* now) {
 		packet_session->remote_id_low = 0;
 
 		// Sends closing request to session
-		atem_packet_send(packet, packet_session);
+		atem_packet_send(packet, packet_session, 0);
 	}
+	atem_session_send_flush();
 
 	// Re-initializes packet for closing request
 	packet->resends_remaining = ATEM_RESENDS_CLOSING;
@@ -342,7 +354,7 @@ void atem_packet_broadcast_close(void) {
 	// Creates, broadcasts and enqueues closing handshake packet
 	struct atem_packet* packet = atem_packet_alloc(atem_server.sessions_len, 0);
 	packet->buf = buf_closing;
-	buf_closing[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN;
+	atem_session_send_begin();
 	for (int16_t session_index = atem_server.sessions_len - 1; session_index >= 0; session_index--) {
 		struct atem_session* session = atem_session_get(session_index);
 		assert(atem_session_lookup_get(session->session_id) == session_index);
@@ -360,6 +372,7 @@ void atem_packet_broadcast_close(void) {
 
 		atem_session_send(session, packet->buf);
 	}
+	atem_session_send_flush();
 	atem_packet_enqueue(packet, ATEM_PACKET_FLAG_CLOSING);
 	assert(atem_server.packet_queue_head == packet);
 	assert(atem_server.packet_queue_tail == packet);
@@ -372,7 +385,6 @@ void atem_packet_broadcast_ping(struct timespec* now) {
 	DEBUG_PRINTF("Pings all %d connected clients\n", atem_server.sessions_connected);
 	struct atem_packet* packet = atem_packet_alloc(atem_server.sessions_connected, 0);
 	packet->buf = buf_ping;
-	buf_ping[ATEM_INDEX_FLAGS] = ATEM_FLAG_ACKREQ;
 	atem_server_broadcast(packet, ATEM_PACKET_FLAG_NONE);
 
 	// Sets timestamp for next ping
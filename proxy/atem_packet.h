@@ -34,8 +34,8 @@ struct atem_packet {
 	// Global packet queue sorted based on how close its timeout is
 	struct atem_packet* next;
 	struct atem_packet* prev;
-	// The actual packet data to transmit
-	uint8_t* buf;
+	// The actual packet data to transmit, never modified after creation as headers are built per session when sending
+	const uint8_t* buf;
 	// Number of sessions that still haven't acknowledged the packet, used for retransmits
 	uint16_t sessions_remaining;
 	// Length of the sessions array, should only used for asserts and debug printing
@@ -55,8 +55,8 @@ struct atem_packet {
 struct atem_packet_session* atem_packet_session_get(struct atem_packet* packet, uint16_t packet_session_index);
 
 struct atem_packet* atem_packet_alloc(uint16_t sessions_count, uint16_t oversize);
-struct atem_packet* atem_packet_create(uint16_t sessions_count, uint16_t packet_len);
-void atem_packet_send(struct atem_packet* packet, struct atem_packet_session* packet_session);
+struct atem_packet* atem_packet_create(uint16_t sessions_count, uint16_t packet_len, uint8_t** buf);
+void atem_packet_send(struct atem_packet* packet, struct atem_packet_session* packet_session, uint8_t flags);
 void atem_packet_enqueue(struct atem_packet* packet, uint8_t flags);
 void atem_packet_dequeue(struct atem_packet* packet);
 void atem_packet_flush(struct atem_packet* packet, uint16_t packet_session_index);
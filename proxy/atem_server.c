@@ -1,22 +1,31 @@
+// Enables recvmmsg on Linux for receiving batches of datagrams in a single system call
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif // __linux__ && !_GNU_SOURCE
+
 #include <stdlib.h> // malloc, free
 #include <assert.h> // assert
 #include <stdbool.h> // bool, false, true
-#include <stddef.h> // NULL
-#include <stdint.h> // uint8_t, uint16_t, int16_t
-#include <stdio.h> // perror
-#include <errno.h> // errno
-
-#include <sys/socket.h> // socket, AF_INET, SOCK_DGRAM, bind, struct sockaddr, recvfrom
+#include <stddef.h> // NULL, size_t
+#include <stdint.h> // uint8_t, uint16_t, int16_t, uint64_t
+#include <stdio.h> // perror, printf, fflush, stdout
+#include <errno.h> // errno, EAGAIN, EWOULDBLOCK
+#include <time.h> // timespec_get, TIME_UTC
+
+#include <sys/socket.h> // socket, AF_INET, SOCK_DGRAM, bind, struct sockaddr, recvmsg, struct msghdr, recvmmsg, struct mmsghdr, MSG_DONTWAIT
+#include <sys/uio.h> // struct iovec
 #include <netinet/in.h> // struct sockaddr_in
 #include <arpa/inet.h> // htons, INADDR_ANY
 #include <unistd.h> // close
 
 #include "./atem_debug.h" // DEBUG_PRINTF, DEBUG_PRINT_BUF
-#include "./atem_server.h" // struct atem_server, atem_session_get, atem_session_lookup_get, atem_session_lookup_clear, ATEM_SERVER_SESSIONS_MULTIPLIER
+#include "./atem_server.h" // struct atem_server, ATEM_SERVER_RECV_BATCH, ATEM_SERVER_RECV_ROUNDS, atem_session_get, atem_session_lookup_get, atem_session_lookup_clear, ATEM_SERVER_SESSIONS_MULTIPLIER
 #include "./atem_cache.h" // atem_cache_update
-#include "./atem_session.h" // struct atem_session
+#include "./atem_session.h" // struct atem_session, atem_session_send_begin, atem_session_send_flush, atem_session_send_latency
 #include "./atem_packet.h" // struct atem_packet, atem_packet_release, atem_packet_close, atem_packet_enqueue
 #include "../core/atem.h" // ATEM_PORT, ATEM_PACKET_LEN_MAX
+#include "../core/atem_capture.h" // atem_capture_write, ATEM_CAPTURE_DIR_RECV
+#include "../core/atem_latency.h" // atem_latency_enable, atem_latency_now, atem_latency_recv_time, atem_latency_record, atem_latency_print, ATEM_LATENCY_CONTROL_LEN
 #include "../core/atem_protocol.h" // ATEM_RESEND_TIME, ATEM_PING_INTERVAL, ATEM_INDEX_SESSIONID_HIGH, ATEM_INDEX_FLAGS, ATEM_FLAG_SYN, ATEM_LEN_SYN, ATEM_INDEX_OPCODE, ATEM_OPCODE_OPEN
 #include "./atem_server.h"
 
@@ -66,6 +75,17 @@ bool atem_server_init(void) {
 		return false;
 	}
 
+	// Enables kernel receive timestamps when tracking latency
+	if (atem_server.latency_interval > 0) {
+		atem_server.latency.kernel = atem_latency_enable(atem_server.sock);
+		if (!atem_server.latency.kernel) {
+			printf("Kernel receive timestamps not available, measuring latency from when packets are read\n");
+		}
+		int timespec_result = timespec_get(&atem_server.latency_timestamp, TIME_UTC);
+		assert(timespec_result == TIME_UTC);
+		(void)timespec_result;
+	}
+
 	// Allocates sessions array for connections to be placed into
 	assert(atem_server.sessions == NULL);
 	atem_server.sessions = malloc(sizeof(*atem_server.sessions) * atem_server.sessions_size);
@@ -79,26 +99,96 @@ bool atem_server_init(void) {
 	return true;
 }
 
-// @todo
-void atem_server_recv(void) {
-	DEBUG_PRINTF("Receiving ATEM data\n");
+// Receive slots the server socket is drained into, reused for every batch
+static struct {
+	uint8_t bufs[ATEM_SERVER_RECV_BATCH][ATEM_PACKET_LEN_MAX];
+	struct sockaddr_in peer_addrs[ATEM_SERVER_RECV_BATCH];
+	union {
+		size_t align;
+		uint8_t buf[ATEM_LATENCY_CONTROL_LEN];
+	} controls[ATEM_SERVER_RECV_BATCH];
+	struct iovec iovs[ATEM_SERVER_RECV_BATCH];
+#ifdef __linux__
+	struct mmsghdr msgs[ATEM_SERVER_RECV_BATCH];
+#else // __linux__
+	struct msghdr msgs[ATEM_SERVER_RECV_BATCH];
+#endif // __linux__
+	// Length of datagram received into each slot
+	size_t lens[ATEM_SERVER_RECV_BATCH];
+} atem_server_recv_slots;
+
+// Gets message header for receive slot
+static struct msghdr* atem_server_recv_msg(int slot) {
+	assert(slot >= 0);
+	assert(slot < ATEM_SERVER_RECV_BATCH);
+#ifdef __linux__
+	return &atem_server_recv_slots.msgs[slot].msg_hdr;
+#else // __linux__
+	return &atem_server_recv_slots.msgs[slot];
+#endif // __linux__
+}
 
-	// Reads ATEM client packet from servers UDP socket
-	uint8_t buf[ATEM_PACKET_LEN_MAX];
-	struct sockaddr_in peer_addr;
-	socklen_t peer_addr_len = sizeof(peer_addr);
-	ssize_t recved = recvfrom(
-		atem_server.sock,
-		buf, ATEM_PACKET_LEN_MAX,
-		0,
-		(struct sockaddr*)&peer_addr, &peer_addr_len
-	);
-	assert(peer_addr_len == sizeof(peer_addr));
-	if (recved == -1) {
-		perror("Failed to read proxy data");
-		return;
+// Receives all queued datagrams fitting in receive slots without blocking and gets number of datagrams received
+static int atem_server_recv_batch(void) {
+	// Resets message headers updated when receiving previous batch
+	for (int slot = 0; slot < ATEM_SERVER_RECV_BATCH; slot++) {
+		struct msghdr* msg = atem_server_recv_msg(slot);
+		atem_server_recv_slots.iovs[slot].iov_base = atem_server_recv_slots.bufs[slot];
+		atem_server_recv_slots.iovs[slot].iov_len = sizeof(atem_server_recv_slots.bufs[slot]);
+		msg->msg_name = &atem_server_recv_slots.peer_addrs[slot];
+		msg->msg_namelen = sizeof(atem_server_recv_slots.peer_addrs[slot]);
+		msg->msg_iov = &atem_server_recv_slots.iovs[slot];
+		msg->msg_iovlen = 1;
+		msg->msg_control = atem_server_recv_slots.controls[slot].buf;
+		msg->msg_controllen = (atem_server.latency_interval > 0) ? sizeof(atem_server_recv_slots.controls[slot].buf) : 0;
+		msg->msg_flags = 0;
+	}
+
+#ifdef __linux__
+	// Receives all queued datagrams in a single system call
+	int count = recvmmsg(atem_server.sock, atem_server_recv_slots.msgs, ATEM_SERVER_RECV_BATCH, MSG_DONTWAIT, NULL);
+	if (count == -1) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			perror("Failed to read proxy data");
+		}
+		return 0;
+	}
+	for (int slot = 0; slot < count; slot++) {
+		atem_server_recv_slots.lens[slot] = atem_server_recv_slots.msgs[slot].msg_len;
+	}
+#else // __linux__
+	// Receives all queued datagrams one at a time where recvmmsg is not available
+	int count = 0;
+	while (count < ATEM_SERVER_RECV_BATCH) {
+		ssize_t recved = recvmsg(atem_server.sock, &atem_server_recv_slots.msgs[count], MSG_DONTWAIT);
+		if (recved == -1) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				perror("Failed to read proxy data");
+			}
+			break;
+		}
+		assert(recved >= 0);
+		atem_server_recv_slots.lens[count++] = (size_t)recved;
+	}
+#endif // __linux__
+
+	return count;
+}
+
+/**
+ * Processes ATEM client packet received on servers UDP socket
+ * @param msg Message header the packet was received with, only used for getting its kernel receive timestamp
+ */
+void atem_server_recv_datagram(uint8_t* buf, size_t recved, struct sockaddr_in* peer_addr, struct msghdr* msg) {
+	assert(buf != NULL);
+	assert(peer_addr != NULL);
+	assert(msg != NULL);
+
+	// Records received datagram if capturing traffic
+	if (atem_server.capture != NULL) {
+		atem_capture_write(atem_server.capture, ATEM_CAPTURE_DIR_RECV, peer_addr, buf, recved);
 	}
-	assert(recved >= 0);
+
 	if (recved > ATEM_PACKET_LEN_MAX) {
 		DEBUG_PRINTF("UDP packet was too big\n");
 		return;
@@ -112,6 +202,13 @@ void atem_server_recv(void) {
 	DEBUG_PRINTF("Received: ");
 	DEBUG_PRINT_BUF(buf, len);
 
+	// Records time from kernel receiving datagram until it is parsed
+	uint64_t parse_time = 0;
+	if (atem_server.latency_interval > 0) {
+		parse_time = atem_latency_now();
+		atem_latency_record(&atem_server.latency.recv_to_parse, atem_latency_recv_time(msg), parse_time);
+	}
+
 	// @todo
 	if (!(buf[ATEM_INDEX_SESSIONID_HIGH] & 0x80)) {
 		// @todo
@@ -129,7 +226,7 @@ void atem_server_recv(void) {
 			}
 
 			// @todo
-			atem_session_create(buf[ATEM_INDEX_SESSIONID_HIGH], buf[ATEM_INDEX_SESSIONID_LOW], &peer_addr);
+			atem_session_create(buf[ATEM_INDEX_SESSIONID_HIGH], buf[ATEM_INDEX_SESSIONID_LOW], peer_addr);
 		}
 		// @todo
 		else if (!(buf[ATEM_INDEX_FLAGS] & ATEM_FLAG_ACK)) {
@@ -137,7 +234,7 @@ void atem_server_recv(void) {
 		}
 		// @todo
 		else {
-			atem_session_connect(buf[ATEM_INDEX_SESSIONID_HIGH], buf[ATEM_INDEX_SESSIONID_LOW], &peer_addr);
+			atem_session_connect(buf[ATEM_INDEX_SESSIONID_HIGH], buf[ATEM_INDEX_SESSIONID_LOW], peer_addr);
 		}
 		return;
 	}
@@ -151,7 +248,7 @@ void atem_server_recv(void) {
 	}
 	struct atem_session* session = atem_session_get(session_index);
 	assert(atem_session_lookup_get(session->session_id) == session_index);
-	if (!atem_session_peer_validate(session, &peer_addr)) {
+	if (!atem_session_peer_validate(session, peer_addr)) {
 		return;
 	}
 	uint8_t flags = buf[ATEM_INDEX_FLAGS];
@@ -216,6 +313,11 @@ void atem_server_recv(void) {
 			};
 			atem_session_send(session, buf_ack);
 		}
+
+		// Records time from parsing request until its response was sent, deferred to send completion when only queued
+		if (atem_server.latency_interval > 0) {
+			atem_session_send_latency(parse_time);
+		}
 	}
 
 	// @todo
@@ -224,10 +326,38 @@ void atem_server_recv(void) {
 	}
 }
 
+/**
+ * Drains ATEM client packets from servers UDP socket and processes all of them before returning to dispatch timeouts
+ * @attention Stops after a limited number of full batches for timeouts to not be starved by a flood of packets
+ */
+void atem_server_recv(void) {
+	DEBUG_PRINTF("Receiving ATEM data\n");
+
+	for (int round = 0; round < ATEM_SERVER_RECV_ROUNDS; round++) {
+		int count = atem_server_recv_batch();
+		DEBUG_PRINTF("Received batch of %d datagrams\n", count);
+		for (int slot = 0; slot < count; slot++) {
+			struct msghdr* msg = atem_server_recv_msg(slot);
+			assert(msg->msg_namelen == sizeof(atem_server_recv_slots.peer_addrs[slot]));
+			atem_server_recv_datagram(
+				atem_server_recv_slots.bufs[slot], atem_server_recv_slots.lens[slot],
+				&atem_server_recv_slots.peer_addrs[slot], msg
+			);
+		}
+
+		// Socket is drained when it had less queued datagrams than there are receive slots
+		if (count < ATEM_SERVER_RECV_BATCH) {
+			break;
+		}
+	}
+}
+
 // Broadcasts ATEM buffer to all connected sessions
 void atem_server_broadcast(struct atem_packet* packet, uint8_t flags) {
 	assert(packet != NULL);
 
+	// Sends packet to all sessions with as few system calls as possible
+	atem_session_send_begin();
 	for (int16_t session_index = 0; session_index < atem_server.sessions_connected; session_index++) {
 		struct atem_session* session = atem_session_get(session_index);
 		assert(session != NULL);
@@ -235,10 +365,18 @@ void atem_server_broadcast(struct atem_packet* packet, uint8_t flags) {
 
 		atem_session_packet_push(session, packet, session_index);
 	}
+	atem_session_send_flush();
 
 	atem_packet_enqueue(packet, flags);
 }
 
+// Prints latency histograms for received packets
+void atem_server_latency_print(void) {
+	atem_latency_print(stdout, "Receive to parse", &atem_server.latency.recv_to_parse);
+	atem_latency_print(stdout, "Parse to send", &atem_server.latency.parse_to_send);
+	fflush(stdout);
+}
+
 
 
 // Flushes all sessions by starting closing handshake
@@ -5,13 +5,33 @@
 #include <stdint.h> // uint8_t, uint16_t, int16_t, UINT16_MAX
 #include <time.h> // struct timespec
 #include <stdbool.h> // bool
+#include <stdio.h> // FILE
+#include <stddef.h> // size_t
+
+#include <sys/socket.h> // struct msghdr
+#include <netinet/in.h> // struct sockaddr_in
 
 #include "./atem_packet.h" // struct atem_packet
 #include "./atem_session.h" // struct atem_session
+#include "../core/atem_latency.h" // struct atem_latency
 
 // How much to grow the sessions array by when it runs out of slots
 #define ATEM_SERVER_SESSIONS_MULTIPLIER (1.6f)
 
+// Number of receive slots the server socket is drained into with a single system call
+#define ATEM_SERVER_RECV_BATCH 32
+
+// Maximum number of full batches to receive before dispatching timeouts
+#define ATEM_SERVER_RECV_ROUNDS 4
+
+/**
+ * Runs proxy server event loop with io_uring on Linux instead of poll when set to 1
+ * @attention Has to be defined to the same value in all translation units since it controls what sources are built
+ */
+#ifndef ATEM_SERVER_IO_URING
+#define ATEM_SERVER_IO_URING (0)
+#endif // ATEM_SERVER_IO_URING
+
 // ATEM server containing information about sessions and in transit packets
 struct atem_server {
 	// Global packet queue for retransmits
@@ -39,6 +59,14 @@ struct atem_server {
 	struct timespec ping_timestamp;
 	// Indicates if the server has started closing
 	bool closing;
+	// Optional capture file recording all datagrams sent and received
+	FILE* capture;
+	// Configurable number of milliseconds between printing latency histograms, 0 disables latency tracking
+	uint16_t latency_interval;
+	// Timestamp from where next latency histogram print is calculated from
+	struct timespec latency_timestamp;
+	// Receive-to-parse and parse-to-send latency histograms for received packets
+	struct atem_latency latency;
 	// Lookup table for translating session id to sessions array index
 	int16_t session_lookup_table[UINT16_MAX + 1];
 };
@@ -47,7 +75,9 @@ extern struct atem_server atem_server;
 
 bool atem_server_init(void);
 void atem_server_recv(void);
+void atem_server_recv_datagram(uint8_t* buf, size_t recved, struct sockaddr_in* peer_addr, struct msghdr* msg);
 void atem_server_broadcast(struct atem_packet* packet, uint8_t flags);
+void atem_server_latency_print(void);
 
 void atem_server_flush(void);
 void atem_server_close(void);
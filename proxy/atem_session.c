@@ -1,46 +1,234 @@
-#include <stdint.h> // uint8_t, uint16_t, int16_t
+// Enables sendmmsg on Linux for sending batches of datagrams in a single system call
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif // __linux__ && !_GNU_SOURCE
+
+#include <stdint.h> // uint8_t, uint16_t, int16_t, uint64_t, uintptr_t
 #include <stddef.h> // NULL, size_t
 #include <assert.h> // assert
 #include <stdio.h> // perror
 #include <stdlib.h> // realloc, abort
 #include <stdbool.h> // bool, true, false
-#include <string.h> // memset
+#include <string.h> // memset, memcpy
 #include <time.h> // timespec_get, TIME_UTC
 
-#include <sys/socket.h> // AF_INET, sendto, struct sockaddr
+#include <sys/socket.h> // AF_INET, sendmsg, sendmmsg, struct msghdr, struct mmsghdr
+#include <sys/uio.h> // struct iovec
 #include <netinet/in.h> // struct sockaddr_in
 #include <arpa/inet.h> // ntohs
 #include <unistd.h> // ssize_t
 
 #include "../core/atem_protocol.h" // ATEM_LEN_HEADER, ATEM_INDEX_LEN_HIGH, ATEM_INDEX_LEN_LOW,ATEM_INDEX_SESSIONID_HIGH, ATEM_INDEX_SESSIONID_LOW, ATEM_INDEX_FLAGS, ATEM_FLAG_RETX, ATEM_FLAG_SYN, ATEM_LEN_SYN, ATEM_INDEX_OPCODE, ATEM_OPCODE_REJECT, ATEM_OPCODE_ACCEPT, ATEM_INDEX_NEWSESSIONID_HIGH, ATEM_INDEX_NEWSESSIONID_LOW, ATEM_OPCODE_CLOSED
 #include "../core/atem.h" // ATEM_PACKET_LEN_MAX
+#include "../core/atem_capture.h" // atem_capture_write, ATEM_CAPTURE_DIR_SEND
+#include "../core/atem_latency.h" // atem_latency_record, atem_latency_now
 #include "./atem_debug.h" // DEBUG_PRINTF, DEBUG_PRINT_BUF
-#include "./atem_server.h" // atem_server, atem_server_release, ATEM_SERVER_SESSIONS_MULTIPLIER
-#include "./atem_packet.h" // struct atem_packet, struct atem_packet_session, atem_packet_create, atem_packet_enqueue, atem_packet_release, atem_packet_session_update, atem_packet_disassociate, atem_packet_flush, ATEM_PACKET_FLAG_CLOSING, ATEM_PACKET_FLAG_NONE
+#include "./atem_server.h" // atem_server, atem_server_release, ATEM_SERVER_SESSIONS_MULTIPLIER, ATEM_SERVER_IO_URING
+#include "./atem_packet.h" // struct atem_packet, struct atem_packet_session, atem_packet_create, atem_packet_send, atem_packet_enqueue, atem_packet_release, atem_packet_session_update, atem_packet_disassociate, atem_packet_flush, ATEM_PACKET_FLAG_CLOSING, ATEM_PACKET_FLAG_NONE
 #include "./atem_cache.h" // atem_cache_dump
-#include "./atem_session.h" // struct atem_session
+#include "./atem_session.h" // struct atem_session, atem_session_send_header, ATEM_SESSION_SEND_BATCH
+#if ATEM_SERVER_IO_URING
+#include "./atem_uring.h" // atem_uring_active, atem_uring_send, atem_uring_send_latency, atem_uring_submit
+#endif // ATEM_SERVER_IO_URING
+
+
+
+// Datagrams queued between atem_session_send_begin and atem_session_send_flush to be sent with a single system call
+static struct {
+	// Copy of each datagrams header since it is built per session outside the shared packet buffer
+	uint8_t headers[ATEM_SESSION_SEND_BATCH][ATEM_LEN_HEADER];
+	// Header copy followed by payload in shared packet buffer
+	struct iovec iovs[ATEM_SESSION_SEND_BATCH][2];
+	struct sockaddr_in peer_addrs[ATEM_SESSION_SEND_BATCH];
+	// Number of queued datagrams
+	uint16_t len;
+	// Indicates if datagrams are queued instead of sent right away
+	bool active;
+} atem_send_batch;
+
+// Gets iovec base for buffer only read when sending, struct iovec is shared with receiving so its base is not const
+static inline void* atem_send_iov_base(const uint8_t* buf) {
+	return (void*)(uintptr_t)buf;
+}
 
+// Records sent datagram if capturing traffic, reassembling header and payload into a single buffer
+static void atem_send_capture(const uint8_t* header, const uint8_t* payload, size_t payload_len, struct sockaddr_in* peer_addr) {
+	if (atem_server.capture == NULL) {
+		return;
+	}
+	uint8_t buf[ATEM_PACKET_LEN_MAX];
+	assert(ATEM_LEN_HEADER + payload_len <= sizeof(buf));
+	memcpy(buf, header, ATEM_LEN_HEADER);
+	memcpy(buf + ATEM_LEN_HEADER, payload, payload_len);
+	atem_capture_write(atem_server.capture, ATEM_CAPTURE_DIR_SEND, peer_addr, buf, ATEM_LEN_HEADER + payload_len);
+}
 
+// Sends all queued datagrams in batch
+static void atem_send_batch_flush(void) {
+	assert(atem_send_batch.len <= ATEM_SESSION_SEND_BATCH);
+	if (atem_send_batch.len == 0) {
+		return;
+	}
 
-// Sends an ATEM packet buffer to a specified client address
-static void atem_send(uint8_t* buf, struct sockaddr_in* peer_addr) {
+	DEBUG_PRINTF("Sending batch of %d datagrams\n", atem_send_batch.len);
+
+#ifdef __linux__
+	// Sends all datagrams in a single system call, skipping datagrams failing to send
+	struct mmsghdr msgs[ATEM_SESSION_SEND_BATCH];
+	memset(msgs, 0, sizeof(*msgs) * atem_send_batch.len);
+	for (uint16_t i = 0; i < atem_send_batch.len; i++) {
+		msgs[i].msg_hdr.msg_name = &atem_send_batch.peer_addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(atem_send_batch.peer_addrs[i]);
+		msgs[i].msg_hdr.msg_iov = atem_send_batch.iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 2;
+	}
+	uint16_t index = 0;
+	while (index < atem_send_batch.len) {
+		int sent = sendmmsg(atem_server.sock, &msgs[index], (unsigned int)(atem_send_batch.len - index), 0);
+		if (sent == -1) {
+			perror("Failed to send data to ATEM proxy client");
+			msgs[index].msg_len = 0;
+			index++;
+			continue;
+		}
+		assert(sent > 0);
+		index += sent;
+	}
+#else // __linux__
+	// Sends datagrams one at a time where sendmmsg is not available
+	for (uint16_t i = 0; i < atem_send_batch.len; i++) {
+		struct msghdr msg = {
+			.msg_name = &atem_send_batch.peer_addrs[i],
+			.msg_namelen = sizeof(atem_send_batch.peer_addrs[i]),
+			.msg_iov = atem_send_batch.iovs[i],
+			.msg_iovlen = 2
+		};
+		if (sendmsg(atem_server.sock, &msg, 0) == -1) {
+			perror("Failed to send data to ATEM proxy client");
+		}
+	}
+#endif // __linux__
+
+	// Records sent datagrams if capturing traffic
+	if (atem_server.capture != NULL) {
+		for (uint16_t i = 0; i < atem_send_batch.len; i++) {
+#ifdef __linux__
+			if (msgs[i].msg_len == 0) continue;
+#endif // __linux__
+			atem_send_capture(
+				atem_send_batch.headers[i],
+				atem_send_batch.iovs[i][1].iov_base, atem_send_batch.iovs[i][1].iov_len,
+				&atem_send_batch.peer_addrs[i]
+			);
+		}
+	}
+
+	atem_send_batch.len = 0;
+}
+
+/**
+ * Sends an ATEM packet header followed by the payload of a packet buffer to a specified client address
+ * @attention Header and buffer can be the same when sending a buffer not shared between sessions
+ */
+static void atem_send(const uint8_t* header, const uint8_t* buf, struct sockaddr_in* peer_addr) {
+	assert(header != NULL);
 	assert(buf != NULL);
 	assert(peer_addr != NULL);
 	assert(peer_addr->sin_family == AF_INET);
 
-	uint16_t len = (buf[ATEM_INDEX_LEN_HIGH] << 8 | buf[ATEM_INDEX_LEN_LOW]) & ATEM_PACKET_LEN_MAX;
+	uint16_t len = (header[ATEM_INDEX_LEN_HIGH] << 8 | header[ATEM_INDEX_LEN_LOW]) & ATEM_PACKET_LEN_MAX;
 	assert(len >= ATEM_LEN_HEADER);
 	assert(len <= ATEM_PACKET_LEN_MAX);
+	assert(len == ((buf[ATEM_INDEX_LEN_HIGH] << 8 | buf[ATEM_INDEX_LEN_LOW]) & ATEM_PACKET_LEN_MAX));
+	const uint8_t* payload = buf + ATEM_LEN_HEADER;
+	size_t payload_len = (size_t)(len - ATEM_LEN_HEADER);
 
 	DEBUG_PRINTF("Sending: ");
-	DEBUG_PRINT_BUF(buf, len);
+	DEBUG_PRINT_BUF(header, ATEM_LEN_HEADER);
+	if (payload_len > 0) {
+		DEBUG_PRINTF("\t");
+		DEBUG_PRINT_BUF(payload, (uint16_t)payload_len);
+	}
 
-	ssize_t sent = sendto(atem_server.sock, buf, (size_t)len, 0, (struct sockaddr*)peer_addr, sizeof(*peer_addr));
+#if ATEM_SERVER_IO_URING
+	// Queues datagram for io_uring to send together with all other datagrams queued before it is submitted, captured when send completes
+	if (atem_uring_active()) {
+		atem_uring_send(header, payload, payload_len, peer_addr);
+		return;
+	}
+#endif // ATEM_SERVER_IO_URING
+
+	// Queues datagram in batch, copying header since it only lives until the caller returns
+	if (atem_send_batch.active) {
+		if (atem_send_batch.len == ATEM_SESSION_SEND_BATCH) {
+			atem_send_batch_flush();
+		}
+		uint16_t index = atem_send_batch.len++;
+		memcpy(atem_send_batch.headers[index], header, ATEM_LEN_HEADER);
+		atem_send_batch.iovs[index][0].iov_base = atem_send_batch.headers[index];
+		atem_send_batch.iovs[index][0].iov_len = ATEM_LEN_HEADER;
+		atem_send_batch.iovs[index][1].iov_base = atem_send_iov_base(payload);
+		atem_send_batch.iovs[index][1].iov_len = payload_len;
+		atem_send_batch.peer_addrs[index] = *peer_addr;
+		return;
+	}
+
+	// Sends header and payload as a single datagram without copying them together
+	struct iovec iovs[2] = {
+		{ .iov_base = atem_send_iov_base(header), .iov_len = ATEM_LEN_HEADER },
+		{ .iov_base = atem_send_iov_base(payload), .iov_len = payload_len }
+	};
+	struct msghdr msg = {
+		.msg_name = peer_addr,
+		.msg_namelen = sizeof(*peer_addr),
+		.msg_iov = iovs,
+		.msg_iovlen = 2
+	};
+	ssize_t sent = sendmsg(atem_server.sock, &msg, 0);
 	if (sent == -1) {
 		perror("Failed to send data to ATEM proxy client");
 		return;
 	}
 	assert(sent == len);
+
+	// Records sent datagram if capturing traffic
+	atem_send_capture(header, payload, payload_len, peer_addr);
+}
+
+/**
+ * Queues datagrams sent to sessions until atem_session_send_flush is called to send them in a single system call
+ * @attention Buffers sent while queueing have to stay valid until flushed, so only packet buffers can be sent
+ */
+void atem_session_send_begin(void) {
+	assert(atem_send_batch.active == false);
+	assert(atem_send_batch.len == 0);
+	atem_send_batch.active = true;
+}
+
+// Sends all datagrams queued since atem_session_send_begin and stops queueing
+void atem_session_send_flush(void) {
+	assert(atem_send_batch.active == true);
+	atem_send_batch_flush();
+	atem_send_batch.active = false;
+#if ATEM_SERVER_IO_URING
+	if (atem_uring_active()) {
+		atem_uring_submit();
+	}
+#endif // ATEM_SERVER_IO_URING
+}
+
+// Records time from parsing a request until the last datagram sent in response to it was sent
+void atem_session_send_latency(uint64_t parse_time) {
+	assert(atem_server.latency_interval > 0);
+	assert(atem_send_batch.active == false);
+#if ATEM_SERVER_IO_URING
+	// Defers recording until io_uring has sent the datagram since it is only queued
+	if (atem_uring_active()) {
+		atem_uring_send_latency(parse_time);
+		return;
+	}
+#endif // ATEM_SERVER_IO_URING
+	atem_latency_record(&atem_server.latency.parse_to_send, parse_time, atem_latency_now());
 }
 
 // Sets session index for specified session id in lookup table
@@ -180,14 +368,23 @@ bool atem_session_peer_validate(struct atem_session* session, struct sockaddr_in
 	return true;
 }
 
-// Sends ATEM packet to session
-void atem_session_send(struct atem_session* session, uint8_t* buf) {
+// Sends ATEM packet to session with header built outside the buffer
+void atem_session_send(struct atem_session* session, const uint8_t* buf) {
+	assert(buf != NULL);
+	uint8_t header[ATEM_LEN_HEADER];
+	memcpy(header, buf, ATEM_LEN_HEADER);
+	atem_session_send_header(session, header, buf);
+}
+
+// Sends ATEM packet to session with session id set in header sent in place of the buffers header
+void atem_session_send_header(struct atem_session* session, uint8_t* header, const uint8_t* buf) {
 	assert(session != NULL);
+	assert(header != NULL);
 	assert(buf != NULL);
 
-	buf[ATEM_INDEX_SESSIONID_HIGH] = session->session_id_high;
-	buf[ATEM_INDEX_SESSIONID_LOW] = session->session_id_low;
-	atem_send(buf, &session->peer_addr);
+	header[ATEM_INDEX_SESSIONID_HIGH] = session->session_id_high;
+	header[ATEM_INDEX_SESSIONID_LOW] = session->session_id_low;
+	atem_send(header, buf, &session->peer_addr);
 }
 
 
@@ -219,8 +416,7 @@ void atem_session_create(uint8_t session_id_high, uint8_t session_id_low, struct
 		assert(packet->sessions[0].packet_session_index == 0);
 		assert(packet->sessions[0].remote_id_high == 0);
 		assert(packet->sessions[0].remote_id_low == 0);
-		packet->buf[ATEM_INDEX_FLAGS] |= ATEM_FLAG_RETX;
-		atem_session_send(session, packet->buf);
+		atem_packet_send(packet, &packet->sessions[0], ATEM_FLAG_RETX);
 		return;
 	}
 
@@ -234,7 +430,7 @@ void atem_session_create(uint8_t session_id_high, uint8_t session_id_low, struct
 			[ATEM_INDEX_SESSIONID_LOW] = session_id_low,
 			[ATEM_INDEX_OPCODE] = ATEM_OPCODE_REJECT
 		};
-		atem_send(response_reject, peer_addr);
+		atem_send(response_reject, response_reject, peer_addr);
 		return;
 	}
 
@@ -287,14 +483,15 @@ void atem_session_create(uint8_t session_id_high, uint8_t session_id_low, struct
 	);
 
 	// Sends accept response
-	struct atem_packet* packet = atem_packet_create(1, ATEM_LEN_SYN);
+	uint8_t* buf;
+	struct atem_packet* packet = atem_packet_create(1, ATEM_LEN_SYN, &buf);
 	assert(packet != NULL);
-	memset(packet->buf, 0, ATEM_LEN_SYN);
-	packet->buf[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN;
-	packet->buf[ATEM_INDEX_LEN_LOW] = ATEM_LEN_SYN;
-	packet->buf[ATEM_INDEX_OPCODE] = ATEM_OPCODE_ACCEPT;
-	packet->buf[ATEM_INDEX_NEWSESSIONID_HIGH] = atem_server.session_id_last >> 8;
-	packet->buf[ATEM_INDEX_NEWSESSIONID_LOW] = atem_server.session_id_last & 0xff;
+	memset(buf, 0, ATEM_LEN_SYN);
+	buf[ATEM_INDEX_FLAGS] = ATEM_FLAG_SYN;
+	buf[ATEM_INDEX_LEN_LOW] = ATEM_LEN_SYN;
+	buf[ATEM_INDEX_OPCODE] = ATEM_OPCODE_ACCEPT;
+	buf[ATEM_INDEX_NEWSESSIONID_HIGH] = atem_server.session_id_last >> 8;
+	buf[ATEM_INDEX_NEWSESSIONID_LOW] = atem_server.session_id_last & 0xff;
 	atem_session_send(session, packet->buf);
 
 	// Pushes packet to retransmit queue
@@ -470,7 +667,7 @@ void atem_session_closing(int16_t session_index) {
 		[ATEM_INDEX_SESSIONID_LOW] = session->session_id & 0xff,
 		[ATEM_INDEX_OPCODE] = ATEM_OPCODE_CLOSED
 	};
-	atem_send(buf_closed, &session->peer_addr);
+	atem_send(buf_closed, buf_closed, &session->peer_addr);
 
 	// Closes session that is in the middle of an opening or closing handshake
 	if (!atem_session_connected(session_index)) {
@@ -608,7 +805,7 @@ void atem_session_packet_push(struct atem_session* session, struct atem_packet*
 	packet_session->remote_id_low = session->remote_id & 0xff;
 
 	// Sends packet to client
-	atem_packet_send(packet, packet_session);
+	atem_packet_send(packet, packet_session, 0);
 
 	// Enqueues packet at beginning of sessions packet queue if empty
 	if (session->packet_head == NULL) {
@@ -2,13 +2,16 @@
 #ifndef ATEM_SESSION_H
 #define ATEM_SESSION_H
 
-#include <stdint.h> // uint8_t, uint16_t, int16_t
+#include <stdint.h> // uint8_t, uint16_t, int16_t, uint64_t
 #include <stdbool.h> // bool
 
 #include <netinet/in.h> // struct sockaddr_in
 
 #include "./atem_packet.h" // struct atem_packet
 
+// Maximum number of datagrams sent in a single system call between atem_session_send_begin and atem_session_send_flush
+#define ATEM_SESSION_SEND_BATCH 64
+
 // ATEM session containing information about the client connection
 struct atem_session {
 	// Sessions local packet queue
@@ -33,7 +36,11 @@ int16_t atem_session_lookup_get(uint16_t session_id);
 void atem_session_lookup_clear(uint16_t session_id);
 struct atem_session* atem_session_get(int16_t session_index);
 bool atem_session_peer_validate(struct atem_session* session, struct sockaddr_in* peer_addr);
-void atem_session_send(struct atem_session* session, uint8_t* buf);
+void atem_session_send(struct atem_session* session, const uint8_t* buf);
+void atem_session_send_header(struct atem_session* session, uint8_t* header, const uint8_t* buf);
+void atem_session_send_begin(void);
+void atem_session_send_flush(void);
+void atem_session_send_latency(uint64_t parse_time);
 
 void atem_session_create(uint8_t session_id_high, uint8_t session_id_low, struct sockaddr_in* peer_addr);
 void atem_session_connect(uint8_t session_id_high, uint8_t session_id_low, struct sockaddr_in* peer_addr);
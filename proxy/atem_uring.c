@@ -0,0 +1,546 @@
+// Enables syscall and mmap flags used for setting up io_uring without liburing
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif // _GNU_SOURCE
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, int32_t, uint64_t, uintptr_t
+#include <stddef.h> // size_t, NULL
+#include <stdbool.h> // bool, true, false
+#include <stdatomic.h> // atomic_load_explicit, atomic_store_explicit, memory_order_acquire, memory_order_release
+#include <string.h> // memset, memcpy, strerror
+#include <stdio.h> // perror, fprintf, stderr
+#include <assert.h> // assert
+#include <errno.h> // errno, ENOSYS, ENOBUFS, ETIME, EINTR, EINVAL
+
+#include <sys/socket.h> // struct msghdr, MSG_TRUNC
+#include <sys/uio.h> // struct iovec
+#include <sys/mman.h> // mmap, munmap, PROT_READ, PROT_WRITE, MAP_SHARED, MAP_PRIVATE, MAP_ANONYMOUS, MAP_POPULATE, MAP_FAILED
+#include <sys/syscall.h> // __NR_io_uring_setup, __NR_io_uring_enter, __NR_io_uring_register
+#include <netinet/in.h> // struct sockaddr_in
+#include <unistd.h> // syscall, close
+
+#include <linux/io_uring.h> // struct io_uring_params, struct io_uring_sqe, struct io_uring_cqe, struct io_uring_buf, struct io_uring_buf_reg, struct io_uring_recvmsg_out, struct io_uring_getevents_arg, IORING_*, IOSQE_BUFFER_SELECT
+
+#include "../core/atem.h" // ATEM_PACKET_LEN_MAX
+#include "../core/atem_protocol.h" // ATEM_LEN_HEADER
+#include "../core/atem_latency.h" // ATEM_LATENCY_CONTROL_LEN, atem_latency_record, atem_latency_now
+#include "../core/atem_capture.h" // atem_capture_write, ATEM_CAPTURE_DIR_SEND
+#include "./atem_debug.h" // DEBUG_PRINTF
+#include "./atem_server.h" // atem_server, atem_server_recv_datagram
+#include "./atem_uring.h" // ATEM_URING_SEND_SLOTS, ATEM_URING_RECV_BUFS
+
+// Buffer group id for buffers provided for multishot receives
+#define ATEM_URING_RECV_GROUP 0
+
+// Number of submission queue entries for the receive ring, only used for posting the multishot receive
+#define ATEM_URING_RECV_ENTRIES 4
+
+// Length of each receive buffer, holding the received message header, peer address, control messages and datagram
+#define ATEM_URING_RECV_BUF_LEN (sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in) + ATEM_LATENCY_CONTROL_LEN + ATEM_PACKET_LEN_MAX)
+
+// Submission and completion queues shared with the kernel for an io_uring instance
+struct atem_uring_ring {
+	int fd;
+	// Mappings of the queue rings and submission queue entries
+	void* rings;
+	size_t rings_len;
+	struct io_uring_sqe* sqes;
+	size_t sqes_len;
+	// Submission queue indexes, tail is only written by the application
+	uint32_t* sq_head;
+	uint32_t* sq_tail;
+	uint32_t* sq_array;
+	uint32_t sq_mask;
+	// Completion queue indexes, head is only written by the application
+	uint32_t* cq_head;
+	uint32_t* cq_tail;
+	struct io_uring_cqe* cqes;
+	uint32_t cq_mask;
+};
+
+// Datagram copied for io_uring to send, since buffers sent from can be reused before the kernel has read them
+struct atem_uring_send_slot {
+	struct msghdr msg;
+	struct iovec iov;
+	struct sockaddr_in peer_addr;
+	// Time the request this datagram responds to was parsed, 0 if parse to send latency is not measured for it
+	uint64_t parse_time;
+	uint8_t buf[ATEM_PACKET_LEN_MAX];
+};
+
+// State for io_uring backend with separate rings for receives and sends to never reap receives while sending
+static struct {
+	// Ring with multishot receive posted on server socket
+	struct atem_uring_ring recv;
+	// Ring for sending datagrams to sessions
+	struct atem_uring_ring send;
+	// Message header describing the peer address and control message lengths for multishot receive
+	struct msghdr recv_msg;
+	// Buffer ring the kernel picks receive buffers from, with tail stored in the first buffers reserved field
+	struct io_uring_buf* recv_ring;
+	size_t recv_ring_len;
+	uint16_t recv_ring_tail;
+	// Indicates if multishot receive is posted and has not been terminated
+	bool recv_armed;
+	// Indicates if io_uring is used for sending and receiving datagrams
+	bool active;
+	// Stack of send slots not queued or in flight
+	uint16_t send_slots_free[ATEM_URING_SEND_SLOTS];
+	uint16_t send_slots_free_len;
+	// Send slot of the last datagram queued
+	uint16_t send_slot_last;
+	struct atem_uring_send_slot send_slots[ATEM_URING_SEND_SLOTS];
+	uint8_t recv_bufs[ATEM_URING_RECV_BUFS][ATEM_URING_RECV_BUF_LEN];
+} atem_uring;
+
+
+
+// Loads index written by the kernel, ordered before reading the entries it guards
+static inline uint32_t atem_uring_load_acquire(uint32_t* index) {
+	return atomic_load_explicit((_Atomic uint32_t*)index, memory_order_acquire);
+}
+
+// Stores index read by the kernel, ordered after writing the entries it guards
+static inline void atem_uring_store_release(uint32_t* index, uint32_t value) {
+	atomic_store_explicit((_Atomic uint32_t*)index, value, memory_order_release);
+}
+
+// Unmaps queues and closes io_uring instance
+static void atem_uring_ring_release(struct atem_uring_ring* ring) {
+	if (ring->sqes != NULL) {
+		munmap(ring->sqes, ring->sqes_len);
+	}
+	if (ring->rings != NULL) {
+		munmap(ring->rings, ring->rings_len);
+	}
+	close(ring->fd);
+	memset(ring, 0, sizeof(*ring));
+}
+
+/**
+ * Sets up io_uring instance and maps its queues
+ * @return Indicates if setting up the ring was successful or not and sets `errno` with nothing left to release on failure
+ */
+static bool atem_uring_ring_init(struct atem_uring_ring* ring, unsigned int entries) {
+	assert(ring != NULL);
+	memset(ring, 0, sizeof(*ring));
+
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	long fd = syscall(__NR_io_uring_setup, entries, &params);
+	if (fd == -1) {
+		return false;
+	}
+	ring->fd = (int)fd;
+
+	// Requires kernel to map submission and completion queue rings together
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+		atem_uring_ring_release(ring);
+		errno = ENOSYS;
+		return false;
+	}
+
+	// Maps submission and completion queue rings
+	size_t sq_len = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	size_t cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->rings_len = (sq_len > cq_len) ? sq_len : cq_len;
+	ring->rings = mmap(NULL, ring->rings_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->rings == MAP_FAILED) {
+		int err = errno;
+		ring->rings = NULL;
+		atem_uring_ring_release(ring);
+		errno = err;
+		return false;
+	}
+
+	// Maps submission queue entries
+	ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+	void* sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED) {
+		int err = errno;
+		atem_uring_ring_release(ring);
+		errno = err;
+		return false;
+	}
+	ring->sqes = sqes;
+
+	// Gets pointers to queue indexes from their offsets in the mapped rings
+	uint8_t* rings = ring->rings;
+	void* sq_mask = rings + params.sq_off.ring_mask;
+	void* cq_mask = rings + params.cq_off.ring_mask;
+	ring->sq_head = (void*)(rings + params.sq_off.head);
+	ring->sq_tail = (void*)(rings + params.sq_off.tail);
+	ring->sq_array = (void*)(rings + params.sq_off.array);
+	ring->sq_mask = *(uint32_t*)sq_mask;
+	ring->cq_head = (void*)(rings + params.cq_off.head);
+	ring->cq_tail = (void*)(rings + params.cq_off.tail);
+	ring->cqes = (void*)(rings + params.cq_off.cqes);
+	ring->cq_mask = *(uint32_t*)cq_mask;
+
+	return true;
+}
+
+// Gets number of submission queue entries queued but not yet consumed by the kernel
+static uint32_t atem_uring_sq_pending(struct atem_uring_ring* ring) {
+	return *ring->sq_tail - atem_uring_load_acquire(ring->sq_head);
+}
+
+/**
+ * Submits all queued submission queue entries and waits for completions
+ * @param wait Number of completions to wait for, 0 to only submit
+ * @param timeout Milliseconds to wait at most for completions or -1 to wait without timeout
+ * @return Number of entries submitted or -1 on error with errno set, ETIME if timeout expired
+ */
+static int atem_uring_enter(struct atem_uring_ring* ring, unsigned int wait, int timeout) {
+	unsigned int flags = (wait > 0) ? IORING_ENTER_GETEVENTS : 0;
+	struct __kernel_timespec ts;
+	struct io_uring_getevents_arg arg;
+	void* arg_ptr = NULL;
+	size_t arg_len = 0;
+	if (wait > 0 && timeout >= 0) {
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (timeout % 1000) * 1000000;
+		memset(&arg, 0, sizeof(arg));
+		arg.ts = (uint64_t)(uintptr_t)&ts;
+		arg_ptr = &arg;
+		arg_len = sizeof(arg);
+		flags |= IORING_ENTER_EXT_ARG;
+	}
+	return (int)syscall(__NR_io_uring_enter, ring->fd, atem_uring_sq_pending(ring), wait, flags, arg_ptr, arg_len);
+}
+
+// Gets submission queue entry at tail, submitting already queued entries if submission queue is full
+static struct io_uring_sqe* atem_uring_sqe_get(struct atem_uring_ring* ring) {
+	if (atem_uring_sq_pending(ring) > ring->sq_mask) {
+		if (atem_uring_enter(ring, 0, -1) == -1) {
+			perror("Failed to submit io_uring entries");
+		}
+	}
+	assert(atem_uring_sq_pending(ring) <= ring->sq_mask);
+
+	uint32_t index = *ring->sq_tail & ring->sq_mask;
+	struct io_uring_sqe* sqe = &ring->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	ring->sq_array[index] = index;
+	return sqe;
+}
+
+// Queues submission queue entry from atem_uring_sqe_get to be submitted on next enter
+static void atem_uring_sqe_queue(struct atem_uring_ring* ring) {
+	atem_uring_store_release(ring->sq_tail, *ring->sq_tail + 1);
+}
+
+// Gets next completion queue entry or NULL if there are none
+static struct io_uring_cqe* atem_uring_cqe_peek(struct atem_uring_ring* ring) {
+	uint32_t head = *ring->cq_head;
+	if (head == atem_uring_load_acquire(ring->cq_tail)) {
+		return NULL;
+	}
+	return &ring->cqes[head & ring->cq_mask];
+}
+
+// Releases completion queue entry from atem_uring_cqe_peek back to the kernel
+static void atem_uring_cqe_seen(struct atem_uring_ring* ring) {
+	atem_uring_store_release(ring->cq_head, *ring->cq_head + 1);
+}
+
+
+
+// Provides receive buffer to the kernel for datagrams to be received into
+static void atem_uring_recv_provide(uint16_t buf_id) {
+	assert(buf_id < ATEM_URING_RECV_BUFS);
+	struct io_uring_buf* buf = &atem_uring.recv_ring[atem_uring.recv_ring_tail & (ATEM_URING_RECV_BUFS - 1)];
+	buf->addr = (uint64_t)(uintptr_t)atem_uring.recv_bufs[buf_id];
+	buf->len = sizeof(atem_uring.recv_bufs[buf_id]);
+	buf->bid = buf_id;
+	atem_uring.recv_ring_tail++;
+	atomic_store_explicit((_Atomic uint16_t*)&atem_uring.recv_ring[0].resv, atem_uring.recv_ring_tail, memory_order_release);
+}
+
+// Posts multishot receive on server socket, staying active for all datagrams until buffers run out
+static void atem_uring_recv_arm(void) {
+	assert(!atem_uring.recv_armed);
+	struct io_uring_sqe* sqe = atem_uring_sqe_get(&atem_uring.recv);
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = atem_server.sock;
+	sqe->addr = (uint64_t)(uintptr_t)&atem_uring.recv_msg;
+	sqe->len = 1;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = ATEM_URING_RECV_GROUP;
+	atem_uring_sqe_queue(&atem_uring.recv);
+	atem_uring.recv_armed = true;
+}
+
+// Processes datagram received by multishot receive into provided buffer
+static void atem_uring_recv_process(uint16_t buf_id, size_t len) {
+	assert(buf_id < ATEM_URING_RECV_BUFS);
+	uint8_t* buf = atem_uring.recv_bufs[buf_id];
+
+	// Gets peer address, control messages and datagram laid out after the received message header
+	struct io_uring_recvmsg_out out;
+	size_t offset_payload = sizeof(out) + atem_uring.recv_msg.msg_namelen + atem_uring.recv_msg.msg_controllen;
+	assert(len >= offset_payload);
+	memcpy(&out, buf, sizeof(out));
+	if (out.namelen != sizeof(struct sockaddr_in)) {
+		DEBUG_PRINTF("Received datagram from unexpected address type\n");
+		return;
+	}
+	struct sockaddr_in peer_addr;
+	memcpy(&peer_addr, buf + sizeof(out), sizeof(peer_addr));
+	struct msghdr msg = {
+		.msg_control = buf + sizeof(out) + atem_uring.recv_msg.msg_namelen,
+		.msg_controllen = out.controllen
+	};
+
+	// Reports truncated datagrams with their full length for them to be rejected as too big
+	size_t recved = len - offset_payload;
+	if (out.flags & MSG_TRUNC) {
+		recved = out.payloadlen;
+	}
+	atem_server_recv_datagram(buf + offset_payload, recved, &peer_addr, &msg);
+}
+
+
+
+// Reaps completed sends and releases their send slots, waiting for at least specified number of completions
+static void atem_uring_send_reap(unsigned int wait) {
+	if (wait > 0 && atem_uring_enter(&atem_uring.send, wait, -1) == -1 && errno != EINTR) {
+		perror("Failed to wait for io_uring sends");
+	}
+
+	struct io_uring_cqe* cqe;
+	while ((cqe = atem_uring_cqe_peek(&atem_uring.send)) != NULL) {
+		uint16_t slot = (uint16_t)cqe->user_data;
+		int32_t res = cqe->res;
+		atem_uring_cqe_seen(&atem_uring.send);
+		assert(slot < ATEM_URING_SEND_SLOTS);
+		assert(atem_uring.send_slots_free_len < ATEM_URING_SEND_SLOTS);
+		struct atem_uring_send_slot* send_slot = &atem_uring.send_slots[slot];
+		if (res < 0) {
+			fprintf(stderr, "Failed to send data to ATEM proxy client: %s\n", strerror(-res));
+		}
+		else {
+			// Records time from parsing request until its response was sent, only after the kernel has sent it
+			if (send_slot->parse_time != 0) {
+				atem_latency_record(&atem_server.latency.parse_to_send, send_slot->parse_time, atem_latency_now());
+			}
+
+			// Records sent datagram if capturing traffic, only after the kernel has sent it
+			if (atem_server.capture != NULL) {
+				atem_capture_write(atem_server.capture, ATEM_CAPTURE_DIR_SEND, &send_slot->peer_addr, send_slot->buf, send_slot->iov.iov_len);
+			}
+		}
+		atem_uring.send_slots_free[atem_uring.send_slots_free_len++] = slot;
+	}
+}
+
+// Waits for all in flight sends and releases io_uring, leaving datagrams to be sent and received without it
+static void atem_uring_release(void) {
+	assert(atem_uring.active);
+	if (atem_uring_sq_pending(&atem_uring.send) > 0 && atem_uring_enter(&atem_uring.send, 0, -1) == -1) {
+		perror("Failed to submit datagrams to io_uring");
+	}
+	atem_uring_send_reap(0);
+	while (atem_uring.send_slots_free_len < ATEM_URING_SEND_SLOTS) {
+		atem_uring_send_reap(1);
+	}
+
+	munmap(atem_uring.recv_ring, atem_uring.recv_ring_len);
+	atem_uring.recv_ring = NULL;
+	atem_uring_ring_release(&atem_uring.send);
+	atem_uring_ring_release(&atem_uring.recv);
+	atem_uring.recv_armed = false;
+	atem_uring.active = false;
+}
+
+/**
+ * Sets up io_uring rings for server socket and posts multishot receive on it
+ * @public
+ * @attention Has to be called after atem_server_init
+ * @return Indicates if setup was successful or not and sets `errno` with nothing left to release on failure
+ */
+bool atem_uring_init(void) {
+	assert(!atem_uring.active);
+
+	// Sets up rings for receiving and sending
+	if (!atem_uring_ring_init(&atem_uring.recv, ATEM_URING_RECV_ENTRIES)) {
+		return false;
+	}
+	if (!atem_uring_ring_init(&atem_uring.send, ATEM_URING_SEND_SLOTS)) {
+		int err = errno;
+		atem_uring_ring_release(&atem_uring.recv);
+		errno = err;
+		return false;
+	}
+
+	// Registers buffer ring for multishot receives to pick buffers from
+	size_t recv_ring_len = sizeof(*atem_uring.recv_ring) * ATEM_URING_RECV_BUFS;
+	void* recv_ring = mmap(NULL, recv_ring_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (recv_ring == MAP_FAILED) {
+		int err = errno;
+		atem_uring_ring_release(&atem_uring.send);
+		atem_uring_ring_release(&atem_uring.recv);
+		errno = err;
+		return false;
+	}
+	atem_uring.recv_ring = recv_ring;
+	atem_uring.recv_ring_len = recv_ring_len;
+	atem_uring.recv_ring_tail = 0;
+	struct io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uint64_t)(uintptr_t)recv_ring;
+	reg.ring_entries = ATEM_URING_RECV_BUFS;
+	reg.bgid = ATEM_URING_RECV_GROUP;
+	if (syscall(__NR_io_uring_register, atem_uring.recv.fd, IORING_REGISTER_PBUF_RING, &reg, 1) == -1) {
+		int err = errno;
+		munmap(recv_ring, recv_ring_len);
+		atem_uring_ring_release(&atem_uring.send);
+		atem_uring_ring_release(&atem_uring.recv);
+		errno = err;
+		return false;
+	}
+	for (uint16_t buf_id = 0; buf_id < ATEM_URING_RECV_BUFS; buf_id++) {
+		atem_uring_recv_provide(buf_id);
+	}
+
+	// Receives peer address and kernel receive timestamp when tracking latency together with datagram
+	memset(&atem_uring.recv_msg, 0, sizeof(atem_uring.recv_msg));
+	atem_uring.recv_msg.msg_namelen = sizeof(struct sockaddr_in);
+	atem_uring.recv_msg.msg_controllen = (atem_server.latency_interval > 0) ? ATEM_LATENCY_CONTROL_LEN : 0;
+	atem_uring.recv_armed = false;
+	atem_uring_recv_arm();
+
+	// Marks all send slots as available
+	for (uint16_t slot = 0; slot < ATEM_URING_SEND_SLOTS; slot++) {
+		atem_uring.send_slots_free[slot] = ATEM_URING_SEND_SLOTS - 1 - slot;
+	}
+	atem_uring.send_slots_free_len = ATEM_URING_SEND_SLOTS;
+
+	atem_uring.active = true;
+	return true;
+}
+
+// Indicates if datagrams are sent and received through io_uring
+bool atem_uring_active(void) {
+	return atem_uring.active;
+}
+
+// Queues datagram to be sent by io_uring, submitted by atem_uring_submit or before waiting for datagrams to receive
+void atem_uring_send(const uint8_t* header, const uint8_t* payload, size_t payload_len, struct sockaddr_in* peer_addr) {
+	assert(atem_uring.active);
+	assert(header != NULL);
+	assert(payload != NULL);
+	assert(peer_addr != NULL);
+	assert((ATEM_LEN_HEADER + payload_len) <= ATEM_PACKET_LEN_MAX);
+
+	// Waits for in flight datagrams to be sent when all send slots are used
+	if (atem_uring.send_slots_free_len == 0) {
+		atem_uring_send_reap(0);
+	}
+	while (atem_uring.send_slots_free_len == 0) {
+		atem_uring_send_reap(1);
+	}
+
+	// Copies datagram into send slot
+	uint16_t slot_index = atem_uring.send_slots_free[--atem_uring.send_slots_free_len];
+	struct atem_uring_send_slot* slot = &atem_uring.send_slots[slot_index];
+	memcpy(slot->buf, header, ATEM_LEN_HEADER);
+	memcpy(slot->buf + ATEM_LEN_HEADER, payload, payload_len);
+	slot->peer_addr = *peer_addr;
+	slot->iov.iov_base = slot->buf;
+	slot->iov.iov_len = ATEM_LEN_HEADER + payload_len;
+	memset(&slot->msg, 0, sizeof(slot->msg));
+	slot->msg.msg_name = &slot->peer_addr;
+	slot->msg.msg_namelen = sizeof(slot->peer_addr);
+	slot->msg.msg_iov = &slot->iov;
+	slot->msg.msg_iovlen = 1;
+	slot->parse_time = 0;
+	atem_uring.send_slot_last = slot_index;
+
+	// Queues send of slot
+	struct io_uring_sqe* sqe = atem_uring_sqe_get(&atem_uring.send);
+	sqe->opcode = IORING_OP_SENDMSG;
+	sqe->fd = atem_server.sock;
+	sqe->addr = (uint64_t)(uintptr_t)&slot->msg;
+	sqe->len = 1;
+	sqe->user_data = slot_index;
+	atem_uring_sqe_queue(&atem_uring.send);
+}
+
+// Measures parse to send latency for the last queued datagram when io_uring has sent it
+void atem_uring_send_latency(uint64_t parse_time) {
+	assert(atem_uring.active);
+	assert(atem_uring_sq_pending(&atem_uring.send) > 0);
+	atem_uring.send_slots[atem_uring.send_slot_last].parse_time = parse_time;
+}
+
+// Submits all queued datagrams in a single system call
+void atem_uring_submit(void) {
+	assert(atem_uring.active);
+	if (atem_uring_sq_pending(&atem_uring.send) == 0) {
+		return;
+	}
+
+	DEBUG_PRINTF("Submitting %u datagrams to io_uring\n", atem_uring_sq_pending(&atem_uring.send));
+	if (atem_uring_enter(&atem_uring.send, 0, -1) == -1) {
+		perror("Failed to submit datagrams to io_uring");
+	}
+	atem_uring_send_reap(0);
+}
+
+/**
+ * Submits queued datagrams and waits for datagrams to be received, processing all received datagrams
+ * @attention Releases io_uring if the kernel does not support multishot receives, check atem_uring_active before waiting again
+ * @param timeout Milliseconds to wait at most or -1 to wait without timeout
+ * @return Number of datagrams processed or -1 on error with errno set
+ */
+int atem_uring_wait(int timeout) {
+	assert(atem_uring.active);
+	atem_uring_submit();
+
+	// Waits for received datagrams or timeout
+	if (atem_uring_enter(&atem_uring.recv, 1, timeout) == -1 && errno != ETIME && errno != EINTR) {
+		return -1;
+	}
+
+	// Processes all received datagrams, returning their buffers to the kernel after being processed
+	int count = 0;
+	struct io_uring_cqe* cqe;
+	while ((cqe = atem_uring_cqe_peek(&atem_uring.recv)) != NULL) {
+		int32_t res = cqe->res;
+		uint32_t flags = cqe->flags;
+		atem_uring_cqe_seen(&atem_uring.recv);
+
+		// Multishot receive has to be posted again after being terminated, for example when running out of buffers
+		if (!(flags & IORING_CQE_F_MORE)) {
+			atem_uring.recv_armed = false;
+		}
+		// Falls back to receiving without io_uring on kernels without multishot receive support, added in Linux 6.0
+		if (res == -EINVAL) {
+			fprintf(stderr, "Multishot receive not supported by kernel, falling back to poll\n");
+			atem_uring_release();
+			return count;
+		}
+		if (res < 0) {
+			if (-res != ENOBUFS) {
+				fprintf(stderr, "Failed to read proxy data: %s\n", strerror(-res));
+			}
+			continue;
+		}
+		assert(flags & IORING_CQE_F_BUFFER);
+
+		uint16_t buf_id = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+		atem_uring_recv_process(buf_id, (size_t)res);
+		atem_uring_recv_provide(buf_id);
+		count++;
+	}
+	DEBUG_PRINTF("Received %d datagrams from io_uring\n", count);
+
+	// Posts multishot receive again, submitted when waiting the next time
+	if (!atem_uring.recv_armed) {
+		atem_uring_recv_arm();
+	}
+
+	return count;
+}
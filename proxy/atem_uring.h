@@ -0,0 +1,24 @@
+// Include guard
+#ifndef ATEM_URING_H
+#define ATEM_URING_H
+
+#include <stdint.h> // uint8_t, uint64_t
+#include <stddef.h> // size_t
+#include <stdbool.h> // bool
+
+#include <netinet/in.h> // struct sockaddr_in
+
+// Number of datagrams that can be queued or in flight to be sent by io_uring at the same time
+#define ATEM_URING_SEND_SLOTS 128
+
+// Number of buffers provided to the kernel for multishot receives on the server socket, has to be a power of two
+#define ATEM_URING_RECV_BUFS 64
+
+bool atem_uring_init(void);
+bool atem_uring_active(void);
+void atem_uring_send(const uint8_t* header, const uint8_t* payload, size_t payload_len, struct sockaddr_in* peer_addr);
+void atem_uring_send_latency(uint64_t parse_time);
+void atem_uring_submit(void);
+int atem_uring_wait(int timeout);
+
+#endif // ATEM_URING_H
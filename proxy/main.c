@@ -1,5 +1,5 @@
 #include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS
-#include <stdio.h> // perror
+#include <stdio.h> // perror, fflush
 #include <ctype.h> // isdigit
 #include <assert.h> // assert
 #include <stdint.h> // uint16_t
@@ -7,10 +7,14 @@
 
 #include <getopt.h> // getopt, optarg
 
-#include "./atem_server.h" // atem_server_init
+#include "./atem_server.h" // atem_server_init, ATEM_SERVER_IO_URING
 #include "./atem_cache.h" // atem_cache_init
 #include "./atem_assert.h" // atem_assert
 #include "./timeout.h" // timeout_next, timeout_dispatch
+#include "../core/atem_capture.h" // atem_capture_open, ATEM_CAPTURE_ROLE_SERVER
+#if ATEM_SERVER_IO_URING
+#include "./atem_uring.h" // atem_uring_init, atem_uring_active, atem_uring_wait
+#endif // ATEM_SERVER_IO_URING
 
 #include <poll.h> // poll, struct pollfd, POLLIN
 
@@ -33,7 +37,7 @@ static uint16_t cli_option_get(void) {
 int main(int argc, char** argv) {
 	// Sets ATEM proxy server configuration
 	int opt;
-	while ((opt = getopt(argc, argv, "hl:r:p:")) != -1) switch (opt) {
+	while ((opt = getopt(argc, argv, "hl:r:p:w:t:")) != -1) switch (opt) {
 		case 'l': {
 			atem_server.sessions_limit = cli_option_get();
 			if (atem_server.sessions_limit == 0) {
@@ -58,13 +62,31 @@ int main(int argc, char** argv) {
 			}
 			break;
 		}
+		case 'w': {
+			atem_server.capture = atem_capture_open(optarg, ATEM_CAPTURE_ROLE_SERVER);
+			if (atem_server.capture == NULL) {
+				perror("Failed to create capture file");
+				return EXIT_FAILURE;
+			}
+			break;
+		}
+		case 't': {
+			atem_server.latency_interval = cli_option_get();
+			if (atem_server.latency_interval == 0) {
+				printf("Invalid latency print interval: %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		}
 		case 'h': {
 			printf(
 				"Usage: %s [options] ...\n"
 				"Options:\n"
 				"\t-l <arg>        Limit the number of concurrent sessions to <arg>. Defaults to 5.\n"
 				"\t-r <arg>        Time in ms before an unacknowledged packet is retransmitted. Defaults to 200ms.\n"
-				"\t-p <arg>        Time in ms between pings. Defaults to 500ms.\n",
+				"\t-p <arg>        Time in ms between pings. Defaults to 500ms.\n"
+				"\t-w <arg>        Records all sent and received packets to capture file <arg>.\n"
+				"\t-t <arg>        Prints receive-to-parse and parse-to-send latency histograms every <arg> ms.\n",
 				argv[0]
 			);
 			return EXIT_SUCCESS;
@@ -83,9 +105,35 @@ int main(int argc, char** argv) {
 		return EXIT_FAILURE;
 	}
 
+#if ATEM_SERVER_IO_URING
+	// Sets up io_uring for receiving and sending datagrams, falling back to poll if kernel does not support it
+	if (!atem_uring_init()) {
+		perror("Failed to set up io_uring, falling back to poll");
+	}
+#endif // ATEM_SERVER_IO_URING
+
 	// Runs ATEM proxy server event loop
 	struct pollfd pollfd = { .fd = atem_server.sock, .events = POLLIN };
 	while (true) {
+#if ATEM_SERVER_IO_URING
+		// Waits for datagrams with io_uring for as long as it is available
+		if (atem_uring_active()) {
+			int recved = atem_uring_wait(timeout_next());
+			if (recved == -1) {
+				perror("Failed to wait for ATEM server socket");
+				return EXIT_FAILURE;
+			}
+			assert(recved >= 0);
+
+			// Writes buffered capture records to disk while idle
+			if (recved == 0 && atem_server.capture != NULL) {
+				fflush(atem_server.capture);
+			}
+			continue;
+		}
+#endif // ATEM_SERVER_IO_URING
+
+		// Waits for datagrams with poll
 		int poll_len = poll(&pollfd, 1, timeout_next());
 		if (poll_len == -1) {
 			perror("Failed to poll ATEM server socket");
@@ -97,6 +145,10 @@ int main(int argc, char** argv) {
 		if (pollfd.revents) {
 			atem_server_recv();
 		}
+		// Writes buffered capture records to disk while idle
+		else if (atem_server.capture != NULL) {
+			fflush(atem_server.capture);
+		}
 	}
 
 	return EXIT_SUCCESS;
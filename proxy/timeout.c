@@ -3,7 +3,7 @@
 #include <stdint.h> // uint32_t
 #include <limits.h> // INT_MAX
 
-#include "./atem_server.h" // atem_server
+#include "./atem_server.h" // atem_server, atem_server_latency_print
 #include "./atem_packet.h" // atem_packet_broadcast_ping
 #include "./atem_debug.h" // DEBUG_PRINTF
 #include "./timeout.h"
@@ -69,6 +69,20 @@ int timeout_next(void) {
 	}
 	assert(timeout > 0);
 
+	// Prints latency histograms when their interval has expired and gets time until next print if closer than other timeouts
+	if (atem_server.latency_interval > 0) {
+		unsigned int timeout_latency = timeout_remaining(&now, &atem_server.latency_timestamp, atem_server.latency_interval);
+		if (timeout_latency == 0) {
+			atem_server_latency_print();
+			atem_server.latency_timestamp = now;
+			timeout_latency = atem_server.latency_interval;
+		}
+		if (timeout_latency < timeout) {
+			timeout = timeout_latency;
+		}
+	}
+	assert(timeout > 0);
+
 	if (timeout == ~0u) {
 		DEBUG_PRINTF("No timeout\n\n");
 	}
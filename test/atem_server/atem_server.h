@@ -9,6 +9,7 @@ void atem_server_data(void);
 void atem_server_data_extended(void);
 void atem_server_cc(void);
 void atem_server_commands(void);
+void atem_server_storm(void);
 
 void atem_server(void);
 void atem_server_extended(void);
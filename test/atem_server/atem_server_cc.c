@@ -39,7 +39,7 @@ void atem_server_cc(void) {
 		uint16_t session_id = atem_handshake_connect(sock, atem_header_sessionid_rand(false));
 
 		struct atem atem = { .dest = 1 };
-		atem_connection_open(&atem);
+		atem_connection_open(&atem, 0x1337);
 		atem_handshake_opcode_set(atem.read_buf, ATEM_OPCODE_ACCEPT);
 		assert(atem_parse(&atem) == ATEM_STATUS_ACCEPTED);
 
@@ -0,0 +1,121 @@
+#include <stdint.h> // uint32_t, int32_t, UINT32_MAX
+#include <stdbool.h> // bool, true, false
+#include <stdio.h> // printf, fprintf, stderr
+#include <stdlib.h> // getenv, atoi, abort
+#include <assert.h> // assert
+
+#include <arpa/inet.h> // inet_addr
+#include <netinet/in.h> // in_addr_t
+#include <poll.h> // poll, struct pollfd, POLLIN
+#include <unistd.h> // close
+
+#include "../utils/utils.h"
+
+// Number of clients booting at the same time, same as the default session limit of the proxy
+#define STORM_CLIENTS_DEFAULT 5
+
+// Maximum number of clients booting at the same time
+#define STORM_CLIENTS_MAX 256
+
+// Time all clients have to receive their initial state within
+#define STORM_TIMEOUT_MS (ATEM_TIMEOUT_MS * 2)
+
+// Command ending initial state dump, after which tally is known
+#define STORM_CMDNAME_INITCOMPLETE ATEM_CMDNAME('I', 'n', 'C', 'm')
+
+// Gets number of clients to boot at the same time from environment variable
+static int storm_clients_get(void) {
+	const char* env_value = getenv("ATEM_STORM_CLIENTS");
+	if (env_value == NULL) {
+		return STORM_CLIENTS_DEFAULT;
+	}
+	const int clients = atoi(env_value);
+	if (clients <= 0 || clients > STORM_CLIENTS_MAX) {
+		fprintf(stderr, "Invalid ATEM_STORM_CLIENTS value: %s\n", env_value);
+		abort();
+	}
+	return clients;
+}
+
+void atem_server_storm(void) {
+	// Ensures clients booting at the same time all receive their initial state without colliding
+	RUN_TEST() {
+		const int clients = storm_clients_get();
+		const char* addr_str = getenv("ATEM_SERVER_ADDR");
+		if (addr_str == NULL) {
+			fprintf(stderr, "Environment variable ATEM_SERVER_ADDR not defined\n");
+			abort();
+		}
+		const in_addr_t addr = inet_addr(addr_str);
+
+		// Sends opening handshake for all clients at once
+		static struct atem_posix_ctx ctxs[STORM_CLIENTS_MAX];
+		static bool ready_state[STORM_CLIENTS_MAX];
+		uint32_t ready_max = 0;
+		const uint32_t start = atem_posix_now();
+		for (int i = 0; i < clients; i++) {
+			assert(atem_init(&ctxs[i], addr));
+			ctxs[i].atem.cmd_filter = ATEM_CMD_FILTER_BIT(STORM_CMDNAME_INITCOMPLETE);
+			ready_state[i] = false;
+			assert(atem_send(&ctxs[i]));
+		}
+
+		// Processes all clients until every client has received its initial state
+		int ready = 0;
+		int retries = 0;
+		while (ready < clients && (int32_t)(atem_posix_now() - start) < STORM_TIMEOUT_MS) {
+			// Waits for any client to become readable or the next client deadline
+			struct pollfd fds[STORM_CLIENTS_MAX];
+			const uint32_t now = atem_posix_now();
+			uint32_t wait = UINT32_MAX;
+			for (int i = 0; i < clients; i++) {
+				fds[i].fd = atem_posix_fd(&ctxs[i]);
+				fds[i].events = POLLIN;
+				const int32_t remaining = (int32_t)(atem_posix_deadline(&ctxs[i]) - now);
+				if (remaining <= 0) {
+					wait = 0;
+				}
+				else if ((uint32_t)remaining < wait) {
+					wait = (uint32_t)remaining;
+				}
+			}
+			assert(poll(fds, (nfds_t)clients, (int)wait) != -1);
+
+			for (int i = 0; i < clients; i++) {
+				// Processes all available packets for client
+				enum atem_posix_status status;
+				while (
+					(fds[i].revents & POLLIN) &&
+					(status = atem_posix_readable(&ctxs[i])) != ATEM_POSIX_STATUS_NONE
+				) {
+					assert(status != ATEM_POSIX_STATUS_ERROR_NETWORK);
+					assert(status != ATEM_POSIX_STATUS_ERROR_PARSE);
+					while (atem_cmd_available(&ctxs[i].atem)) {
+						if (atem_cmd_next(&ctxs[i].atem) != STORM_CMDNAME_INITCOMPLETE || ready_state[i]) continue;
+						ready_state[i] = true;
+						ready_max = atem_posix_now() - start;
+						ready++;
+					}
+				}
+
+				// Retries opening handshake for clients that got no response
+				if (atem_posix_deadline_reached(&ctxs[i]) == ATEM_POSIX_STATUS_DROPPED) {
+					atem_send(&ctxs[i]);
+					retries++;
+				}
+			}
+		}
+
+		// Prints time until last client had tally available
+		printf("%d of %d clients received initial state within %u ms with %d handshake retries\n", ready, clients, ready_max, retries);
+
+		// Closes all sessions to not occupy server slots for other tests
+		for (int i = 0; i < clients; i++) {
+			atem_connection_close(&ctxs[i].atem);
+			atem_send(&ctxs[i]);
+			close(atem_posix_fd(&ctxs[i]));
+		}
+
+		assert(ready == clients);
+	}
+}
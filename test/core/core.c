@@ -1,10 +1,45 @@
-#include <stdint.h> // UINT16_MAX, uint16_t
+#include <stdint.h> // UINT16_MAX, UINT32_MAX, uint16_t
 #include <stdbool.h> // true, false
 #include <assert.h> // assert
-#include <string.h> // strlen, strcmp
+#include <string.h> // strlen, strcmp, memcmp, memcpy
 #include <stddef.h> // size_t
+#include <stdlib.h> // malloc, free
 
 #include "../utils/utils.h"
+#include "../../core/atem_dispatch.h" // ATEM_DISPATCH_DEFINE, ATEM_DISPATCH_DEFINE_CONTEXT, ATEM_DISPATCH_FILTER
+
+
+
+// Records last command dispatched to test handlers
+static uint8_t* dispatch_buf;
+static uint16_t dispatch_len;
+static int dispatch_handler;
+
+// Test handlers for command dispatch
+static void dispatch_test_a(uint8_t* buf, uint16_t len) {
+	dispatch_buf = buf;
+	dispatch_len = len;
+	dispatch_handler = 1;
+}
+static void dispatch_test_b(uint8_t* buf, uint16_t len) {
+	dispatch_buf = buf;
+	dispatch_len = len;
+	dispatch_handler = 2;
+}
+
+// Test command registry
+#define DISPATCH_TEST_COMMANDS(X) \
+	X(ATEM_CMDNAME('A', 'A', 'A', 'A'), 0, dispatch_test_a) \
+	X(ATEM_CMDNAME('B', 'B', 'B', 'B'), 4, dispatch_test_b)
+ATEM_DISPATCH_DEFINE(dispatch_test, DISPATCH_TEST_COMMANDS)
+
+// Test handler and registry for command dispatch without arguments
+static void dispatch_test_context(void) {
+	dispatch_handler = 3;
+}
+#define DISPATCH_TEST_CONTEXT_COMMANDS(X) \
+	X(ATEM_CMDNAME('C', 'C', 'C', 'C'), 2, dispatch_test_context)
+ATEM_DISPATCH_DEFINE_CONTEXT(dispatch_test_ctx, DISPATCH_TEST_CONTEXT_COMMANDS)
 
 int main(void) {
 	// Ensures ATEM_PACKET_LEN_MAX equals to the max length left after bits
@@ -96,6 +131,691 @@ int main(void) {
 		assert(atem.cmd_index_next == atem.read_len);
 	}
 
+	// Ensures commands are extracted from caller-owned buffer without using read buffer
+	RUN_TEST() {
+		struct atem atem = {0};
+		uint8_t buf[ATEM_PACKET_LEN_MAX] = {0};
+		atem_acknowledge_request_set(buf, atem_header_sessionid_rand(false), 0x0001);
+		char* payload_buf = "borrowed";
+		const uint16_t payload_len = strlen(payload_buf) & ATEM_PACKET_LEN_MAX;
+		atem_command_append(buf, "TEST", payload_buf, payload_len);
+		const uint16_t len = atem_header_len_get(buf);
+
+		assert(atem_parse_buf(&atem, buf, len) == ATEM_STATUS_WRITE);
+		assert(atem.parse_buf == buf);
+		assert(atem.read_len == len);
+		assert(atem_cmd_available(&atem));
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('T', 'E', 'S', 'T'));
+		assert(atem.cmd_payload_buf == &buf[ATEM_LEN_HEADER + ATEM_LEN_CMDHEADER]);
+		assert(atem.cmd_payload_len == payload_len);
+		assert(!atem_cmd_available(&atem));
+	}
+
+	// Ensures command index contains all commands and selected commands match iteration
+	RUN_TEST() {
+		struct atem atem = {0};
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "AAAA", "first", 5);
+		atem_command_append(atem.read_buf, "TlIn", (uint8_t[]){ 0x00, 0x02, 0x00, 0x01 }, 4);
+		atem_command_append(atem.read_buf, "BBBB", "last", 4);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+
+		// Indexes all commands and truncates index without failing
+		struct atem_cmd_entry entries[ATEM_CMD_INDEX_MAX];
+		assert(atem_cmd_index(&atem, entries, ATEM_CMD_INDEX_MAX) == 3);
+		assert(atem_cmd_index(&atem, entries, 1) == 3);
+		assert(atem_cmd_index(&atem, NULL, 0) == 3);
+		assert(atem_cmd_index(&atem, entries, ATEM_CMD_INDEX_MAX) == 3);
+
+		// Compares index against iterating commands
+		for (uint16_t i = 0; i < 3; i++) {
+			assert(atem_cmd_available(&atem));
+			assert(atem_cmd_next(&atem) == entries[i].name);
+			assert(atem.cmd_payload_buf == &atem.read_buf[entries[i].offset]);
+			assert(atem.cmd_payload_len == entries[i].len);
+		}
+		assert(!atem_cmd_available(&atem));
+
+		// Looks up command by name and processes it
+		const struct atem_cmd_entry* entry = atem_cmd_index_find(entries, 3, ATEM_CMDNAME_TALLY);
+		assert(entry == &entries[1]);
+		assert(atem_cmd_index_select(&atem, entry) == ATEM_CMDNAME_TALLY);
+		atem.dest = 2;
+		assert(atem_tally_updated(&atem));
+		assert(atem.tally_pgm);
+		assert(atem_cmd_index_find(entries, 3, ATEM_CMDNAME_CAMERACONTROL) == NULL);
+	}
+
+	// Ensures commands are dispatched to registered handlers only with required payload length
+	RUN_TEST() {
+		struct atem atem = {0};
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "AAAA", "a", 1);
+		atem_command_append(atem.read_buf, "BBBB", "bbbb", 4);
+		atem_command_append(atem.read_buf, "BBBB", "bbb", 3);
+		atem_command_append(atem.read_buf, "CCCC", "cccc", 4);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+
+		const int handlers_expected[] = { 1, 2, 0, 0 };
+		for (size_t i = 0; i < (sizeof(handlers_expected) / sizeof(*handlers_expected)); i++) {
+			dispatch_handler = 0;
+			assert(atem_cmd_available(&atem));
+			const uint32_t cmd_name = atem_cmd_next(&atem);
+			assert(dispatch_test(cmd_name, atem.cmd_payload_buf, atem.cmd_payload_len) == (handlers_expected[i] != 0));
+			assert(dispatch_handler == handlers_expected[i]);
+			if (dispatch_handler == 0) continue;
+			assert(dispatch_buf == atem.cmd_payload_buf);
+			assert(dispatch_len == atem.cmd_payload_len);
+		}
+		assert(!atem_cmd_available(&atem));
+	}
+
+	// Ensures commands are dispatched to registered handlers without arguments only with required payload length
+	RUN_TEST() {
+		struct atem atem = {0};
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "CCCC", "c", 1);
+		atem_command_append(atem.read_buf, "CCCC", "cc", 2);
+		atem_command_append(atem.read_buf, "AAAA", "aa", 2);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+
+		const int handlers_expected[] = { 0, 3, 0 };
+		for (size_t i = 0; i < (sizeof(handlers_expected) / sizeof(*handlers_expected)); i++) {
+			dispatch_handler = 0;
+			assert(atem_cmd_available(&atem));
+			const uint32_t cmd_name = atem_cmd_next(&atem);
+			assert(dispatch_test_ctx(cmd_name, atem.cmd_payload_len) == (handlers_expected[i] != 0));
+			assert(dispatch_handler == handlers_expected[i]);
+		}
+		assert(!atem_cmd_available(&atem));
+	}
+
+	// Ensures zero length command is rejected by index and ends command iteration
+	RUN_TEST() {
+		struct atem atem = {0};
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "AAAA", "first", 5);
+		atem_command_append(atem.read_buf, "BBBB", "zero", 4);
+		const uint16_t offset = ATEM_LEN_HEADER + ATEM_LEN_CMDHEADER + 5;
+		atem.read_buf[offset] = 0;
+		atem.read_buf[offset + 1] = 0;
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+
+		struct atem_cmd_entry entries[ATEM_CMD_INDEX_MAX];
+		assert(atem_cmd_index(&atem, entries, ATEM_CMD_INDEX_MAX) == -1);
+
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('A', 'A', 'A', 'A'));
+		assert(atem_cmd_available(&atem));
+		assert(atem_cmd_next(&atem) == 0);
+		assert(atem.cmd_payload_len == 0);
+		assert(!atem_cmd_available(&atem));
+	}
+
+	// Ensures command filter skips commands without their bit set and returns 0 if trailing commands are skipped
+	RUN_TEST() {
+		struct atem atem = {0};
+		char* names[] = { "CCCC", "AAAA", "DDDD", "BBBB", "EEEE" };
+		const size_t names_len = sizeof(names) / sizeof(names[0]);
+
+		// Returns all commands without filter
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		for (size_t i = 0; i < names_len; i++) {
+			atem_command_append(atem.read_buf, names[i], names[i], 4);
+		}
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		for (size_t i = 0; i < names_len; i++) {
+			assert(atem_cmd_available(&atem));
+			assert(atem_cmd_next(&atem) == (uint32_t)ATEM_CMDNAME(names[i][0], names[i][1], names[i][2], names[i][3]));
+		}
+		assert(!atem_cmd_available(&atem));
+
+		// Only returns commands in dispatch registry when filtered
+		atem.cmd_filter = ATEM_DISPATCH_FILTER(DISPATCH_TEST_COMMANDS);
+		assert(atem.cmd_filter == (ATEM_CMD_FILTER_BIT(ATEM_CMDNAME('A', 'A', 'A', 'A')) | ATEM_CMD_FILTER_BIT(ATEM_CMDNAME('B', 'B', 'B', 'B'))));
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0002);
+		for (size_t i = 0; i < names_len; i++) {
+			atem_command_append(atem.read_buf, names[i], names[i], 4);
+		}
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('A', 'A', 'A', 'A'));
+		assert(atem.cmd_payload_len == 4 && !memcmp(atem.cmd_payload_buf, "AAAA", 4));
+		assert(atem_cmd_available(&atem));
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('B', 'B', 'B', 'B'));
+		assert(atem.cmd_payload_len == 4 && !memcmp(atem.cmd_payload_buf, "BBBB", 4));
+		assert(atem_cmd_available(&atem));
+		assert(atem_cmd_next(&atem) == 0);
+		assert(atem.cmd_payload_len == 0);
+		assert(!atem_cmd_available(&atem));
+	}
+
+	// Ensures truncated caller-owned buffer returns ATEM_STATUS_ERROR
+	RUN_TEST() {
+		struct atem atem = {0};
+		uint8_t buf[ATEM_PACKET_LEN_MAX] = {0};
+		atem_acknowledge_request_set(buf, atem_header_sessionid_rand(false), 0x0001);
+		atem_command_append(buf, "TEST", "payload", 7);
+		assert(atem_parse_buf(&atem, buf, atem_header_len_get(buf) - 1) == ATEM_STATUS_ERROR);
+		assert(atem_parse_buf(&atem, buf, ATEM_LEN_HEADER - 1) == ATEM_STATUS_ERROR);
+		assert(atem.remote_id_last == 0);
+	}
+
+	// Ensures command iteration never reads a truncated command header past the end of an exact size buffer
+	RUN_TEST() {
+		uint8_t packet[ATEM_PACKET_LEN_MAX] = {0};
+		atem_acknowledge_request_set(packet, atem_header_sessionid_rand(false), 0x0001);
+		atem_command_append(packet, "TEST", "payload", 7);
+		const uint16_t len = atem_header_len_get(packet) + 1;
+		atem_header_len_set(packet, len);
+		packet[len - 1] = 0xff;
+
+		// Iterates commands with and without filter from heap buffer allocated to exact packet length
+		for (int filtered = 0; filtered <= 1; filtered++) {
+			uint8_t* buf = malloc(len);
+			assert(buf != NULL);
+			memcpy(buf, packet, len);
+			struct atem atem = {0};
+			if (filtered) {
+				atem.cmd_filter = ATEM_CMD_FILTER_BIT(ATEM_CMDNAME('A', 'A', 'A', 'A'));
+			}
+			assert(atem_parse_buf(&atem, buf, len) == ATEM_STATUS_WRITE);
+			if (!filtered) {
+				assert(atem_cmd_next(&atem) == ATEM_CMDNAME('T', 'E', 'S', 'T'));
+			}
+			assert(atem_cmd_next(&atem) == 0);
+			assert(atem.cmd_payload_len == 0);
+			assert(!atem_cmd_available(&atem));
+			free(buf);
+		}
+	}
+
+	// Ensures parsing for one context only invalidates shared write buffers when not owned by each context
+	RUN_TEST() {
+		struct atem atem_a = {0};
+		struct atem atem_b = {0};
+		atem_acknowledge_request_set(atem_a.read_buf, 0x8001, 0x0001);
+		atem_acknowledge_request_set(atem_b.read_buf, 0x8002, 0x0002);
+		atem_b.remote_id_last = 0x0001;
+		assert(atem_parse(&atem_a) == ATEM_STATUS_WRITE);
+		assert(atem_parse(&atem_b) == ATEM_STATUS_WRITE);
+#if ATEM_WRITE_BUF_CONTEXT
+		assert(atem_a.write_buf != atem_b.write_buf);
+		atem_acknowledge_response_get_verify(atem_a.write_buf, 0x8001, 0x0001);
+#else // ATEM_WRITE_BUF_CONTEXT
+		assert(atem_a.write_buf == atem_b.write_buf);
+#endif // ATEM_WRITE_BUF_CONTEXT
+		atem_acknowledge_response_get_verify(atem_b.write_buf, 0x8002, 0x0002);
+	}
+
+	// Ensures tally for all inputs matches single input tally and only marks changed inputs
+	RUN_TEST() {
+		struct atem atem = {0};
+		struct atem_tally tally = {0};
+		uint8_t payload[2 + 41] = { 0, 41 };
+		for (uint16_t i = 0; i < 41; i++) {
+			payload[2 + i] = i % 4;
+		}
+		payload[2 + 40] = 0x01;
+
+		// Decodes every input and compares against tally for single input
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "TlIn", payload, sizeof(payload));
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME_TALLY);
+		assert(atem_tally_all_updated(&atem, &tally));
+		assert(tally.len == 41);
+		for (uint16_t dest = 1; dest <= 41; dest++) {
+			atem.dest = (uint8_t)dest;
+			atem_tally_updated(&atem);
+			assert(atem_tally_pgm(&tally, atem.dest) == atem.tally_pgm);
+			assert(atem_tally_pvw(&tally, atem.dest) == atem.tally_pvw);
+			assert(atem_tally_changed(&tally, atem.dest) == (atem.tally_pgm || atem.tally_pvw));
+		}
+		assert(!atem_tally_pgm(&tally, 42) && !atem_tally_pvw(&tally, 42));
+
+		// Updates tally for two inputs and drops the last input
+		payload[1] = 40;
+		payload[2 + 0] = 0x02;
+		payload[2 + 33] = 0x00;
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0002);
+		atem_command_append(atem.read_buf, "TlIn", payload, sizeof(payload));
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME_TALLY);
+		assert(atem_tally_all_updated(&atem, &tally));
+		assert(tally.len == 40);
+		for (uint16_t dest = 1; dest <= ATEM_TALLY_INPUTS_MAX - 1; dest++) {
+			assert(atem_tally_changed(&tally, (uint8_t)dest) == (dest == 1 || dest == 34 || dest == 41));
+		}
+		assert(atem_tally_pvw(&tally, 1) && !atem_tally_pgm(&tally, 1));
+		assert(!atem_tally_pgm(&tally, 34) && !atem_tally_pvw(&tally, 34));
+
+		// Ensures identical tally is not reported as updated
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0003);
+		atem_command_append(atem.read_buf, "TlIn", payload, sizeof(payload));
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME_TALLY);
+		assert(!atem_tally_all_updated(&atem, &tally));
+	}
+
+	// Ensures tally for all inputs matches single input tally for flag bytes with unknown bits set
+	RUN_TEST() {
+		struct atem atem = {0};
+		struct atem_tally tally = {0};
+		uint8_t payload[2 + 32] = { 0, 32 };
+
+		// Decodes every possible flag byte at every position within a packed word
+		for (uint16_t base = 0; base <= UINT8_MAX; base += 32) {
+			for (uint16_t i = 0; i < 32; i++) {
+				payload[2 + i] = (uint8_t)(base + i);
+			}
+			atem_packet_clear(atem.read_buf);
+			atem_acknowledge_request_set(atem.read_buf, 0x0001, (uint16_t)(base / 32 + 1));
+			atem_command_append(atem.read_buf, "TlIn", payload, sizeof(payload));
+			assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+			assert(atem_cmd_next(&atem) == ATEM_CMDNAME_TALLY);
+			atem_tally_all_updated(&atem, &tally);
+			for (uint16_t dest = 1; dest <= 32; dest++) {
+				atem.dest = (uint8_t)dest;
+				atem_tally_updated(&atem);
+				assert(atem_tally_pgm(&tally, atem.dest) == atem.tally_pgm);
+				assert(atem_tally_pvw(&tally, atem.dest) == atem.tally_pvw);
+				assert(atem.tally_pvw == (payload[1 + dest] == 0x02));
+			}
+		}
+	}
+
+	// Ensures camera control commands are batched into one buffer identical to translating in place
+	RUN_TEST() {
+		struct atem atem = {0};
+		uint8_t cc_int16[24] = { 1, 0x08, 0x04, 0x80, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00 };
+		cc_int16[16] = 0x04;
+		cc_int16[18] = 0x08;
+		uint8_t cc_int8[24] = { 1, 0x01, 0x08, 0x01, 0x00, 0x03 };
+		cc_int8[16] = 0x01;
+		cc_int8[17] = 0x02;
+		cc_int8[18] = 0x03;
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "CCdP", cc_int16, sizeof(cc_int16));
+		atem_command_append(atem.read_buf, "TEST", "test", 4);
+		atem_command_append(atem.read_buf, "CCdP", cc_int8, sizeof(cc_int8));
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+
+		uint8_t batch[64] = {0};
+		uint16_t batch_len = 0;
+		while (atem_cmd_available(&atem)) {
+			if (atem_cmd_next(&atem) != ATEM_CMDNAME_CAMERACONTROL) continue;
+
+			// Translates into batch and ensures it does not fit in a too small buffer
+			assert(atem_cc_translate_buf(&atem, &batch[batch_len], 8) == 0);
+			const uint16_t len = atem_cc_translate_buf(&atem, &batch[batch_len], sizeof(batch) - batch_len);
+			assert(len == 12);
+
+			// Compares against translating in place
+			atem_cc_translate(&atem);
+			assert(atem.cmd_payload_len == len);
+			assert(memcmp(atem.cmd_payload_buf, &batch[batch_len], len) == 0);
+			batch_len += len;
+		}
+		assert(batch_len == 24);
+		assert(batch[0] == 1 && batch[1] == 8 && batch[4] == 0x08 && batch[5] == 0x04);
+		assert(batch[8] == 0x00 && batch[9] == 0x04 && batch[10] == 0x00 && batch[11] == 0x08);
+		assert(batch[12 + 1] == 7 && batch[12 + 8] == 0x01 && batch[12 + 10] == 0x03 && batch[12 + 11] == 0x00);
+	}
+
+	// Ensures only camera control assignments changing the cached value are reported as changed
+	RUN_TEST() {
+		struct atem atem = {0};
+		struct atem_cc_cache cache = {0};
+		uint8_t cc_assign[24] = { 1, 0x08, 0x04, 0x80, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00 };
+		cc_assign[16] = 0x04;
+		cc_assign[18] = 0x08;
+		uint8_t cc_offset[24] = { 1, 0x08, 0x04, 0x80, 0x01, 0x00, 0x00, 0x02, 0x00, 0x00 };
+		uint8_t cc_trigger[24] = { 1, 0x00, 0x01, 0x00, 0x00 };
+		const bool changed_expected[] = { true, false, true, false, true, true, false, true, true };
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "CCdP", cc_assign, sizeof(cc_assign));
+		atem_command_append(atem.read_buf, "CCdP", cc_assign, sizeof(cc_assign));
+		cc_assign[18] = 0x09;
+		atem_command_append(atem.read_buf, "CCdP", cc_assign, sizeof(cc_assign));
+		atem_command_append(atem.read_buf, "CCdP", cc_assign, sizeof(cc_assign));
+		atem_command_append(atem.read_buf, "CCdP", cc_offset, sizeof(cc_offset));
+		atem_command_append(atem.read_buf, "CCdP", cc_assign, sizeof(cc_assign));
+		atem_command_append(atem.read_buf, "CCdP", cc_assign, sizeof(cc_assign));
+		atem_command_append(atem.read_buf, "CCdP", cc_trigger, sizeof(cc_trigger));
+		atem_command_append(atem.read_buf, "CCdP", cc_trigger, sizeof(cc_trigger));
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		for (size_t i = 0; i < sizeof(changed_expected) / sizeof(changed_expected[0]); i++) {
+			assert(atem_cmd_next(&atem) == ATEM_CMDNAME_CAMERACONTROL);
+			assert(atem_cc_cache_changed(&atem, &cache) == changed_expected[i]);
+		}
+		assert(!atem_cmd_available(&atem));
+		assert(cache.suppressed == 3);
+		assert(cache.forwarded == 6);
+
+		// Ensures cleared cache reports same value as changed again
+		atem_cc_cache_reset(&cache);
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0002);
+		atem_command_append(atem.read_buf, "CCdP", cc_assign, sizeof(cc_assign));
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME_CAMERACONTROL);
+		assert(atem_cc_cache_changed(&atem, &cache));
+		assert(cache.suppressed == 3);
+	}
+
+	// Ensures common camera control parameters in neighbouring categories are cached in separate slots
+	RUN_TEST() {
+		const uint8_t params[][2] = { { 0, 0 }, { 1, 1 }, { 0, 2 }, { 1, 3 }, { 0, 4 }, { 1, 5 } };
+		const size_t params_len = sizeof(params) / sizeof(params[0]);
+		for (size_t i = 0; i < params_len; i += 2) {
+			assert(atem_cc_cache_slot(params[i][0], params[i][1]) != atem_cc_cache_slot(params[i + 1][0], params[i + 1][1]));
+		}
+
+		// Suppresses resent values for all parameters without evicting each other
+		struct atem atem = {0};
+		struct atem_cc_cache cache = {0};
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		for (int resend = 0; resend < 2; resend++) {
+			for (size_t i = 0; i < params_len; i++) {
+				uint8_t cc_assign[24] = { 1, params[i][0], params[i][1], 0x80, 0x00, 0x00, 0x00, 0x01 };
+				cc_assign[17] = (uint8_t)i;
+				atem_command_append(atem.read_buf, "CCdP", cc_assign, sizeof(cc_assign));
+			}
+		}
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		for (size_t i = 0; i < params_len * 2; i++) {
+			assert(atem_cmd_next(&atem) == ATEM_CMDNAME_CAMERACONTROL);
+			assert(atem_cc_cache_changed(&atem, &cache) == (i < params_len));
+		}
+		assert(cache.suppressed == params_len);
+		for (size_t i = 0; i < params_len; i++) {
+			assert(atem_cc_cache_get(&cache, params[i][0], params[i][1]) != NULL);
+		}
+	}
+
+	// Ensures batch of packets is acknowledged with a single cumulative acknowledgement
+	RUN_TEST() {
+		struct atem atem = {0};
+		static uint8_t packets[5][ATEM_PACKET_LEN_MAX];
+		const uint16_t remote_ids[] = { 0x0001, 0x0002, 0x0002, 0x0004 };
+		for (size_t i = 0; i < sizeof(remote_ids) / sizeof(remote_ids[0]); i++) {
+			atem_packet_clear(packets[i]);
+			atem_acknowledge_request_set(packets[i], 0x0001, remote_ids[i]);
+			atem_command_append(packets[i], "TEST", "test", 4);
+		}
+		atem_packet_clear(packets[4]);
+		atem_acknowledge_response_set(packets[4], 0x0001, 0x0000);
+		uint8_t* bufs[5];
+		uint16_t lens[5];
+		for (size_t i = 0; i < 5; i++) {
+			bufs[i] = packets[i];
+			lens[i] = atem_header_len_get(packets[i]);
+		}
+
+		// Processes payload of packets in sequence and requests retransmit for gap without acknowledging each packet
+		uint16_t index = 0;
+		assert(atem_parse_batch(&atem, bufs, lens, 5, &index) == ATEM_STATUS_WRITE);
+		assert(index == 1);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('T', 'E', 'S', 'T'));
+		assert(atem_parse_batch(&atem, bufs, lens, 5, &index) == ATEM_STATUS_WRITE);
+		assert(index == 2);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('T', 'E', 'S', 'T'));
+		assert(atem_parse_batch(&atem, bufs, lens, 5, &index) == ATEM_STATUS_WRITE_ONLY);
+		assert(index == 4);
+		assert(atem.write_buf[ATEM_INDEX_FLAGS] == ATEM_FLAG_RETXREQ);
+		assert(atem_parse_batch(&atem, bufs, lens, 5, &index) == ATEM_STATUS_WRITE_ONLY);
+		assert(index == 5);
+		assert(atem.write_len == ATEM_LEN_HEADER);
+		atem_acknowledge_response_get_verify(atem.write_buf, 0x0001, 0x0002);
+		assert(atem_parse_batch(&atem, bufs, lens, 5, &index) == ATEM_STATUS_NONE);
+
+		// Acknowledges last packet in sequence after filling gap
+		atem_packet_clear(packets[0]);
+		atem_acknowledge_request_set(packets[0], 0x0001, 0x0003);
+		lens[0] = atem_header_len_get(packets[0]);
+		bufs[1] = packets[3];
+		lens[1] = atem_header_len_get(packets[3]);
+		index = 0;
+		assert(atem_parse_batch(&atem, bufs, lens, 2, &index) == ATEM_STATUS_WRITE);
+		assert(atem_parse_batch(&atem, bufs, lens, 2, &index) == ATEM_STATUS_WRITE);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('T', 'E', 'S', 'T'));
+		assert(atem_parse_batch(&atem, bufs, lens, 2, &index) == ATEM_STATUS_WRITE_ONLY);
+		atem_acknowledge_response_get_verify(atem.write_buf, 0x0001, 0x0004);
+		assert(atem_parse_batch(&atem, bufs, lens, 2, &index) == ATEM_STATUS_NONE);
+		assert(index == 2);
+
+		// Ends empty batch without acknowledgement
+		index = 0;
+		assert(atem_parse_batch(&atem, bufs, lens, 0, &index) == ATEM_STATUS_NONE);
+	}
+
+	// Ensures packets ahead of sequence are held and released in order only when reorder window is enabled
+	RUN_TEST() {
+		struct atem atem = {0};
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+
+		// Receives packets 3 and 4 before packet 2
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0003);
+		atem_command_append(atem.read_buf, "THRE", "3", 1);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE_ONLY);
+		assert(atem.write_buf[ATEM_INDEX_FLAGS] == ATEM_FLAG_RETXREQ);
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0004);
+		atem_command_append(atem.read_buf, "FOUR", "4", 1);
+#if ATEM_REORDER_WINDOW
+		assert(atem_parse(&atem) == ATEM_STATUS_NONE);
+#else // ATEM_REORDER_WINDOW
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE_ONLY);
+		assert(atem.write_buf[ATEM_INDEX_FLAGS] == ATEM_FLAG_RETXREQ);
+#endif // ATEM_REORDER_WINDOW
+		assert(atem.remote_id_last == 1);
+
+		// Receives missing packet and releases held packets in order
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0002);
+		atem_command_append(atem.read_buf, "TWO_", "2", 1);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('T', 'W', 'O', '_'));
+#if ATEM_REORDER_WINDOW
+		assert(atem_parse_reordered(&atem) == ATEM_STATUS_WRITE);
+		atem_acknowledge_response_get_verify(atem.write_buf, 0x0001, 0x0003);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('T', 'H', 'R', 'E'));
+		assert(atem_parse_reordered(&atem) == ATEM_STATUS_WRITE);
+		atem_acknowledge_response_get_verify(atem.write_buf, 0x0001, 0x0004);
+		assert(atem_cmd_next(&atem) == ATEM_CMDNAME('F', 'O', 'U', 'R'));
+		assert(atem.remote_id_last == 4);
+#endif // ATEM_REORDER_WINDOW
+		assert(atem_parse_reordered(&atem) == ATEM_STATUS_NONE);
+	}
+
+#if ATEM_REORDER_WINDOW
+	// Ensures packet a full window ahead is not held since it shares slot with the missing packet
+	RUN_TEST() {
+		struct atem atem = {0};
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+
+		// Holds packets within window after requesting retransmit for the first one
+		for (uint16_t remote_id = 3; remote_id < 2 + ATEM_REORDER_WINDOW; remote_id++) {
+			atem_packet_clear(atem.read_buf);
+			atem_acknowledge_request_set(atem.read_buf, 0x0001, remote_id);
+			assert(atem_parse(&atem) == ((remote_id == 3) ? ATEM_STATUS_WRITE_ONLY : ATEM_STATUS_NONE));
+		}
+
+		// Requests retransmit for packet a full window ahead instead of holding it
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 2 + ATEM_REORDER_WINDOW);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE_ONLY);
+		assert(atem.write_buf[ATEM_INDEX_FLAGS] == ATEM_FLAG_RETXREQ);
+
+		// Releases only packets held within window when gap is filled
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0002);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		for (uint16_t remote_id = 3; remote_id < 2 + ATEM_REORDER_WINDOW; remote_id++) {
+			assert(atem_parse_reordered(&atem) == ATEM_STATUS_WRITE);
+			atem_acknowledge_response_get_verify(atem.write_buf, 0x0001, remote_id);
+		}
+		assert(atem_parse_reordered(&atem) == ATEM_STATUS_NONE);
+		assert(atem.remote_id_last == 1 + ATEM_REORDER_WINDOW);
+
+		// Accepts retransmitted packet a full window ahead in sequence
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 2 + ATEM_REORDER_WINDOW);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		assert(atem.remote_id_last == 2 + ATEM_REORDER_WINDOW);
+	}
+#endif // ATEM_REORDER_WINDOW
+
+#if ATEM_SEND_WINDOW
+	// Ensures enqueued commands are batched, only sent when connected and retransmitted until acknowledged
+	RUN_TEST() {
+		struct atem atem = {0};
+
+		// Holds commands until session id is assigned by the switcher
+		memcpy(atem_cmd_enqueue(&atem, ATEM_CMDNAME('O', 'N', 'E', '_'), 4), "\x01\x02\x03\x04", 4);
+		assert(atem_send_poll(&atem, 0) == ATEM_STATUS_NONE);
+		assert(atem_send_wait(&atem, 0) == UINT32_MAX);
+
+		// Batches commands enqueued before sending into a single packet
+		atem_acknowledge_request_set(atem.read_buf, 0x8001, 0x0001);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		memcpy(atem_cmd_enqueue(&atem, ATEM_CMDNAME('T', 'W', 'O', '_'), 2), "\x05\x06", 2);
+		assert(atem_send_wait(&atem, 0) == 0);
+		assert(atem_send_poll(&atem, 0) == ATEM_STATUS_WRITE_ONLY);
+		atem_header_flags_get_verify(atem.send_buf, ATEM_FLAG_ACKREQ, 0);
+		atem_header_len_get_verify(atem.send_buf, ATEM_LEN_HEADER + 12 + 10);
+		atem_header_sessionid_get_verify(atem.send_buf, 0x8001);
+		atem_header_ackid_get_verify(atem.send_buf, 0x0000);
+		atem_header_remoteid_get_verify(atem.send_buf, 0x0001);
+		assert(atem.send_len == ATEM_LEN_HEADER + 12 + 10);
+		assert(memcmp(&atem.send_buf[ATEM_LEN_HEADER], "\x00\x0c\x00\x00ONE_\x01\x02\x03\x04", 12) == 0);
+		assert(memcmp(&atem.send_buf[ATEM_LEN_HEADER + 12], "\x00\x0a\x00\x00TWO_\x05\x06", 10) == 0);
+		assert(atem_send_poll(&atem, 0) == ATEM_STATUS_NONE);
+
+		// Retransmits packet not acknowledged in time
+		assert(atem_send_wait(&atem, 50) == ATEM_RESEND_TIME - 50);
+		assert(atem_send_poll(&atem, ATEM_RESEND_TIME - 1) == ATEM_STATUS_NONE);
+		assert(atem_send_poll(&atem, ATEM_RESEND_TIME) == ATEM_STATUS_WRITE_ONLY);
+		atem_header_flags_get_verify(atem.send_buf, ATEM_FLAG_ACKREQ | ATEM_FLAG_RETX, 0);
+		atem_header_remoteid_get_verify(atem.send_buf, 0x0001);
+
+		// Sends commands enqueued after a packet is sent in a new packet with next id
+		assert(atem_cmd_enqueue(&atem, ATEM_CMDNAME('T', 'H', 'R', 'E'), 0) != NULL);
+		assert(atem_send_poll(&atem, ATEM_RESEND_TIME) == ATEM_STATUS_WRITE_ONLY);
+		atem_header_flags_get_verify(atem.send_buf, ATEM_FLAG_ACKREQ, 0);
+		atem_header_len_get_verify(atem.send_buf, ATEM_LEN_HEADER + 8);
+		atem_header_remoteid_get_verify(atem.send_buf, 0x0002);
+
+		// Stops retransmitting packets when acknowledged
+		atem_acknowledge_response_set(atem.read_buf, 0x8001, 0x0001);
+		assert(atem_parse(&atem) == ATEM_STATUS_NONE);
+		assert(atem_send_poll(&atem, ATEM_RESEND_TIME * 2) == ATEM_STATUS_WRITE_ONLY);
+		atem_header_remoteid_get_verify(atem.send_buf, 0x0002);
+		assert(atem_send_poll(&atem, ATEM_RESEND_TIME * 2) == ATEM_STATUS_NONE);
+		atem_acknowledge_response_set(atem.read_buf, 0x8001, 0x0002);
+		assert(atem_parse(&atem) == ATEM_STATUS_NONE);
+		assert(atem_send_wait(&atem, ATEM_RESEND_TIME * 4) == UINT32_MAX);
+	}
+
+	// Ensures commands are rejected when queue is full or command can not fit in a packet
+	RUN_TEST() {
+		struct atem atem = {0};
+		const uint16_t len_max = ATEM_SEND_PACKET_LEN - ATEM_LEN_HEADER - ATEM_LEN_CMDHEADER;
+		assert(atem_cmd_enqueue(&atem, ATEM_CMDNAME('L', 'O', 'N', 'G'), len_max + 1) == NULL);
+		for (uint16_t i = 0; i < ATEM_SEND_WINDOW; i++) {
+			assert(atem_cmd_enqueue(&atem, ATEM_CMDNAME('F', 'U', 'L', 'L'), len_max) != NULL);
+		}
+		assert(atem_cmd_enqueue(&atem, ATEM_CMDNAME('N', 'O', 'N', 'E'), 0) == NULL);
+
+		// Drops queued commands when opening a new connection
+		atem_connection_open(&atem, 0);
+		assert(atem_cmd_enqueue(&atem, ATEM_CMDNAME('N', 'E', 'X', 'T'), 0) != NULL);
+	}
+
+	// Ensures queued packets do not interfere with responses to the ATEM switcher
+	RUN_TEST() {
+		struct atem atem = {0};
+		atem_acknowledge_request_set(atem.read_buf, 0x8001, 0x0001);
+		assert(atem_parse(&atem) == ATEM_STATUS_WRITE);
+		assert(atem_cmd_enqueue(&atem, ATEM_CMDNAME('Q', 'U', 'E', 'U'), 0) != NULL);
+		assert(atem_send_poll(&atem, 0) == ATEM_STATUS_WRITE_ONLY);
+		atem_acknowledge_response_get_verify(atem.write_buf, 0x8001, 0x0001);
+
+		// Stops sending queued packets when closing connection
+		atem_connection_close(&atem);
+		assert(atem_send_wait(&atem, ATEM_RESEND_TIME) == UINT32_MAX);
+		assert(atem_send_poll(&atem, ATEM_RESEND_TIME) == ATEM_STATUS_NONE);
+		assert(atem_cmd_enqueue(&atem, ATEM_CMDNAME('L', 'A', 'T', 'E'), 0) != NULL);
+		assert(atem_send_poll(&atem, ATEM_RESEND_TIME) == ATEM_STATUS_NONE);
+		assert(atem_header_flags_get(atem.write_buf) == ATEM_FLAG_SYN);
+		assert(atem_handshake_opcode_get(atem.write_buf) == ATEM_OPCODE_CLOSING);
+
+		// Completes close when ATEM switcher responds
+		atem_packet_clear(atem.read_buf);
+		atem_handshake_sessionid_set(atem.read_buf, ATEM_OPCODE_CLOSED, false, 0x8001);
+		assert(atem_parse(&atem) == ATEM_STATUS_CLOSED);
+	}
+#endif // ATEM_SEND_WINDOW
+
+	// Ensures reconnect delay backs off exponentially with jitter and resets when connection is accepted
+	RUN_TEST() {
+		struct atem atem = {0};
+		uint32_t delay_max = ATEM_RECONNECT_DELAY_MS;
+		for (int i = 0; i < 16; i++) {
+			assert(atem_reconnect_delay(&atem, 0) == delay_max);
+			delay_max = (delay_max * 2 < ATEM_TIMEOUT_MS) ? delay_max * 2 : ATEM_TIMEOUT_MS;
+		}
+		assert(delay_max == ATEM_TIMEOUT_MS);
+		assert(atem_reconnect_delay(&atem, ATEM_TIMEOUT_MS / 2) == ATEM_TIMEOUT_MS / 2);
+		assert(atem_reconnect_delay(&atem, ATEM_TIMEOUT_MS / 2 + 1) == ATEM_TIMEOUT_MS);
+		assert(atem_reconnect_delay(&atem, UINT32_MAX) >= ATEM_TIMEOUT_MS / 2);
+
+		// Resets backoff when connection is accepted
+		atem_connection_open(&atem, 0x7832);
+		atem_packet_clear(atem.read_buf);
+		atem_handshake_sessionid_set(atem.read_buf, ATEM_OPCODE_ACCEPT, false, 0x7832);
+		assert(atem_parse(&atem) == ATEM_STATUS_ACCEPTED);
+		assert(atem_reconnect_delay(&atem, 0) == ATEM_RECONNECT_DELAY_MS);
+	}
+
+	// Ensures opening handshake proposes a random session id that is kept when retransmitting
+	RUN_TEST() {
+		struct atem atem = {0};
+		atem_connection_open(&atem, 0x12345678);
+		assert(atem.write_len == ATEM_LEN_SYN);
+		assert(atem_header_flags_get(atem.write_buf) == ATEM_FLAG_SYN);
+		assert(atem_handshake_opcode_get(atem.write_buf) == ATEM_OPCODE_OPEN);
+		const uint16_t session_id = atem_header_sessionid_get(atem.write_buf);
+		assert(session_id == ((0x1234 ^ 0x5678) & 0x7fff));
+
+		// Retransmits same session id regardless of random value
+		atem_connection_open(&atem, 0x87654321);
+		assert(atem_header_flags_get(atem.write_buf) == (ATEM_FLAG_SYN | ATEM_FLAG_RETX));
+		assert(atem_header_sessionid_get(atem.write_buf) == session_id);
+
+		// Proposes client session id without server bit for new handshake after connection is accepted
+		atem_packet_clear(atem.read_buf);
+		atem_handshake_sessionid_set(atem.read_buf, ATEM_OPCODE_ACCEPT, false, session_id);
+		assert(atem_parse(&atem) == ATEM_STATUS_ACCEPTED);
+		atem_connection_open(&atem, 0x0000ffff);
+		assert(atem_header_flags_get(atem.write_buf) == ATEM_FLAG_SYN);
+		assert(atem_header_sessionid_get(atem.write_buf) == 0x7fff);
+
+		// Never proposes session id 0 even when random value maps to it
+		atem_connection_close(&atem);
+		atem_connection_open(&atem, 0x80008000);
+		assert(atem_header_flags_get(atem.write_buf) == ATEM_FLAG_SYN);
+		assert(atem_header_sessionid_get(atem.write_buf) == 0x0001);
+		atem_connection_close(&atem);
+		atem_connection_open(&atem, 0);
+		assert(atem_header_sessionid_get(atem.write_buf) == 0x0001);
+	}
+
 	// Ensures stored remote id is incremented and reset correctly
 	RUN_TEST() {
 		struct atem atem = {0};
@@ -109,7 +829,7 @@ int main(void) {
 		}
 
 		// Ensures remote id is reset when with new connection
-		atem_connection_open(&atem);
+		atem_connection_open(&atem, 0x7832);
 		atem_packet_clear(atem.read_buf);
 		atem_handshake_sessionid_set(atem.read_buf, ATEM_OPCODE_ACCEPT, false, 0x7832);
 		assert(atem_parse(&atem) == ATEM_STATUS_ACCEPTED);
@@ -0,0 +1,223 @@
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, uint64_t
+#include <stdbool.h> // true
+#include <stddef.h> // size_t
+#include <stdio.h> // printf, fprintf, stderr
+#include <stdlib.h> // getenv, atoi, abort
+#include <string.h> // memset, strcmp
+#include <time.h> // clock_gettime, CLOCK_MONOTONIC, struct timespec
+
+#include "../utils/utils.h"
+
+// Reads time stamp counter for cycle counts on x86
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // __rdtsc
+#define BENCH_CYCLES() __rdtsc()
+#else // __x86_64__ || __i386__
+#define BENCH_CYCLES() 0
+#endif // __x86_64__ || __i386__
+
+// Number of packets in each recorded traffic pattern
+#define BENCH_PACKETS 256
+
+// Default number of milliseconds to run each benchmark for
+#define BENCH_TIME_MS 500
+
+// Traffic pattern to replay through the parser
+struct bench_corpus {
+	const char* name;
+	uint16_t count;
+	uint8_t packets[BENCH_PACKETS][ATEM_PACKET_LEN_MAX];
+};
+
+// Commands in the initial state dump with their payload lengths
+static const struct {
+	char* name;
+	uint16_t len;
+} bench_state_cmds[] = {
+	{ "_ver", 4 }, { "_pin", 44 }, { "_top", 20 }, { "_MeC", 4 }, { "_mpl", 4 },
+	{ "_MvC", 4 }, { "InPr", 36 }, { "PrgI", 4 }, { "PrvI", 8 }, { "TlIn", 42 },
+	{ "CCdP", 24 }, { "AMIP", 56 }, { "KeOn", 4 }, { "TrSS", 12 }, { "AuxS", 4 }
+};
+
+// Sets payload of commands in the corpus to valid data for the command
+static void bench_payload_set(uint8_t* payload, const char* name, uint16_t len, uint32_t seed) {
+	memset(payload, 0, len);
+	if (!strcmp(name, "_ver")) {
+		payload[1] = 2;
+		payload[3] = 30;
+	}
+	else if (!strcmp(name, "TlIn")) {
+		payload[1] = (uint8_t)(len - 2);
+		for (uint16_t i = 2; i < len; i++) {
+			payload[i] = (uint8_t)((seed + i) % 4);
+		}
+	}
+	else if (!strcmp(name, "CCdP")) {
+		// Sets 4 int16 values for camera id 1 or 2
+		payload[0] = (uint8_t)(1 + seed % 2);
+		payload[1] = 0x08;
+		payload[2] = 0x04;
+		payload[3] = 0x80;
+		payload[7] = 0x04;
+		for (uint8_t i = 0; i < 8; i++) {
+			payload[16 + i] = (uint8_t)(seed + i);
+		}
+	}
+}
+
+// Appends a command with valid payload to packet in corpus
+static void bench_command_append(uint8_t* packet, char* name, uint16_t len, uint32_t seed) {
+	uint8_t payload[64];
+	bench_payload_set(payload, name, len, seed);
+	atem_command_append(packet, name, payload, len);
+}
+
+// Initial state dump filling packets up to the soft packet length limit
+static void bench_corpus_state(struct bench_corpus* corpus) {
+	corpus->name = "state_dump";
+	corpus->count = BENCH_PACKETS;
+	uint32_t cmd = 0;
+	for (uint16_t i = 0; i < corpus->count; i++) {
+		uint8_t* packet = corpus->packets[i];
+		atem_acknowledge_request_set(packet, 0x8001, (uint16_t)(i + 1));
+		while (true) {
+			const size_t index = cmd % (sizeof(bench_state_cmds) / sizeof(bench_state_cmds[0]));
+			const uint16_t len = bench_state_cmds[index].len;
+			if (atem_header_len_get(packet) + ATEM_LEN_CMDHEADER + len > ATEM_PACKET_LEN_MAX_SOFT) break;
+			bench_command_append(packet, bench_state_cmds[index].name, len, cmd);
+			cmd++;
+		}
+	}
+}
+
+// Steady state pings without any commands
+static void bench_corpus_ping(struct bench_corpus* corpus) {
+	corpus->name = "ping";
+	corpus->count = BENCH_PACKETS;
+	for (uint16_t i = 0; i < corpus->count; i++) {
+		atem_acknowledge_request_set(corpus->packets[i], 0x8001, (uint16_t)(i + 1));
+	}
+}
+
+// Tally updates for 40 inputs on every packet
+static void bench_corpus_tally(struct bench_corpus* corpus) {
+	corpus->name = "tally_storm";
+	corpus->count = BENCH_PACKETS;
+	for (uint16_t i = 0; i < corpus->count; i++) {
+		atem_acknowledge_request_set(corpus->packets[i], 0x8001, (uint16_t)(i + 1));
+		bench_command_append(corpus->packets[i], "TlIn", 42, i);
+	}
+}
+
+// Camera control bursts with multiple parameter updates in every packet
+static void bench_corpus_cc(struct bench_corpus* corpus) {
+	corpus->name = "cc_burst";
+	corpus->count = BENCH_PACKETS;
+	for (uint16_t i = 0; i < corpus->count; i++) {
+		atem_acknowledge_request_set(corpus->packets[i], 0x8001, (uint16_t)(i + 1));
+		for (uint16_t j = 0; j < 16; j++) {
+			bench_command_append(corpus->packets[i], "CCdP", 24, (uint32_t)(i * 16 + j));
+		}
+	}
+}
+
+// Parses and processes all packets in corpus the same way the firmware does
+static uint32_t bench_replay(struct atem* atem, struct bench_corpus* corpus, uint8_t* sdi_buf) {
+	uint32_t cmds = 0;
+	atem->remote_id_last = 0;
+	for (uint16_t i = 0; i < corpus->count; i++) {
+		uint8_t* packet = corpus->packets[i];
+		if (atem_parse_buf(atem, packet, atem_header_len_get(packet)) != ATEM_STATUS_WRITE) {
+			fprintf(stderr, "Failed to parse packet %d in %s\n", i, corpus->name);
+			abort();
+		}
+		while (atem_cmd_available(atem)) {
+			cmds++;
+			switch (atem_cmd_next(atem)) {
+				case ATEM_CMDNAME_VERSION: {
+					sdi_buf[0] ^= (uint8_t)atem_protocol_minor(atem);
+					break;
+				}
+				case ATEM_CMDNAME_TALLY: {
+					sdi_buf[1] ^= (uint8_t)atem_tally_updated(atem);
+					break;
+				}
+				case ATEM_CMDNAME_CAMERACONTROL: {
+					if (!atem_cc_updated(atem)) break;
+					sdi_buf[2] ^= (uint8_t)atem_cc_translate_buf(atem, &sdi_buf[4], 252);
+					break;
+				}
+			}
+		}
+	}
+	return cmds;
+}
+
+// Gets nanoseconds from monotonic clock
+static uint64_t bench_time_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// Command filter for the commands processed by the firmware
+#define BENCH_FILTER (\
+	ATEM_CMD_FILTER_BIT(ATEM_CMDNAME_VERSION) |\
+	ATEM_CMD_FILTER_BIT(ATEM_CMDNAME_TALLY) |\
+	ATEM_CMD_FILTER_BIT(ATEM_CMDNAME_CAMERACONTROL)\
+)
+
+// Replays corpus for a fixed amount of time with command filter and prints throughput
+static void bench_run(struct bench_corpus* corpus, uint32_t time_ms, uint32_t filter) {
+	struct atem atem = {0};
+	atem.dest = 1;
+	atem.cmd_filter = filter;
+	static uint8_t sdi_buf[256];
+
+	// Warms up caches before measuring
+	bench_replay(&atem, corpus, sdi_buf);
+
+	uint64_t packets = 0;
+	uint64_t cmds = 0;
+	const uint64_t time_start = bench_time_ns();
+	const uint64_t cycles_start = BENCH_CYCLES();
+	uint64_t time_elapsed;
+	do {
+		cmds += bench_replay(&atem, corpus, sdi_buf);
+		packets += corpus->count;
+		time_elapsed = bench_time_ns() - time_start;
+	} while (time_elapsed < (uint64_t)time_ms * 1000000);
+	const uint64_t cycles = BENCH_CYCLES() - cycles_start;
+
+	printf(
+		"%-12s %-7s %12.0f packets/s %10.2f ns/command %10.1f cycles/packet\n",
+		corpus->name,
+		(filter != 0) ? "+filter" : "",
+		(double)packets * 1e9 / (double)time_elapsed,
+		(cmds > 0) ? (double)time_elapsed / (double)cmds : 0.0,
+		(double)cycles / (double)packets
+	);
+}
+
+int main(void) {
+	// Gets time to run each benchmark for from environment variable
+	uint32_t time_ms = BENCH_TIME_MS;
+	const char* env_time = getenv("BENCH_TIME_MS");
+	if (env_time != NULL && atoi(env_time) > 0) {
+		time_ms = (uint32_t)atoi(env_time);
+	}
+
+	// Runs benchmarks for every traffic pattern with and without command filter
+	static struct bench_corpus corpus;
+	void (*const corpus_inits[])(struct bench_corpus*) = {
+		bench_corpus_state, bench_corpus_ping, bench_corpus_tally, bench_corpus_cc
+	};
+	for (size_t i = 0; i < sizeof(corpus_inits) / sizeof(corpus_inits[0]); i++) {
+		memset(&corpus, 0, sizeof(corpus));
+		corpus_inits[i](&corpus);
+		bench_run(&corpus, time_ms, 0);
+		bench_run(&corpus, time_ms, BENCH_FILTER);
+	}
+
+	return 0;
+}
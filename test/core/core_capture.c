@@ -0,0 +1,115 @@
+#include <assert.h> // assert
+#include <stdint.h> // uint8_t, uint16_t, uint64_t
+#include <stdbool.h> // true, false
+#include <stddef.h> // NULL, size_t
+#include <stdio.h> // FILE, fopen, fwrite, fclose, remove
+#include <string.h> // memcmp
+
+#include <arpa/inet.h> // htonl, htons
+#include <netinet/in.h> // INADDR_LOOPBACK, struct sockaddr_in
+#include <sys/socket.h> // socklen_t, struct sockaddr, recvfrom, sendto
+#include <unistd.h> // close
+
+#include "../utils/utils.h"
+#include "../../core/atem_capture.h" // struct atem_capture_record, atem_capture_open, atem_capture_write, atem_capture_load, atem_capture_read, ATEM_CAPTURE_ROLE_CLIENT, ATEM_CAPTURE_ROLE_SERVER, ATEM_CAPTURE_DIR_SEND, ATEM_CAPTURE_DIR_RECV
+
+// Path of capture file used by tests
+#define CAPTURE_PATH "/tmp/core_capture.atem"
+
+int main(void) {
+	// Ensures records are read back in order with their direction, peer and datagram
+	RUN_TEST() {
+		FILE* file = atem_capture_open(CAPTURE_PATH, ATEM_CAPTURE_ROLE_SERVER);
+		assert(file != NULL);
+		struct sockaddr_in peer = { .sin_family = AF_INET, .sin_port = htons(50000), .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+		const uint8_t sent[] = { 0x08, 0x0c, 0x80, 0x01, 0, 0, 0, 0, 0, 0, 0, 1 };
+		const uint8_t recved[ATEM_PACKET_LEN_MAX] = { 0x8f, 0xff };
+		assert(atem_capture_write(file, ATEM_CAPTURE_DIR_SEND, &peer, sent, sizeof(sent)));
+		assert(atem_capture_write(file, ATEM_CAPTURE_DIR_RECV, NULL, recved, sizeof(recved)));
+		assert(fclose(file) == 0);
+
+		enum atem_capture_role role;
+		file = atem_capture_load(CAPTURE_PATH, &role);
+		assert(file != NULL);
+		assert(role == ATEM_CAPTURE_ROLE_SERVER);
+
+		static struct atem_capture_record record;
+		assert(atem_capture_read(file, &record));
+		assert(record.dir == ATEM_CAPTURE_DIR_SEND);
+		assert(record.peer.sin_addr.s_addr == peer.sin_addr.s_addr);
+		assert(record.peer.sin_port == peer.sin_port);
+		assert(record.len == sizeof(sent));
+		assert(!memcmp(record.buf, sent, sizeof(sent)));
+		const uint64_t time_first = record.time;
+
+		assert(atem_capture_read(file, &record));
+		assert(record.dir == ATEM_CAPTURE_DIR_RECV);
+		assert(record.peer.sin_addr.s_addr == 0);
+		assert(record.peer.sin_port == 0);
+		assert(record.len == sizeof(recved));
+		assert(!memcmp(record.buf, recved, sizeof(recved)));
+		assert(record.time >= time_first);
+
+		assert(!atem_capture_read(file, &record));
+		fclose(file);
+		remove(CAPTURE_PATH);
+	}
+
+	// Ensures files without a valid capture header are rejected
+	RUN_TEST() {
+		FILE* file = fopen(CAPTURE_PATH, "wb");
+		assert(file != NULL);
+		assert(fwrite("PCAP\x01\x00\x00\x00", 8, 1, file) == 1);
+		fclose(file);
+
+		enum atem_capture_role role;
+		assert(atem_capture_load(CAPTURE_PATH, &role) == NULL);
+		remove(CAPTURE_PATH);
+	}
+
+	// Ensures POSIX client records packets sent and received while capturing
+	RUN_TEST() {
+		int server_sock = atem_socket_create();
+		simple_socket_listen(server_sock, ATEM_PORT);
+
+		struct atem_posix_ctx ctx;
+		assert(atem_init(&ctx, htonl(INADDR_LOOPBACK)));
+		ctx.capture = atem_capture_open(CAPTURE_PATH, ATEM_CAPTURE_ROLE_CLIENT);
+		assert(ctx.capture != NULL);
+		assert(atem_send(&ctx));
+
+		// Accepts opening handshake
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		struct sockaddr_in addr;
+		socklen_t addr_len = sizeof(addr);
+		assert(recvfrom(server_sock, packet, sizeof(packet), 0, (struct sockaddr*)&addr, &addr_len) == ATEM_LEN_SYN);
+		const uint16_t session_id = atem_handshake_sessionid_get(packet, ATEM_OPCODE_OPEN, false);
+		atem_packet_clear(packet);
+		atem_handshake_sessionid_set(packet, ATEM_OPCODE_ACCEPT, false, session_id);
+		atem_handshake_newsessionid_set(packet, 0x0001);
+		assert(sendto(server_sock, packet, ATEM_LEN_SYN, 0, (struct sockaddr*)&addr, addr_len) == ATEM_LEN_SYN);
+		assert(atem_poll(&ctx) == ATEM_POSIX_STATUS_ACCEPTED);
+		assert(fclose(ctx.capture) == 0);
+
+		// Verifies opening handshake, accept and its acknowledgement were recorded in order
+		enum atem_capture_role role;
+		FILE* file = atem_capture_load(CAPTURE_PATH, &role);
+		assert(file != NULL);
+		assert(role == ATEM_CAPTURE_ROLE_CLIENT);
+		static struct atem_capture_record record;
+		const enum atem_capture_dir dirs[] = { ATEM_CAPTURE_DIR_SEND, ATEM_CAPTURE_DIR_RECV, ATEM_CAPTURE_DIR_SEND };
+		for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+			assert(atem_capture_read(file, &record));
+			assert(record.dir == dirs[i]);
+		}
+		assert(atem_header_flags_get(record.buf) & ATEM_FLAG_ACK);
+		assert(!atem_capture_read(file, &record));
+		fclose(file);
+		remove(CAPTURE_PATH);
+
+		close(ctx.sock);
+		atem_socket_close(server_sock);
+	}
+
+	return runner_exit();
+}
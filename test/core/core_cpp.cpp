@@ -0,0 +1,154 @@
+#include <cassert> // assert
+#include <cerrno> // EFAULT
+#include <cstdint> // uint8_t, uint16_t, uint32_t
+#include <cstring> // memcpy, memset
+#include <system_error> // std::system_error
+
+#include <arpa/inet.h> // htonl, htons
+#include <fcntl.h> // fcntl, F_GETFD
+#include <netinet/in.h> // INADDR_LOOPBACK, INADDR_ANY, in_addr_t, struct sockaddr_in
+#include <sys/socket.h> // socket, bind, recv, AF_INET, SOCK_DGRAM, struct sockaddr
+#include <unistd.h> // close
+
+extern "C" {
+#include "../utils/runner.h" // RUN_TEST, runner_exit
+}
+#include "../../core/atem_protocol.h" // ATEM_LEN_HEADER, ATEM_LEN_CMDHEADER, ATEM_LEN_SYN, ATEM_FLAG_ACKREQ, ATEM_MASK_LEN_HIGH, ATEM_INDEX_FLAGS, ATEM_INDEX_LEN_HIGH, ATEM_INDEX_LEN_LOW, ATEM_INDEX_SESSIONID_HIGH, ATEM_INDEX_SESSIONID_LOW, ATEM_INDEX_REMOTEID_LOW, ATEM_INDEX_OPCODE, ATEM_OPCODE_OPEN
+#include "../../core/atem.hpp" // waccat::payload, waccat::command, waccat::dispatcher, ATEM_CMDNAME, ATEM_CMD_FILTER_BIT, ATEM_PORT, ATEM_PACKET_LEN_MAX
+#include "../../core/atem_posix.hpp" // waccat::posix_connection
+
+// Records last command dispatched to test handlers
+static uint8_t* dispatch_buf;
+static uint16_t dispatch_len;
+static int dispatch_handler;
+
+// Test handlers for command dispatch
+static void dispatch_test_a(struct atem& atem, waccat::payload payload) {
+	assert(payload.data() == atem.cmd_payload_buf);
+	dispatch_buf = payload.data();
+	dispatch_len = payload.size();
+	dispatch_handler = 1;
+}
+static void dispatch_test_b(struct atem&, waccat::payload payload) {
+	dispatch_buf = payload.data();
+	dispatch_len = payload.size();
+	dispatch_handler = 2;
+}
+
+// Test command registry
+using dispatch_test = waccat::dispatcher<
+	waccat::command<ATEM_CMDNAME('A', 'A', 'A', 'A'), 0, dispatch_test_a>,
+	waccat::command<ATEM_CMDNAME('B', 'B', 'B', 'B'), 4, dispatch_test_b>
+>;
+
+// Appends command to packet and updates packet length
+static void packet_command_append(uint8_t* packet, const char* name, const char* payload, uint16_t len) {
+	const uint16_t packet_len = static_cast<uint16_t>((packet[ATEM_INDEX_LEN_HIGH] & ATEM_MASK_LEN_HIGH) << 8 | packet[ATEM_INDEX_LEN_LOW]);
+	const uint16_t cmd_len = static_cast<uint16_t>(ATEM_LEN_CMDHEADER + len);
+	uint8_t* cmd = packet + packet_len;
+	memset(cmd, 0, ATEM_LEN_CMDHEADER);
+	cmd[0] = static_cast<uint8_t>(cmd_len >> 8);
+	cmd[1] = static_cast<uint8_t>(cmd_len & 0xff);
+	memcpy(cmd + 4, name, 4);
+	memcpy(cmd + ATEM_LEN_CMDHEADER, payload, len);
+	packet[ATEM_INDEX_FLAGS] = static_cast<uint8_t>(((packet_len + cmd_len) >> 8) | ATEM_FLAG_ACKREQ);
+	packet[ATEM_INDEX_LEN_LOW] = static_cast<uint8_t>((packet_len + cmd_len) & 0xff);
+}
+
+int main(void) {
+	// Ensures payload view reads directly from the packet
+	RUN_TEST() {
+		uint8_t buf[] = { 0x12, 0x34, 0x56, 0x78 };
+		constexpr waccat::payload empty(nullptr, 0);
+		static_assert(empty.empty());
+		waccat::payload payload(buf, sizeof(buf));
+		assert(payload.size() == 4);
+		assert(payload.u16(0) == 0x1234);
+		assert(payload.u32(0) == 0x12345678);
+		uint32_t sum = 0;
+		for (uint8_t byte : payload) {
+			sum += byte;
+		}
+		assert(sum == 0x12 + 0x34 + 0x56 + 0x78);
+		payload[0] = 0;
+		assert(buf[0] == 0);
+	}
+
+	// Ensures commands are dispatched to registered handlers only with required payload length
+	RUN_TEST() {
+		struct atem atem = {};
+		uint8_t packet[ATEM_PACKET_LEN_MAX] = {};
+		packet[ATEM_INDEX_LEN_LOW] = ATEM_LEN_HEADER;
+		packet[ATEM_INDEX_SESSIONID_HIGH] = 0x80;
+		packet[ATEM_INDEX_SESSIONID_LOW] = 0x01;
+		packet[ATEM_INDEX_REMOTEID_LOW] = 0x01;
+		packet_command_append(packet, "AAAA", "a", 1);
+		packet_command_append(packet, "CCCC", "cccc", 4);
+		packet_command_append(packet, "BBBB", "bbb", 3);
+		packet_command_append(packet, "BBBB", "bbbb", 4);
+		const uint16_t len = static_cast<uint16_t>((packet[ATEM_INDEX_LEN_HIGH] & ATEM_MASK_LEN_HIGH) << 8 | packet[ATEM_INDEX_LEN_LOW]);
+		assert(atem_parse_buf(&atem, packet, len) == ATEM_STATUS_WRITE);
+
+		const int handlers_expected[] = { 1, 0, 0, 2 };
+		for (int expected : handlers_expected) {
+			dispatch_handler = 0;
+			const uint32_t name = atem_cmd_next(&atem);
+			assert(dispatch_test::dispatch(name, atem, waccat::payload(atem)) == (expected != 0));
+			assert(dispatch_handler == expected);
+			if (expected != 0) {
+				assert(dispatch_buf == atem.cmd_payload_buf);
+				assert(dispatch_len == atem.cmd_payload_len);
+			}
+		}
+		assert(!atem_cmd_available(&atem));
+
+		// Only iterates registered commands with filter and dispatches last command
+		static_assert(dispatch_test::filter == (ATEM_CMD_FILTER_BIT(ATEM_CMDNAME('A', 'A', 'A', 'A')) | ATEM_CMD_FILTER_BIT(ATEM_CMDNAME('B', 'B', 'B', 'B'))));
+		packet[ATEM_INDEX_REMOTEID_LOW] = 0x02;
+		atem.cmd_filter = dispatch_test::filter;
+		assert(atem_parse_buf(&atem, packet, len) == ATEM_STATUS_WRITE);
+		dispatch_handler = 0;
+		dispatch_test::process(atem);
+		assert(dispatch_handler == 2);
+		assert(dispatch_len == 4);
+		assert(!atem_cmd_available(&atem));
+	}
+
+	// Ensures connection sends opening handshake and owns its socket
+	RUN_TEST() {
+		int server_sock = socket(AF_INET, SOCK_DGRAM, 0);
+		assert(server_sock != -1);
+		struct sockaddr_in server_addr = {};
+		server_addr.sin_family = AF_INET;
+		server_addr.sin_port = htons(ATEM_PORT);
+		server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+		assert(bind(server_sock, reinterpret_cast<struct sockaddr*>(&server_addr), sizeof(server_addr)) == 0);
+
+		int fd;
+		{
+			waccat::posix_connection connection(htonl(INADDR_LOOPBACK));
+			fd = connection.fd();
+			assert(fcntl(fd, F_GETFD) != -1);
+			uint8_t packet[ATEM_PACKET_LEN_MAX];
+			assert(recv(server_sock, packet, sizeof(packet), 0) == ATEM_LEN_SYN);
+			assert(packet[ATEM_INDEX_OPCODE] == ATEM_OPCODE_OPEN);
+			assert(connection.deadline_reached() == ATEM_POSIX_STATUS_NONE);
+		}
+		assert(fcntl(fd, F_GETFD) == -1);
+		close(server_sock);
+	}
+
+	// Ensures invalid address is reported as an exception
+	RUN_TEST() {
+		bool thrown = false;
+		try {
+			waccat::posix_connection connection(static_cast<in_addr_t>(-1));
+		}
+		catch (const std::system_error& err) {
+			thrown = err.code().value() == EFAULT;
+		}
+		assert(thrown);
+	}
+
+	return runner_exit();
+}
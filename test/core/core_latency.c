@@ -0,0 +1,126 @@
+#include <assert.h> // assert
+#include <stdint.h> // uint8_t, uint64_t
+#include <stdbool.h> // true, false
+#include <stddef.h> // size_t
+#include <string.h> // memset
+
+#include <arpa/inet.h> // htonl
+#include <netinet/in.h> // INADDR_LOOPBACK, struct sockaddr_in
+#include <sys/socket.h> // socklen_t, struct sockaddr, struct msghdr, recvmsg, recvfrom, sendto
+#include <sys/uio.h> // struct iovec
+#include <unistd.h> // close
+
+#include "../utils/utils.h"
+#include "../../core/atem_latency.h" // struct atem_latency_histogram, atem_latency_enable, atem_latency_now, atem_latency_recv_time, atem_latency_record, atem_latency_percentile, ATEM_LATENCY_BUCKETS, ATEM_LATENCY_CONTROL_LEN
+
+int main(void) {
+	// Ensures latencies are recorded in power of two microsecond buckets
+	RUN_TEST() {
+		struct atem_latency_histogram histogram;
+		memset(&histogram, 0, sizeof(histogram));
+		assert(atem_latency_percentile(&histogram, 50) == 0);
+
+		atem_latency_record(&histogram, 1000, 1500);
+		atem_latency_record(&histogram, 0, 1000);
+		atem_latency_record(&histogram, 0, 3999);
+		atem_latency_record(&histogram, 0, 4000);
+		atem_latency_record(&histogram, 2000, 1000);
+		assert(histogram.count == 5);
+		assert(histogram.max == 4000);
+		assert(histogram.buckets[0] == 2);
+		assert(histogram.buckets[1] == 1);
+		assert(histogram.buckets[2] == 1);
+		assert(histogram.buckets[3] == 1);
+		assert(atem_latency_percentile(&histogram, 0) == 1);
+		assert(atem_latency_percentile(&histogram, 40) == 1);
+		assert(atem_latency_percentile(&histogram, 60) == 2);
+		assert(atem_latency_percentile(&histogram, 80) == 4);
+		assert(atem_latency_percentile(&histogram, 100) == 8);
+
+		// Latencies too large for other buckets are reported with largest recorded latency
+		atem_latency_record(&histogram, 0, (uint64_t)10 * 1000 * 1000 * 1000);
+		assert(histogram.buckets[ATEM_LATENCY_BUCKETS - 1] == 1);
+		assert(atem_latency_percentile(&histogram, 100) == (uint64_t)10 * 1000 * 1000);
+	}
+
+	// Ensures received datagrams are timestamped between being sent and being read
+	RUN_TEST() {
+		int server_sock = atem_socket_create();
+		simple_socket_listen(server_sock, ATEM_PORT);
+#ifdef __linux__
+		assert(atem_latency_enable(server_sock));
+#else // __linux__
+		atem_latency_enable(server_sock);
+#endif // __linux__
+
+		int client_sock = atem_socket_create();
+		simple_socket_connect(client_sock, ATEM_PORT, htonl(INADDR_LOOPBACK));
+		const uint64_t sent_time = atem_latency_now();
+		const uint8_t buf[ATEM_LEN_HEADER] = { 0 };
+		simple_socket_send(client_sock, buf, sizeof(buf));
+
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		struct iovec iov = { .iov_base = packet, .iov_len = sizeof(packet) };
+		union {
+			size_t align;
+			uint8_t buf[ATEM_LATENCY_CONTROL_LEN];
+		} control;
+		struct msghdr msg = {
+			.msg_iov = &iov,
+			.msg_iovlen = 1,
+			.msg_control = control.buf,
+			.msg_controllen = sizeof(control.buf)
+		};
+		assert(recvmsg(server_sock, &msg, 0) == ATEM_LEN_HEADER);
+		const uint64_t read_time = atem_latency_now();
+		const uint64_t recv_time = atem_latency_recv_time(&msg);
+		assert(recv_time >= sent_time);
+		assert(recv_time <= read_time);
+
+		close(client_sock);
+		atem_socket_close(server_sock);
+	}
+
+	// Ensures POSIX client records latency from receiving a packet until it is acknowledged
+	RUN_TEST() {
+		int server_sock = atem_socket_create();
+		simple_socket_listen(server_sock, ATEM_PORT);
+
+		struct atem_posix_ctx ctx;
+		assert(atem_init(&ctx, htonl(INADDR_LOOPBACK)));
+		assert(ctx.latency.recv_to_parse.count == 0);
+		assert(ctx.latency.parse_to_send.count == 0);
+#ifdef __linux__
+		assert(ctx.latency.kernel);
+#endif // __linux__
+		assert(atem_send(&ctx));
+		assert(ctx.latency.parse_to_send.count == 0);
+
+		// Accepts opening handshake
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		struct sockaddr_in addr;
+		socklen_t addr_len = sizeof(addr);
+		assert(recvfrom(server_sock, packet, sizeof(packet), 0, (struct sockaddr*)&addr, &addr_len) == ATEM_LEN_SYN);
+		const uint16_t session_id = atem_handshake_sessionid_get(packet, ATEM_OPCODE_OPEN, false);
+		atem_packet_clear(packet);
+		atem_handshake_sessionid_set(packet, ATEM_OPCODE_ACCEPT, false, session_id);
+		atem_handshake_newsessionid_set(packet, 0x0001);
+		assert(sendto(server_sock, packet, ATEM_LEN_SYN, 0, (struct sockaddr*)&addr, addr_len) == ATEM_LEN_SYN);
+		assert(atem_poll(&ctx) == ATEM_POSIX_STATUS_ACCEPTED);
+
+		// Verifies both latencies were recorded once for the acknowledged accept
+		assert(ctx.latency.recv_to_parse.count == 1);
+		assert(ctx.latency.parse_to_send.count == 1);
+		assert(ctx.latency.parse_time == 0);
+		assert(atem_latency_percentile(&ctx.latency.recv_to_parse, 100) > 0);
+
+		// Verifies sending without a packet waiting for acknowledgement records nothing
+		assert(atem_send(&ctx));
+		assert(ctx.latency.parse_to_send.count == 1);
+
+		close(ctx.sock);
+		atem_socket_close(server_sock);
+	}
+
+	return runner_exit();
+}
@@ -0,0 +1,101 @@
+#include <assert.h> // assert
+#include <stdint.h> // uint8_t, uint16_t
+
+#include "../utils/utils.h"
+
+int main(void) {
+	// Ensures silent connection is dropped after liveness timeout instead of full ATEM timeout
+	RUN_TEST() {
+		struct atem_posix_ctx posix_client;
+		int server_sock = atem_posix_client_connect(&posix_client);
+		struct timespec timeout_start = timediff_mark();
+		atem_posix_client_handshake(server_sock, &posix_client);
+
+		assert(atem_poll(&posix_client) == ATEM_POSIX_STATUS_DROPPED);
+		timediff_get_verify(timeout_start, ATEM_LIVENESS_TIMEOUT_MS, ATEM_TIMEOUT_MS - ATEM_LIVENESS_TIMEOUT_MS - 1);
+
+		// Ensures client reconnects with opening handshake after being dropped
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		assert(atem_send(&posix_client));
+		atem_socket_recv(server_sock, packet);
+		atem_handshake_opcode_get_verify(packet, ATEM_OPCODE_OPEN);
+
+		atem_socket_close(server_sock);
+		atem_socket_close(posix_client.sock);
+	}
+
+	// Ensures liveness timeout restarts for every received packet
+	RUN_TEST() {
+		struct atem_posix_ctx posix_client;
+		int server_sock = atem_posix_client_connect(&posix_client);
+		uint16_t session_id = atem_posix_client_handshake(server_sock, &posix_client);
+
+		// Pings client before liveness timeout is reached
+		assert(simple_socket_poll(server_sock, ATEM_LIVENESS_TIMEOUT_MS / 2) == 0);
+		struct timespec timeout_start = timediff_mark();
+		atem_acknowledge_request_send(server_sock, session_id, 0x0001);
+		assert(atem_poll(&posix_client) != ATEM_POSIX_STATUS_DROPPED);
+		atem_acknowledge_response_recv_verify(server_sock, session_id, 0x0001);
+
+		assert(atem_poll(&posix_client) == ATEM_POSIX_STATUS_DROPPED);
+		timediff_get_verify(timeout_start, ATEM_LIVENESS_TIMEOUT_MS, ATEM_LIVENESS_TIMEOUT_MS / 2);
+
+		atem_socket_close(server_sock);
+		atem_socket_close(posix_client.sock);
+	}
+
+	// Ensures non-blocking read returns immediately without data and moves deadline forward when receiving
+	RUN_TEST() {
+		struct atem_posix_ctx posix_client;
+		int server_sock = atem_posix_client_connect(&posix_client);
+		uint16_t session_id = atem_posix_client_handshake(server_sock, &posix_client);
+
+		// Reads empty socket without blocking or moving deadline
+		const uint32_t deadline = atem_posix_deadline(&posix_client);
+		assert((int32_t)(deadline - atem_posix_now()) > 0);
+		struct timespec read_start = timediff_mark();
+		assert(atem_posix_readable(&posix_client) == ATEM_POSIX_STATUS_NONE);
+		timediff_get_verify(read_start, 0, TIMEDIFF_LATE);
+		assert(atem_posix_deadline_reached(&posix_client) == ATEM_POSIX_STATUS_NONE);
+		assert(atem_posix_deadline(&posix_client) == deadline);
+
+		// Moves deadline forward by the time waited before receiving a packet
+		assert(simple_socket_poll(server_sock, ATEM_LIVENESS_TIMEOUT_MS / 2) == 0);
+		atem_acknowledge_request_send(server_sock, session_id, 0x0001);
+		assert(simple_socket_poll(posix_client.sock, 1000) == 1);
+		assert(atem_posix_readable(&posix_client) == ATEM_POSIX_STATUS_WRITE);
+		atem_acknowledge_response_recv_verify(server_sock, session_id, 0x0001);
+		assert(atem_posix_readable(&posix_client) == ATEM_POSIX_STATUS_NONE);
+		assert((int32_t)(atem_posix_deadline(&posix_client) - deadline) >= ATEM_LIVENESS_TIMEOUT_MS / 2);
+
+		atem_socket_close(server_sock);
+		atem_socket_close(posix_client.sock);
+	}
+
+	// Ensures deadline handler reports dropped connection once deadline has passed and reconnects after it
+	RUN_TEST() {
+		struct atem_posix_ctx posix_client;
+		int server_sock = atem_posix_client_connect(&posix_client);
+		atem_posix_client_handshake(server_sock, &posix_client);
+
+		// Waits past deadline without receiving anything from external event loop
+		const int32_t wait = (int32_t)(atem_posix_deadline(&posix_client) - atem_posix_now());
+		assert(wait > 0);
+		assert(simple_socket_poll(posix_client.sock, wait + 1) == 0);
+		assert(atem_posix_readable(&posix_client) == ATEM_POSIX_STATUS_NONE);
+		assert(atem_posix_deadline_reached(&posix_client) == ATEM_POSIX_STATUS_DROPPED);
+
+		// Ensures new deadline is for reconnecting and client reconnects with opening handshake
+		assert((int32_t)(atem_posix_deadline(&posix_client) - atem_posix_now()) > 0);
+		assert(atem_posix_deadline_reached(&posix_client) == ATEM_POSIX_STATUS_NONE);
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		assert(atem_send(&posix_client));
+		atem_socket_recv(server_sock, packet);
+		atem_handshake_opcode_get_verify(packet, ATEM_OPCODE_OPEN);
+
+		atem_socket_close(server_sock);
+		atem_socket_close(posix_client.sock);
+	}
+
+	return runner_exit();
+}
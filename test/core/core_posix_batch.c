@@ -0,0 +1,99 @@
+#include <assert.h> // assert
+#include <stdint.h> // uint8_t, uint16_t, uint32_t
+
+#include "../utils/utils.h"
+
+// Reads all received packets without blocking and returns number of commands iterated
+static int batch_read(struct atem_posix_ctx* posix_client) {
+	int cmds = 0;
+	enum atem_posix_status status;
+	while ((status = atem_posix_readable(posix_client)) != ATEM_POSIX_STATUS_NONE) {
+		assert(status == ATEM_POSIX_STATUS_WRITE || status == ATEM_POSIX_STATUS_WRITE_ONLY);
+		while (atem_cmd_available(&posix_client->atem)) {
+			assert(atem_cmd_next(&posix_client->atem) == ATEM_CMDNAME('T', 'e', 's', 't'));
+			cmds++;
+		}
+	}
+	return cmds;
+}
+
+int main(void) {
+	// Ensures all packets received at once are parsed and acknowledged with a single acknowledgement
+	RUN_TEST() {
+		struct atem_posix_ctx posix_client;
+		int server_sock = atem_posix_client_connect(&posix_client);
+		uint16_t session_id = atem_posix_client_handshake(server_sock, &posix_client);
+
+		// Sends multiple packets before client reads any of them
+		uint8_t payload[4] = {0};
+		for (uint16_t remote_id = 1; remote_id <= 3; remote_id++) {
+			atem_command_send(server_sock, session_id, remote_id, "Test", payload, sizeof(payload));
+		}
+		assert(simple_socket_poll(posix_client.sock, 1000) == 1);
+		assert(batch_read(&posix_client) == 3);
+
+		// Expects only cumulative acknowledgement for last packet
+		atem_acknowledge_response_recv_verify(server_sock, session_id, 0x0003);
+		assert(simple_socket_poll(server_sock, 100) == 0);
+
+		atem_socket_close(server_sock);
+		atem_socket_close(posix_client.sock);
+	}
+
+	// Ensures blocking iteration finishes a batch and sends its acknowledgement without waiting for more packets
+	RUN_TEST() {
+		struct atem_posix_ctx posix_client;
+		int server_sock = atem_posix_client_connect(&posix_client);
+		uint16_t session_id = atem_posix_client_handshake(server_sock, &posix_client);
+
+		// Iterates all commands in batch without any further packets arriving
+		uint8_t payload[4] = {0};
+		for (uint16_t remote_id = 1; remote_id <= 3; remote_id++) {
+			atem_command_send(server_sock, session_id, remote_id, "Test", payload, sizeof(payload));
+		}
+		assert(simple_socket_poll(posix_client.sock, 1000) == 1);
+		for (int i = 0; i < 3; i++) {
+			assert(atem_next(&posix_client) == ATEM_CMDNAME('T', 'e', 's', 't'));
+		}
+
+		// Expects cumulative acknowledgement to be sent before the connection is dropped from waiting for more packets
+		assert(atem_next(&posix_client) == ATEM_POSIX_STATUS_DROPPED);
+		atem_acknowledge_response_recv_verify(server_sock, session_id, 0x0003);
+
+		atem_socket_close(server_sock);
+		atem_socket_close(posix_client.sock);
+	}
+
+	// Ensures missing packet in a batch is requested and packets in sequence are acknowledged after the batch
+	RUN_TEST() {
+		struct atem_posix_ctx posix_client;
+		int server_sock = atem_posix_client_connect(&posix_client);
+		uint16_t session_id = atem_posix_client_handshake(server_sock, &posix_client);
+
+		// Sends batch with a missing packet
+		uint8_t payload[4] = {0};
+		atem_command_send(server_sock, session_id, 0x0001, "Test", payload, sizeof(payload));
+		atem_command_send(server_sock, session_id, 0x0003, "Test", payload, sizeof(payload));
+		assert(simple_socket_poll(posix_client.sock, 1000) == 1);
+		assert(batch_read(&posix_client) == 1);
+
+		// Expects retransmit request for missing packet before cumulative acknowledgement
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		atem_socket_recv(server_sock, packet);
+		atem_header_flags_get_verify(packet, ATEM_FLAG_RETXREQ, 0);
+		atem_header_sessionid_get_verify(packet, session_id);
+		atem_acknowledge_response_recv_verify(server_sock, session_id, 0x0001);
+
+		// Acknowledges retransmitted packets in next batch
+		atem_command_send(server_sock, session_id, 0x0002, "Test", payload, sizeof(payload));
+		atem_command_send(server_sock, session_id, 0x0003, "Test", payload, sizeof(payload));
+		assert(simple_socket_poll(posix_client.sock, 1000) == 1);
+		assert(batch_read(&posix_client) == 2);
+		atem_acknowledge_response_recv_verify(server_sock, session_id, 0x0003);
+
+		atem_socket_close(server_sock);
+		atem_socket_close(posix_client.sock);
+	}
+
+	return runner_exit();
+}
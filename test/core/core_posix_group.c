@@ -0,0 +1,128 @@
+#include <assert.h> // assert
+#include <stdint.h> // uint8_t, uint16_t, int32_t
+#include <stdbool.h> // bool, true, false
+#include <stddef.h> // NULL
+#include <string.h> // memcmp
+
+#include <arpa/inet.h> // htonl
+#include <netinet/in.h> // INADDR_LOOPBACK, struct sockaddr_in
+#include <sys/socket.h> // socklen_t, struct sockaddr, getsockname, recvfrom, sendto
+
+#include "../utils/utils.h"
+#include "../../core/atem_posix_group.h" // struct atem_posix_group, struct atem_posix_group_ctx, atem_group_init, atem_group_add, atem_group_next, atem_group_close
+
+// Receives packet on server socket from any client and gets its address
+static struct sockaddr_in atem_group_server_recv(int sock, uint8_t* packet) {
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof(addr);
+	assert(recvfrom(sock, packet, ATEM_PACKET_LEN_MAX, 0, (struct sockaddr*)&addr, &addr_len) >= ATEM_LEN_HEADER);
+	return addr;
+}
+
+// Sends packet from server socket to client address
+static void atem_group_server_send(int sock, uint8_t* packet, struct sockaddr_in addr) {
+	const uint16_t len = atem_header_len_get(packet);
+	assert(sendto(sock, packet, len, 0, (struct sockaddr*)&addr, sizeof(addr)) == len);
+}
+
+// Gets port the connection context sends from
+static uint16_t atem_group_ctx_port(struct atem_posix_group_ctx* ctx) {
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof(addr);
+	assert(getsockname(ctx->posix.sock, (struct sockaddr*)&addr, &addr_len) == 0);
+	return addr.sin_port;
+}
+
+int main(void) {
+	// Ensures commands and acknowledgements are routed to the connection they belong to
+	RUN_TEST() {
+		int server_sock = atem_socket_create();
+		simple_socket_listen(server_sock, ATEM_PORT);
+
+		struct atem_posix_group group;
+		struct atem_posix_group_ctx ctxs[2];
+		assert(atem_group_init(&group));
+		assert(atem_group_add(&group, &ctxs[0], htonl(INADDR_LOOPBACK)));
+		assert(atem_group_add(&group, &ctxs[1], htonl(INADDR_LOOPBACK)));
+
+		// Accepts opening handshakes from both connections with unique session ids
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		struct sockaddr_in addrs[2];
+		for (int i = 0; i < 2; i++) {
+			struct sockaddr_in addr = atem_group_server_recv(server_sock, packet);
+			const uint16_t session_id = atem_handshake_sessionid_get(packet, ATEM_OPCODE_OPEN, false);
+			const int index = (addr.sin_port == atem_group_ctx_port(&ctxs[0])) ? 0 : 1;
+			assert(addr.sin_port == atem_group_ctx_port(&ctxs[index]));
+			addrs[index] = addr;
+			atem_packet_clear(packet);
+			atem_handshake_sessionid_set(packet, ATEM_OPCODE_ACCEPT, false, session_id);
+			atem_handshake_newsessionid_set(packet, (uint16_t)(0x0001 + index));
+			atem_group_server_send(server_sock, packet, addr);
+		}
+		for (int i = 0; i < 2; i++) {
+			struct atem_posix_group_ctx* ctx;
+			assert(atem_group_next(&group, &ctx) == ATEM_POSIX_STATUS_ACCEPTED);
+			atem_group_server_recv(server_sock, packet);
+		}
+
+		// Sends a packet with a unique command to each connection
+		for (int i = 0; i < 2; i++) {
+			atem_packet_clear(packet);
+			atem_acknowledge_request_set(packet, (uint16_t)(0x8001 + i), 0x0001);
+			atem_command_append(packet, (i == 0) ? "CTX0" : "CTX1", "data", 4);
+			atem_group_server_send(server_sock, packet, addrs[i]);
+		}
+
+		// Gets each command from the connection it was sent to
+		bool received[2] = { false, false };
+		for (int i = 0; i < 2; i++) {
+			struct atem_posix_group_ctx* ctx;
+			const int32_t cmd = atem_group_next(&group, &ctx);
+			const int index = (ctx == &ctxs[0]) ? 0 : 1;
+			assert(ctx == &ctxs[index]);
+			assert(cmd == (int32_t)ATEM_CMDNAME('C', 'T', 'X', '0' + index));
+			assert(memcmp(ctx->posix.atem.cmd_payload_buf, "data", 4) == 0);
+			received[index] = true;
+		}
+		assert(received[0] && received[1]);
+
+		// Ensures both connections acknowledged their packet with their own session id
+		for (int i = 0; i < 2; i++) {
+			struct sockaddr_in addr = atem_group_server_recv(server_sock, packet);
+			const int index = (addr.sin_port == addrs[0].sin_port) ? 0 : 1;
+			atem_acknowledge_response_get_verify(packet, (uint16_t)(0x8001 + index), 0x0001);
+		}
+
+		atem_group_close(&group);
+		atem_socket_close(server_sock);
+	}
+
+	// Ensures unanswered connections are reconnected with backoff by the group
+	RUN_TEST() {
+		int server_sock = atem_socket_create();
+		simple_socket_listen(server_sock, ATEM_PORT);
+
+		struct atem_posix_group group;
+		struct atem_posix_group_ctx ctx;
+		assert(atem_group_init(&group));
+		struct timespec start = timediff_mark();
+		assert(atem_group_add(&group, &ctx, htonl(INADDR_LOOPBACK)));
+
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		atem_group_server_recv(server_sock, packet);
+		atem_header_flags_get_verify(packet, ATEM_FLAG_SYN, 0);
+
+		// Drops connection after first reconnect delay and resends opening handshake
+		struct atem_posix_group_ctx* ctx_dropped;
+		assert(atem_group_next(&group, &ctx_dropped) == ATEM_POSIX_STATUS_DROPPED);
+		assert(ctx_dropped == &ctx);
+		assert(timediff_get(start) <= ATEM_RECONNECT_DELAY_MS + TIMEDIFF_LATE);
+		atem_group_server_recv(server_sock, packet);
+		atem_header_flags_get_verify(packet, ATEM_FLAG_SYN | ATEM_FLAG_RETX, 0);
+
+		atem_group_close(&group);
+		atem_socket_close(server_sock);
+	}
+
+	return runner_exit();
+}
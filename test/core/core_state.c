@@ -0,0 +1,180 @@
+#include <assert.h> // assert
+#include <stdint.h> // uint8_t, uint16_t
+#include <stddef.h> // NULL
+
+#include "../utils/utils.h"
+#include "../../core/atem_state.h" // struct atem_state, atem_state_init, atem_state_update, atem_state_dirty_take, atem_state_cc_get, ATEM_STATE_CMD_FILTER, ATEM_STATE_CC_ENTRIES, ATEM_STATE_SOURCE_UNKNOWN, ATEM_STATE_DIRTY_VERSION, ATEM_STATE_DIRTY_TALLY, ATEM_STATE_DIRTY_PROGRAM, ATEM_STATE_DIRTY_PREVIEW, ATEM_STATE_DIRTY_CC
+
+// Parses packet and updates state from all commands in it, returning number of commands changing the state
+static int state_packet_update(struct atem_state* state, struct atem* atem) {
+	assert(atem_parse(atem) == ATEM_STATUS_WRITE);
+	int updated = 0;
+	while (atem_cmd_available(atem)) {
+		const uint32_t name = atem_cmd_next(atem);
+		updated += atem_state_update(state, atem, name);
+	}
+	return updated;
+}
+
+int main(void) {
+	// Ensures state is unknown before anything is received
+	RUN_TEST() {
+		static struct atem_state state;
+		atem_state_init(&state);
+		assert(state.protocol_major == 0 && state.protocol_minor == 0);
+		assert(state.program[0] == ATEM_STATE_SOURCE_UNKNOWN);
+		assert(state.preview[0] == ATEM_STATE_SOURCE_UNKNOWN);
+		assert(!atem_tally_pgm(&state.tally, 1));
+		assert(atem_state_cc_get(&state, 1, 0x01, 0x02) == NULL);
+		assert(atem_state_dirty_take(&state) == 0);
+	}
+
+	// Ensures state is updated incrementally from commands with dirty flags for changed parts only
+	RUN_TEST() {
+		static struct atem_state state;
+		struct atem atem = {0};
+		atem.cmd_filter = ATEM_STATE_CMD_FILTER;
+		atem_state_init(&state);
+
+		// Updates state from initial state dump
+		uint8_t version[] = { 0x00, 0x02, 0x00, 0x1e };
+		uint8_t tally[] = { 0x00, 0x03, 0x01, 0x02, 0x00 };
+		uint8_t program[] = { 0x00, 0x00, 0x00, 0x01 };
+		uint8_t preview[] = { 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00 };
+		uint8_t cc[24] = { 2, 0x01, 0x02, 0x80, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00 };
+		cc[16] = 0x12;
+		cc[17] = 0x34;
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "_ver", version, sizeof(version));
+		atem_command_append(atem.read_buf, "_pin", "test", 4);
+		atem_command_append(atem.read_buf, "TlIn", tally, sizeof(tally));
+		atem_command_append(atem.read_buf, "PrgI", program, sizeof(program));
+		atem_command_append(atem.read_buf, "PrvI", preview, sizeof(preview));
+		atem_command_append(atem.read_buf, "CCdP", cc, sizeof(cc));
+		assert(state_packet_update(&state, &atem) == 5);
+		assert(atem_state_dirty_take(&state) == (ATEM_STATE_DIRTY_VERSION | ATEM_STATE_DIRTY_TALLY | ATEM_STATE_DIRTY_PROGRAM | ATEM_STATE_DIRTY_PREVIEW | ATEM_STATE_DIRTY_CC));
+		assert(atem_state_dirty_take(&state) == 0);
+		assert(state.protocol_major == 2 && state.protocol_minor == 30);
+		assert(atem_tally_pgm(&state.tally, 1) && atem_tally_pvw(&state.tally, 2));
+		assert(state.program[0] == 1 && state.preview[0] == 2);
+		assert(state.program[1] == ATEM_STATE_SOURCE_UNKNOWN);
+		assert(state.cc_dirty == 0x02);
+		const struct atem_cc_cache_entry* entry = atem_state_cc_get(&state, 2, 0x01, 0x02);
+		assert(entry != NULL && entry->len == 2 && entry->value[0] == 0x12 && entry->value[1] == 0x34);
+		assert(atem_state_cc_get(&state, 1, 0x01, 0x02) == NULL);
+
+		// Only reports program change when switcher resends unchanged state
+		uint8_t program_cut[] = { 0x00, 0x00, 0x00, 0x02 };
+		state.cc_dirty = 0;
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0002);
+		atem_command_append(atem.read_buf, "_ver", version, sizeof(version));
+		atem_command_append(atem.read_buf, "TlIn", tally, sizeof(tally));
+		atem_command_append(atem.read_buf, "PrgI", program_cut, sizeof(program_cut));
+		atem_command_append(atem.read_buf, "PrvI", preview, sizeof(preview));
+		atem_command_append(atem.read_buf, "CCdP", cc, sizeof(cc));
+		assert(state_packet_update(&state, &atem) == 1);
+		assert(atem_state_dirty_take(&state) == ATEM_STATE_DIRTY_PROGRAM);
+		assert(state.program[0] == 2);
+		assert(state.cc_dirty == 0);
+	}
+
+	// Ensures camera control values are kept for all parameters, including ones sharing a camera control cache slot
+	RUN_TEST() {
+		static struct atem_state state;
+		struct atem atem = {0};
+		atem_state_init(&state);
+
+		// Finds parameter sharing cache slot with first lens parameter
+		uint8_t parameter = 0;
+		while (atem_cc_cache_slot(0x01, parameter) != atem_cc_cache_slot(0x00, 0x00)) {
+			parameter++;
+			assert(parameter < UINT8_MAX);
+		}
+
+		// Reads back both values after assigning them
+		uint8_t cc_lens[24] = { 1, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x01 };
+		cc_lens[16] = 0x01;
+		cc_lens[17] = 0x00;
+		uint8_t cc_video[24] = { 1, 0x01, parameter, 0x01, 0x00, 0x01 };
+		cc_video[16] = 0x05;
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "CCdP", cc_lens, sizeof(cc_lens));
+		atem_command_append(atem.read_buf, "CCdP", cc_video, sizeof(cc_video));
+		assert(state_packet_update(&state, &atem) == 2);
+		const struct atem_cc_cache_entry* lens = atem_state_cc_get(&state, 1, 0x00, 0x00);
+		const struct atem_cc_cache_entry* video = atem_state_cc_get(&state, 1, 0x01, parameter);
+		assert(lens != NULL && lens->len == 2 && lens->value[0] == 0x01 && lens->value[1] == 0x00);
+		assert(video != NULL && video->len == 1 && video->value[0] == 0x05);
+
+		// Applies relative offsets to known values and keeps values when triggered
+		uint8_t cc_offset[24] = { 1, 0x00, 0x00, 0x80, 0x01, 0x00, 0x00, 0x01 };
+		cc_offset[16] = 0xff;
+		cc_offset[17] = 0xff;
+		uint8_t cc_trigger[24] = { 1, 0x01, parameter, 0x00, 0x00 };
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0002);
+		atem_command_append(atem.read_buf, "CCdP", cc_offset, sizeof(cc_offset));
+		atem_command_append(atem.read_buf, "CCdP", cc_trigger, sizeof(cc_trigger));
+		assert(state_packet_update(&state, &atem) == 1);
+		assert(lens->len == 2 && lens->value[0] == 0x00 && lens->value[1] == 0xff);
+		assert(video->len == 1 && video->value[0] == 0x05);
+	}
+
+	// Ensures camera control values stop being tracked for new parameters when table is full while known values are kept
+	RUN_TEST() {
+		static struct atem_state state;
+		struct atem atem = {0};
+		atem_state_init(&state);
+
+		// Assigns values to new parameters until they are no longer tracked
+		uint16_t count = 0;
+		uint8_t cc[24] = { 1, 0x00, 0x00, 0x01, 0x00, 0x01 };
+		while (1) {
+			cc[1] = (uint8_t)(count >> 8);
+			cc[2] = (uint8_t)(count & 0xff);
+			cc[16] = (uint8_t)(count & 0xff);
+			atem_packet_clear(atem.read_buf);
+			atem_acknowledge_request_set(atem.read_buf, 0x0001, (uint16_t)(count + 1));
+			atem_command_append(atem.read_buf, "CCdP", cc, sizeof(cc));
+			if (state_packet_update(&state, &atem) == 0) break;
+			count++;
+			assert(count <= ATEM_STATE_CC_ENTRIES);
+		}
+		assert(count == ATEM_STATE_CC_ENTRIES * 3 / 4);
+		assert(atem_state_cc_get(&state, 1, (uint8_t)(count >> 8), (uint8_t)(count & 0xff)) == NULL);
+
+		// Reads back all tracked values
+		for (uint16_t i = 0; i < count; i++) {
+			const struct atem_cc_cache_entry* entry = atem_state_cc_get(&state, 1, (uint8_t)(i >> 8), (uint8_t)(i & 0xff));
+			assert(entry != NULL && entry->len == 1 && entry->value[0] == (uint8_t)(i & 0xff));
+		}
+
+		// Updates known values when table is full
+		cc[1] = 0x00;
+		cc[2] = 0x00;
+		cc[16] = 0xaa;
+		atem_packet_clear(atem.read_buf);
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, (uint16_t)(count + 2));
+		atem_command_append(atem.read_buf, "CCdP", cc, sizeof(cc));
+		assert(state_packet_update(&state, &atem) == 1);
+		assert(atem_state_cc_get(&state, 1, 0x00, 0x00)->value[0] == 0xaa);
+	}
+
+	// Ensures commands outside tracked range or too short are ignored
+	RUN_TEST() {
+		static struct atem_state state;
+		struct atem atem = {0};
+		atem_state_init(&state);
+		uint8_t program[] = { ATEM_STATE_ME_MAX, 0x00, 0x00, 0x01 };
+		uint8_t cc[24] = { ATEM_STATE_CAMERAS_MAX + 1, 0x01, 0x02, 0x01, 0x00, 0x01 };
+		atem_acknowledge_request_set(atem.read_buf, 0x0001, 0x0001);
+		atem_command_append(atem.read_buf, "PrgI", program, sizeof(program));
+		atem_command_append(atem.read_buf, "PrvI", "ab", 2);
+		atem_command_append(atem.read_buf, "CCdP", cc, sizeof(cc));
+		assert(state_packet_update(&state, &atem) == 0);
+		assert(atem_state_dirty_take(&state) == 0);
+	}
+
+	return runner_exit();
+}
@@ -82,6 +82,7 @@ int main(void) {
 
 	// Runs ATEM tests
 	atem_server();
+	atem_server_storm();
 
 	if (path != NULL) {
 		assert(proxy_background_pid > 0);
@@ -0,0 +1,240 @@
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, uint64_t
+#include <stdbool.h> // bool, true, false
+#include <stddef.h> // NULL, size_t
+#include <stdio.h> // FILE, fprintf, stderr, printf, stdout, perror, fclose
+#include <stdlib.h> // abort, getenv, strtod
+#include <string.h> // strcmp
+#include <time.h> // clock_gettime, CLOCK_MONOTONIC, struct timespec
+
+#include <sys/socket.h> // recv, MSG_DONTWAIT
+#include <netinet/in.h> // struct sockaddr_in
+#include <poll.h> // poll, struct pollfd, POLLIN
+
+#include "./utils/utils.h"
+#include "../core/atem_capture.h" // struct atem_capture_record, enum atem_capture_role, enum atem_capture_dir, atem_capture_load, atem_capture_read
+
+// Maximum number of clients from a capture that can be replayed into a server
+#define REPLAY_PEERS_MAX 64
+
+// Connection replaying captured packets
+struct replay_peer {
+	// Address of peer in capture
+	struct sockaddr_in addr;
+	// Socket connected to client or server being replayed into
+	int sock;
+	// Session id assigned by server in capture
+	uint16_t session_id_captured;
+	// Session id assigned by server being replayed into, 0 until assigned
+	uint16_t session_id;
+};
+
+// Gets nanoseconds from monotonic clock
+static uint64_t replay_time_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// Gets replay speed multiplier from environment variable, 0 replays as fast as possible
+static double replay_speed_get(void) {
+	const char* env_value = getenv("REPLAY_SPEED");
+	if (env_value == NULL) {
+		return 1.0;
+	}
+	char* end;
+	double speed = strtod(env_value, &end);
+	if (*end != '\0' || end == env_value || speed < 0.0) {
+		fprintf(stderr, "Invalid REPLAY_SPEED value: %s\n", env_value);
+		abort();
+	}
+	return speed;
+}
+
+// Gets if capture should be replayed into a client, defaults to the same side as the capture was recorded on
+static bool replay_target_client_get(enum atem_capture_role role) {
+	const char* env_value = getenv("REPLAY_TARGET");
+	if (env_value == NULL) {
+		return role == ATEM_CAPTURE_ROLE_CLIENT;
+	}
+	if (!strcmp(env_value, "client")) {
+		return true;
+	}
+	if (!strcmp(env_value, "server")) {
+		return false;
+	}
+	fprintf(stderr, "Invalid REPLAY_TARGET value: %s\n", env_value);
+	abort();
+}
+
+// Checks if captured peer addresses are the same
+static bool replay_addr_equal(struct sockaddr_in* a, struct sockaddr_in* b) {
+	return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+// Receives all available packets from target, tracking session ids assigned by server
+static void replay_drain(struct replay_peer* peers, size_t peers_len, int timeout) {
+	struct pollfd fds[REPLAY_PEERS_MAX];
+	for (size_t i = 0; i < peers_len; i++) {
+		fds[i].fd = peers[i].sock;
+		fds[i].events = POLLIN;
+	}
+	if (poll(fds, (nfds_t)peers_len, timeout) == -1) {
+		perror("Failed to poll replay sockets");
+		abort();
+	}
+
+	for (size_t i = 0; i < peers_len; i++) {
+		if (!(fds[i].revents & POLLIN)) continue;
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		ssize_t recved;
+		while ((recved = recv(peers[i].sock, packet, sizeof(packet), MSG_DONTWAIT)) >= ATEM_LEN_SYN) {
+			if (logs_find("atem_recv")) {
+				printf("Received packet:\n");
+				logs_print_buffer(stdout, packet, (size_t)recved);
+			}
+			if (
+				(atem_header_flags_get(packet) & ATEM_FLAG_SYN) &&
+				atem_handshake_opcode_get(packet) == ATEM_OPCODE_ACCEPT
+			) {
+				peers[i].session_id = atem_handshake_newsessionid_get(packet) | 0x8000;
+			}
+		}
+	}
+}
+
+// Waits until captured packet is due at replay speed while receiving packets from target
+static void replay_wait(struct replay_peer* peers, size_t peers_len, uint64_t due) {
+	uint64_t now;
+	while ((now = replay_time_ns()) < due) {
+		replay_drain(peers, peers_len, (int)((due - now + 999999) / 1000000));
+	}
+	replay_drain(peers, peers_len, 0);
+}
+
+// Sends captured packet to target
+static void replay_send(struct replay_peer* peer, struct atem_capture_record* record) {
+	if (logs_find("atem_send")) {
+		printf("Sending packet:\n");
+		logs_print_buffer(stdout, record->buf, record->len);
+	}
+	simple_socket_send(peer->sock, record->buf, record->len);
+}
+
+int main(void) {
+	// Loads capture file
+	const char* path = getenv("REPLAY_FILE");
+	if (path == NULL) {
+		fprintf(stderr, "Environment variable REPLAY_FILE not defined\n");
+		abort();
+	}
+	enum atem_capture_role role;
+	FILE* capture = atem_capture_load(path, &role);
+	if (capture == NULL) {
+		fprintf(stderr, "Failed to load capture file: %s\n", path);
+		abort();
+	}
+	const double speed = replay_speed_get();
+	const bool target_client = replay_target_client_get(role);
+
+	// Direction of packets sent by the server as recorded in the capture
+	const enum atem_capture_dir dir_server = (role == ATEM_CAPTURE_ROLE_CLIENT) ? ATEM_CAPTURE_DIR_RECV : ATEM_CAPTURE_DIR_SEND;
+
+	struct replay_peer peers[REPLAY_PEERS_MAX];
+	size_t peers_len = 0;
+	uint16_t session_id_client = 0;
+
+	// Awaits client to replay server packets to
+	if (target_client) {
+		uint8_t packet[ATEM_PACKET_LEN_MAX];
+		peers[0].sock = atem_socket_create();
+		atem_socket_listen(peers[0].sock, packet);
+		session_id_client = atem_header_sessionid_get(packet);
+	}
+
+	// Replays captured packets with the same timing as they were recorded with
+	static struct atem_capture_record record;
+	uint64_t capture_start = 0;
+	uint64_t replay_start = 0;
+	uint32_t replayed = 0;
+	while (atem_capture_read(capture, &record)) {
+		if (record.len < ATEM_LEN_HEADER) continue;
+		const bool from_server = record.dir == dir_server;
+		const bool syn = atem_header_flags_get(record.buf) & ATEM_FLAG_SYN;
+
+		// Gets connection captured packet belongs to
+		struct replay_peer* peer = NULL;
+		for (size_t i = 0; i < peers_len; i++) {
+			if (replay_addr_equal(&peers[i].addr, &record.peer)) {
+				peer = &peers[i];
+				break;
+			}
+		}
+		if (peer == NULL) {
+			// Only replays the first session from the capture into a client
+			if (target_client && (peers_len > 0 || !from_server)) continue;
+			if (peers_len >= REPLAY_PEERS_MAX) {
+				fprintf(stderr, "Capture has more than %d clients\n", REPLAY_PEERS_MAX);
+				abort();
+			}
+			peer = &peers[peers_len++];
+			peer->addr = record.peer;
+			peer->session_id_captured = 0;
+			peer->session_id = 0;
+			if (!target_client) {
+				peer->sock = atem_socket_create();
+				atem_socket_connect(peer->sock);
+			}
+		}
+
+		// Maps server assigned session id from capture to the one assigned by server being replayed into
+		if (from_server && syn && atem_handshake_opcode_get(record.buf) == ATEM_OPCODE_ACCEPT) {
+			peer->session_id_captured = atem_handshake_newsessionid_get(record.buf) | 0x8000;
+		}
+
+		// Only replays packets sent to the target
+		if (from_server != target_client) continue;
+
+		// Waits until packet is due at replay speed
+		if (replayed == 0) {
+			capture_start = record.time;
+			replay_start = replay_time_ns();
+		}
+		if (speed > 0.0) {
+			replay_wait(peers, peers_len, replay_start + (uint64_t)((double)(record.time - capture_start) / speed));
+		}
+		else {
+			replay_drain(peers, peers_len, 0);
+		}
+
+		// Uses session id from client for opening handshake
+		if (target_client && syn) {
+			atem_header_sessionid_set(record.buf, session_id_client);
+		}
+		// Awaits new session id from server when replaying opening handshake
+		else if (!target_client && syn && atem_handshake_opcode_get(record.buf) == ATEM_OPCODE_OPEN) {
+			peer->session_id = 0;
+		}
+		// Uses session id assigned by server being replayed into instead of the captured one
+		else if (!target_client && peer->session_id_captured != 0 && atem_header_sessionid_get(record.buf) == peer->session_id_captured) {
+			const uint64_t timeout = replay_time_ns() + (uint64_t)ATEM_TIMEOUT_MS * 1000000;
+			while (peer->session_id == 0 && replay_time_ns() < timeout) {
+				replay_drain(peers, peers_len, 1);
+			}
+			if (peer->session_id == 0) continue;
+			atem_header_sessionid_set(record.buf, peer->session_id);
+		}
+
+		replay_send(peer, &record);
+		replayed++;
+	}
+
+	// Prints replay summary
+	const double elapsed = (double)(replay_time_ns() - replay_start) / 1e6;
+	printf("Replayed %u packets to %zu %s in %.0f ms\n", replayed, peers_len, target_client ? "client" : "server connections", elapsed);
+
+	for (size_t i = 0; i < peers_len; i++) {
+		atem_socket_close(peers[i].sock);
+	}
+	fclose(capture);
+	return 0;
+}
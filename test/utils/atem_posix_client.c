@@ -0,0 +1,46 @@
+#include <stdint.h> // uint8_t, uint16_t
+#include <stdbool.h> // false
+#include <assert.h> // assert
+
+#include <arpa/inet.h> // htonl
+#include <netinet/in.h> // INADDR_LOOPBACK
+#include <sys/socket.h> // socklen_t, struct sockaddr, getsockname, connect
+
+#include "../../core/atem_protocol.h" // ATEM_OPCODE_OPEN, ATEM_OPCODE_ACCEPT
+#include "../../core/atem.h" // ATEM_PACKET_LEN_MAX, ATEM_PORT
+#include "../../core/atem_posix.h" // struct atem_posix_ctx, atem_init, atem_send, atem_poll, ATEM_POSIX_STATUS_ACCEPTED
+#include "./atem_sock.h" // atem_socket_create, atem_socket_recv
+#include "./simple_socket.h" // simple_socket_listen
+#include "./atem_header.h" // atem_header_sessionid_get, atem_header_sessionid_rand
+#include "./atem_handshake.h" // atem_handshake_opcode_get_verify, atem_handshake_newsessionid_send
+#include "./atem_acknowledge.h" // atem_acknowledge_response_recv_verify
+#include "./atem_posix_client.h"
+
+
+
+// Initializes POSIX client on loopback and returns server socket connected to it
+int atem_posix_client_connect(struct atem_posix_ctx* posix_client) {
+	int server_sock = atem_socket_create();
+	simple_socket_listen(server_sock, ATEM_PORT);
+	assert(atem_init(posix_client, htonl(INADDR_LOOPBACK)));
+
+	struct sockaddr addr;
+	socklen_t addrlen = sizeof(addr);
+	assert(getsockname(posix_client->sock, &addr, &addrlen) == 0);
+	assert(connect(server_sock, &addr, addrlen) == 0);
+	return server_sock;
+}
+
+// Completes opening handshake from server side with POSIX client and returns session id
+uint16_t atem_posix_client_handshake(int server_sock, struct atem_posix_ctx* posix_client) {
+	uint8_t packet[ATEM_PACKET_LEN_MAX];
+	assert(atem_send(posix_client));
+	atem_socket_recv(server_sock, packet);
+	atem_handshake_opcode_get_verify(packet, ATEM_OPCODE_OPEN);
+	uint16_t session_id = atem_header_sessionid_get(packet);
+	uint16_t session_id_new = atem_header_sessionid_rand(false);
+	atem_handshake_newsessionid_send(server_sock, ATEM_OPCODE_ACCEPT, false, session_id, session_id_new);
+	assert(atem_poll(posix_client) == ATEM_POSIX_STATUS_ACCEPTED);
+	atem_acknowledge_response_recv_verify(server_sock, session_id, 0x0000);
+	return session_id_new | 0x8000;
+}
@@ -0,0 +1,12 @@
+// Include guard
+#ifndef ATEM_POSIX_CLIENT_H
+#define ATEM_POSIX_CLIENT_H
+
+#include <stdint.h> // uint16_t
+
+#include "../../core/atem_posix.h" // struct atem_posix_ctx
+
+int atem_posix_client_connect(struct atem_posix_ctx* posix_client);
+uint16_t atem_posix_client_handshake(int server_sock, struct atem_posix_ctx* posix_client);
+
+#endif // ATEM_POSIX_CLIENT_H
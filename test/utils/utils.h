@@ -14,6 +14,7 @@
 #include "./runner.h"
 #include "./timediff.h"
 #include "./simple_socket.h"
+#include "./atem_posix_client.h"
 #include "../http/http_sock.h"
 
 #include "../atem_client/atem_client.h"